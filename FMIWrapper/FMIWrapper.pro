@@ -51,11 +51,26 @@ SOURCES += main.cpp \
     cvode-2.9.0/src/cvode/cvode_direct.c \
     cvode-2.9.0/src/sundials/sundials_direct.c \
     cvode-2.9.0/src/sundials/sundials_dense.c \
+    cvode-2.9.0/src/sundials/sundials_band.c \
+    cvode-2.9.0/src/sundials/sundials_iterative.c \
+    cvode-2.9.0/src/sundials/sundials_spgmr.c \
+    cvode-2.9.0/src/sundials/sundials_spbcgs.c \
+    cvode-2.9.0/src/sundials/sundials_sptfqmr.c \
     cvode-2.9.0/src/cvode/cvode_io.c \
+    cvode-2.9.0/src/cvode/cvode_spils.c \
+    cvode-2.9.0/src/cvode/cvode_spgmr.c \
+    cvode-2.9.0/src/cvode/cvode_spbcgs.c \
+    cvode-2.9.0/src/cvode/cvode_sptfqmr.c \
+    cvode-2.9.0/src/cvode/cvode_bandpre.c \
     ida-2.9.0/src/ida/ida.c \
     ida-2.9.0/src/ida/ida_dense.c \
     ida-2.9.0/src/ida/ida_direct.c \
     ida-2.9.0/src/ida/ida_io.c \
+    ida-2.9.0/src/ida/ida_spils.c \
+    ida-2.9.0/src/ida/ida_spgmr.c \
+    ida-2.9.0/src/ida/ida_spbcgs.c \
+    ida-2.9.0/src/ida/ida_sptfqmr.c \
+    ida-2.9.0/src/ida/ida_bbdpre.c \
     ../common/TLMInterface1D.cc \
     ../common/TLMInterface3D.cc \
     ../common/TLMInterfaceSignal.cc \
@@ -14,6 +14,9 @@
 #include <vector>
 #include <fstream>
 #include <map>
+#include <cmath>
+#include <algorithm>
+#include <cctype>
 #include <RegEx.h>
 
 #define Ith(v,i)    NV_Ith_S(v,i-1)       /* Ith numbers components 1..NEQ */
@@ -25,8 +28,17 @@
 #include "sundials/sundials_dense.h" /* definitions DlsMat DENSE_ELEM */
 #include "sundials/sundials_types.h" /* definition of type realtype */
 
+#include "cvode/cvode_spgmr.h"       /* prototypes for the Krylov linear solvers */
+#include "cvode/cvode_spbcgs.h"
+#include "cvode/cvode_sptfqmr.h"
+#include "cvode/cvode_bandpre.h"     /* banded preconditioner */
+
 #include "ida/ida.h"
 #include "ida/ida_dense.h"
+#include "ida/ida_spgmr.h"
+#include "ida/ida_spbcgs.h"
+#include "ida/ida_sptfqmr.h"
+#include "ida/ida_bbdpre.h"
 #include "nvector/nvector_serial.h"
 #include "sundials/sundials_math.h"
 #include "sundials/sundials_types.h"
@@ -36,10 +48,14 @@
 // TLMPlugin includes
 #include "Plugin/TLMPlugin.h"
 #include "Logging/TLMErrorLog.h"
+#include "Logging/TLMCompressedStream.h"
 #include "common.h"
 
 using namespace std;
 
+// Kind of a TLM interface, resolved from dimensions and causality in fmi.config
+enum interface_t { Interface3D, Interface1D, SignalInput, SignalOutput, Unsupported };
+
 // FMI config data
 struct fmiConfig_t {
   size_t nSubSteps;
@@ -55,6 +71,19 @@ struct fmiConfig_t {
   std::vector<fmi2ValueReference*> ang_speed_vr;
   std::vector<fmi2ValueReference*> force_vr;
   std::vector<fmi2ValueReference*> value_vr;
+
+  // Resolved by compileValueReferences()
+  std::vector<interface_t> kinds;
+  std::vector<double> forceSign;
+  std::vector<double> impedanceSign;    // d(force written to the FMU)/d(speed) divided by the impedance
+
+  // Value references of all FMU variables read for the interfaces (motion
+  // and output values) and written for them (forces and input values),
+  // concatenated in interface order, with the offset of each interface.
+  std::vector<fmi2ValueReference> output_vr;
+  std::vector<fmi2ValueReference> input_vr;
+  std::vector<size_t> output_offset;
+  std::vector<size_t> input_offset;
 };
 
 // TLM config data
@@ -68,18 +97,26 @@ struct tlmConfig_t {
 
 enum solver_t { ExplicitEuler, RungeKutta, CVODE, IDA };
 
+// Linear solver in the Newton iteration of CVODE and IDA
+enum linsolver_t { Dense, SPGMR, SPBCGS, SPTFQMR };
+
 struct simConfig_t {
   solver_t solver;
+  linsolver_t linsolver = Dense;
+  int bandwidth = 0;        // Half-bandwidth of the Krylov preconditioner, 0 for none
   double reltol;
   std::vector<double> abstol;
   int logLevel;
   std::string variableFilter = ".*";
+  bool compressLog = false;
+  bool asyncLog = false;    // Write the debug log from a background thread
 };
 
 static const char* TEMP_DIR_NAME = "temp";
 static const char* TLM_CONFIG_FILE_NAME = "tlm.config";
 static const char* FMI_CONFIG_FILE_NAME = "fmi.config";
 static const char* LOG_FILE_NAME = "logdata.csv";
+static const char* COMPRESSED_LOG_FILE_NAME = "logdata.csv.gz";
 
 static TLMPlugin* plugin;
 static size_t n_states = 0;
@@ -90,6 +127,29 @@ static fmi2Real* states_abstol = 0;
 static fmi2Real* states_der = 0;
 static fmiHandle* fmu = 0;
 
+// Values of fmiConfig.output_vr and fmiConfig.input_vr
+static std::vector<fmi2Real> output_values;
+static std::vector<fmi2Real> input_values;
+
+// Value references of the states and state derivatives for the analytic
+// Jacobian, empty if it is computed by finite differences
+static std::vector<fmi2ValueReference> states_vr;
+static std::vector<fmi2ValueReference> states_der_vr;
+
+// Inputs of TLM interfaces that depend on outputs through the impedance,
+// and the unknowns of the Jacobian: the state derivatives followed by these
+// outputs
+static std::vector<fmi2ValueReference> coupled_input_vr;
+static std::vector<fmi2ValueReference> jacobian_unknown_vr;
+
+// Point (time and states[]) where rhs last set the FMU and wrote the forces,
+// and the interface gains of the analytic Jacobian at gain_time
+static bool eval_point_valid = false;
+static realtype eval_point_time = 0.0;
+static bool gain_valid = false;
+static realtype gain_time = 0.0;
+static std::vector<double> gain_cache;
+
 static fmiConfig_t fmiConfig = fmiConfig_t();
 static tlmConfig_t tlmConfig = tlmConfig_t();
 static simConfig_t simConfig = simConfig_t();
@@ -97,7 +157,9 @@ static simConfig_t simConfig = simConfig_t();
 static std::map<fmi2ValueReference,std::string> parameterMap;
 
 static std::vector<fmi2ValueReference> logVariables;
-static std::ofstream logStream;
+static std::ofstream logFileStream;
+static TLMCompressedOStream compressedLogStream;
+static std::ostream* logStream = 0;
 bool logStreamOpen = false;
 
 
@@ -122,9 +184,27 @@ void splitPathAndFilename(const string& fullPath,
     fileName = fullPath.substr(i+1, fullPath.length() - i);
 }
 
+void closeLogging() {
+  logStreamOpen = false;
+  if(logFileStream.is_open()) {
+    logFileStream.close();
+  }
+  if(compressedLogStream.is_open()) {
+    compressedLogStream.close();
+  }
+}
+
 void initializeLogging() {
-  logStream.open(LOG_FILE_NAME);
-  if(logStream.is_open()) {
+  // The compressed log is compressed by a background thread.
+  if(simConfig.compressLog) {
+    compressedLogStream.open(COMPRESSED_LOG_FILE_NAME);
+    logStream = &compressedLogStream;
+  }
+  else {
+    logFileStream.open(LOG_FILE_NAME);
+    logStream = &logFileStream;
+  }
+  if(logStream->good()) {
     oms_regex exp(simConfig.variableFilter);
     for (int i = 0; i < fmi2_getNumberOfVariables(fmu); ++i)
     {
@@ -137,37 +217,37 @@ void initializeLogging() {
       }
     }
     if(logVariables.empty()) {
-      logStreamOpen = false;
-      logStream.close();
+      closeLogging();
       return;
     }
   }
 
   logStreamOpen = true;
-  logStream << "\"time\"";
+  *logStream << "\"time\"";
 
   for(size_t i=0; i<logVariables.size(); ++i) {
     fmi2ValueReference vr = logVariables[i];
     fmi2VariableHandle *var = fmi2_getVariableByValueReference(fmu, vr);
-    logStream << ",\"" << fmi2_getVariableName(var) << "\"";
+    *logStream << ",\"" << fmi2_getVariableName(var) << "\"";
   }
-  logStream << "\n";
+  *logStream << "\n";
 }
 
 void logAllVariables(double time) {
-  if(logStream.is_open()) {
-    logStream << time;
+  if(logStreamOpen) {
+    *logStream << time;
     for(size_t i=0; i<logVariables.size(); ++i) {
       double value;
       fmi2ValueReference vr = logVariables[i];
       fmi2_getReal(fmu,&vr,1,&value);
-      logStream << "," << value;
+      *logStream << "," << value;
     }
-    logStream << "\n";
+    *logStream << "\n";
   }
 }
 
 
+
 void setParameters()
 {
     //Todo: Support other types than real
@@ -212,8 +292,7 @@ void applyStartValues()
     }
 
     for(size_t j=0; j<fmiConfig.nInterfaces; ++j) {
-        if(fmiConfig.dimensions[j] == 6  &&
-           fmiConfig.causalities[j] == "Bidirectional") {
+        if(fmiConfig.kinds[j] == Interface3D) {
 
             double force[6];
             for(int k=0; k<6; ++k) {
@@ -230,8 +309,7 @@ void applyStartValues()
                                       force[0], force[1], force[2],
                                       force[3], force[4], force[5]);
         }
-        else if(fmiConfig.dimensions[j] == 1  &&
-                fmiConfig.causalities[j] == "Bidirectional") {
+        else if(fmiConfig.kinds[j] == Interface1D) {
             double force;
 
             fmi2VariableHandle* var = fmi2_getVariableByValueReference(fmu, (*fmiConfig.force_vr[j]));
@@ -239,14 +317,11 @@ void applyStartValues()
                 force = fmi2_getVariableStartReal(var);
             }
 
-            if(fmiConfig.domains[j] != "Hydraulic") {
-                force = -force;
-            }
+            force *= fmiConfig.forceSign[j];
 
             plugin->SetInitialForce1D(fmiConfig.interfaceIds[j], force);
         }
-        else if(fmiConfig.dimensions[j] == 1 &&
-                fmiConfig.causalities[j] == "Input" ) {
+        else if(fmiConfig.kinds[j] == SignalInput) {
             double value;
 
             fmi2VariableHandle* var = fmi2_getVariableByValueReference(fmu,(*fmiConfig.value_vr[j]));
@@ -261,56 +336,66 @@ void applyStartValues()
 //Read force from TLMPlugin and write it to FMU
 void forceFromTlmToFmu(double tcur)
 {
-    //Write interpolated force to FMU
-    for(size_t j=0; j<fmiConfig.nInterfaces; ++j) {
-        if(fmiConfig.dimensions[j] == 6 &&
-           fmiConfig.domains[j] == "Mechanical" &&
-           fmiConfig.causalities[j] == "Bidirectional") {
-            double position[3],orientation[9],speed[3],ang_speed[3],force[6];
-            //Read position and speed from FMU
-            fmistatus = fmi2_getReal(fmu,fmiConfig.position_vr[j],3,position);
-            fmistatus = fmi2_getReal(fmu,fmiConfig.orientation_vr[j],9,orientation);
-            fmistatus = fmi2_getReal(fmu,fmiConfig.speed_vr[j],3,speed);
-            fmistatus = fmi2_getReal(fmu,fmiConfig.ang_speed_vr[j],3,ang_speed);
-
-            //Get interpolated force
-            plugin->GetForce3D(fmiConfig.interfaceIds[j], tcur, position,orientation,speed,ang_speed,force);
+    //Read position and speed of all interfaces from FMU
+    if(!fmiConfig.output_vr.empty()) {
+      fmistatus = fmi2_getReal(fmu,fmiConfig.output_vr.data(),fmiConfig.output_vr.size(),output_values.data());
+    }
 
+    //Get interpolated force
+    for(size_t j=0; j<fmiConfig.nInterfaces; ++j) {
+        double* motion = output_values.data() + fmiConfig.output_offset[j];
+        double* force = input_values.data() + fmiConfig.input_offset[j];
+        switch(fmiConfig.kinds[j]) {
+        case Interface3D:
+            //Position, orientation, speed and angular speed
+            plugin->GetForce3D(fmiConfig.interfaceIds[j], tcur, motion, motion+3, motion+12, motion+15, force);
             for(size_t k=0; k<6; ++k) {
               force[k] = -force[k];
             }
-
-            // Write force to FMU
-            fmistatus = fmi2_setReal(fmu,fmiConfig.force_vr[j],6,force);
+            break;
+        case Interface1D:
+            //Position and speed
+            plugin->GetForce1D(fmiConfig.interfaceIds[j], tcur, motion[1], force);
+            force[0] *= fmiConfig.forceSign[j];
+            break;
+        case SignalInput:
+            plugin->GetValueSignal(fmiConfig.interfaceIds[j], tcur, force);
+            break;
+        default:
+            break;
         }
-        else if(fmiConfig.dimensions[j] == 1  &&
-                fmiConfig.causalities[j] == "Bidirectional") {
-          double position,speed,force;
-
-          //Read position and speed from FMU
-          fmistatus = fmi2_getReal(fmu,fmiConfig.position_vr[j],1,&position);
-          fmistatus = fmi2_getReal(fmu,fmiConfig.speed_vr[j],1,&speed);
-
-          //Get interpolated force
-          plugin->GetForce1D(fmiConfig.interfaceIds[j], tcur, speed,&force);
+    }
 
-          if(fmiConfig.domains[j] != "Hydraulic") {
-              force = -force;
-          }
+    //Write force of all interfaces to FMU
+    if(!fmiConfig.input_vr.empty()) {
+      fmistatus = fmi2_setReal(fmu,fmiConfig.input_vr.data(),fmiConfig.input_vr.size(),input_values.data());
+    }
+}
 
-          // Write force to FMU
-          fmistatus = fmi2_setReal(fmu,fmiConfig.force_vr[j],1,&force);
-        }
-        else if(fmiConfig.dimensions[j] == 1 &&
-                fmiConfig.causalities[j] == "Input" ) {
-            double value;
 
-            plugin->GetValueSignal(fmiConfig.interfaceIds[j], tcur, &value);
+//Read motion from FMU and write it to TLMPlugin
+void motionFromFmuToTlm(double tcur)
+{
+  if(!fmiConfig.output_vr.empty()) {
+    fmistatus = fmi2_getReal(fmu,fmiConfig.output_vr.data(),fmiConfig.output_vr.size(),output_values.data());
+  }
 
-            //Write value from FMU
-            fmistatus = fmi2_setReal(fmu,fmiConfig.value_vr[j],1,&value);
-        }
+  for(size_t j=0; j<fmiConfig.nInterfaces; ++j) {
+    double* motion = output_values.data() + fmiConfig.output_offset[j];
+    switch(fmiConfig.kinds[j]) {
+    case Interface3D:
+      plugin->SetMotion3D(fmiConfig.interfaceIds[j], tcur, motion, motion+3, motion+12, motion+15);
+      break;
+    case Interface1D:
+      plugin->SetMotion1D(fmiConfig.interfaceIds[j], tcur, motion[0], motion[1]);
+      break;
+    case SignalOutput:
+      plugin->SetValueSignal(fmiConfig.interfaceIds[j], tcur, motion[0]);
+      break;
+    default:
+      break;
     }
+  }
 }
 
 
@@ -324,6 +409,8 @@ static int rhs(realtype t, N_Vector y, N_Vector ydot, void *user_data)
 
   // Write interpolated force to FMU
   forceFromTlmToFmu(t);
+  eval_point_valid = true;
+  eval_point_time = t;
 
   // Read derivatives
   fmistatus = fmi2_getDerivatives(fmu, states_der, n_states);
@@ -347,6 +434,8 @@ static int rhs_ida(realtype t, N_Vector yy, N_Vector yp, N_Vector rr, void *user
 
   // Write interpolated force to FMU
   forceFromTlmToFmu(t);
+  eval_point_valid = true;
+  eval_point_time = t;
 
   // Read derivatives
   fmistatus = fmi2_getDerivatives(fmu, states_der, n_states);
@@ -358,9 +447,273 @@ static int rhs_ida(realtype t, N_Vector yy, N_Vector yp, N_Vector rr, void *user
   return(0);
 }
 
+//Find the value references needed for the analytic Jacobian. Returns false
+//if the FMU does not provide directional derivatives for them.
+static bool initializeJacobian()
+{
+  states_vr.clear();
+  states_der_vr.clear();
+  coupled_input_vr.clear();
+  jacobian_unknown_vr.clear();
+
+  if(!fmi2me_getProvidesDirectionalDerivative(fmu)) {
+    TLMErrorLog::Info("FMU does not provide directional derivatives, using finite difference Jacobian.");
+    return false;
+  }
+
+  //The state vector is assumed to be ordered as the derivative variables
+  for(int i=0; i<fmi2_getNumberOfVariables(fmu); ++i) {
+    fmi2VariableHandle* var = fmi2_getVariableByIndex(fmu, i);
+    int stateIndex = fmi2_getVariableDerivativeIndex(var);
+    if(stateIndex > 0) {
+      fmi2VariableHandle* state = fmi2_getVariableByIndex(fmu, stateIndex-1);
+      states_vr.push_back(fmi2_getVariableValueReference(state));
+      states_der_vr.push_back(fmi2_getVariableValueReference(var));
+    }
+  }
+  if(states_vr.size() != n_states) {
+    TLMErrorLog::Warning("Found "+TLMErrorLog::ToStdStr(int(states_vr.size()))+" state derivatives, expected "+
+                         TLMErrorLog::ToStdStr(int(n_states))+", using finite difference Jacobian.");
+    states_vr.clear();
+    states_der_vr.clear();
+    return false;
+  }
+
+  //The force of a bidirectional interface depends on its speed
+  jacobian_unknown_vr = states_der_vr;
+  for(size_t j=0; j<fmiConfig.nInterfaces; ++j) {
+    const fmi2ValueReference* in = fmiConfig.input_vr.data() + fmiConfig.input_offset[j];
+    const fmi2ValueReference* out = fmiConfig.output_vr.data() + fmiConfig.output_offset[j];
+    if(fmiConfig.kinds[j] == Interface3D) {
+      coupled_input_vr.insert(coupled_input_vr.end(), in, in+6);
+      jacobian_unknown_vr.insert(jacobian_unknown_vr.end(), out+12, out+18);
+    }
+    else if(fmiConfig.kinds[j] == Interface1D) {
+      coupled_input_vr.push_back(in[0]);
+      jacobian_unknown_vr.push_back(out[1]);
+    }
+  }
+
+  //Check that the interface speeds can be differentiated as well
+  std::vector<fmi2Real> seed(n_states, 0.0);
+  std::vector<fmi2Real> column(jacobian_unknown_vr.size());
+  seed[0] = 1.0;
+  fmistatus = fmi2_getDirectionalDerivative(fmu, jacobian_unknown_vr.data(), jacobian_unknown_vr.size(),
+                                            states_vr.data(), n_states, seed.data(), column.data());
+  if(fmistatus != fmi2OK) {
+    TLMErrorLog::Warning("fmi2_getDirectionalDerivative failed, using finite difference Jacobian.");
+    states_vr.clear();
+    states_der_vr.clear();
+    return false;
+  }
+
+  TLMErrorLog::Info("Using analytic Jacobian from directional derivatives.");
+  return true;
+}
+
+
+//Forget the evaluation point and the gains cached by prepareJacobian. Call it
+//whenever the FMU may have been changed outside rhs.
+static void invalidateJacobianCache()
+{
+  eval_point_valid = false;
+  gain_valid = false;
+}
+
+
+//Set the FMU to the states y with the interface forces as in rhs, and get
+//the impedance of each coupled input, d(input)/d(output). The FMU is only
+//updated if rhs was not last evaluated at (t, y), and the gains only once
+//per time, so that the Krylov solvers can call this for every product.
+static const std::vector<double>& prepareJacobian(realtype t, N_Vector y)
+{
+  bool samePoint = eval_point_valid && eval_point_time == t;
+  for(size_t i=0; i<n_states && samePoint; ++i) {
+    samePoint = (states[i] == Ith(y,i+1));
+  }
+  if(!samePoint) {
+    for(size_t i=0; i<n_states; ++i) {
+      states[i] = Ith(y,i+1);
+    }
+    fmistatus = fmi2_setContinuousStates(fmu, states, n_states);
+    forceFromTlmToFmu(t);
+    eval_point_valid = true;
+    eval_point_time = t;
+  }
+
+  if(gain_valid && gain_time == t) {
+    return gain_cache;
+  }
+  gain_cache.clear();
+  for(size_t j=0; j<fmiConfig.nInterfaces; ++j) {
+    if(fmiConfig.kinds[j] == Interface3D) {
+      double Zt, Zr, wave[6];
+      plugin->GetWaveImpedance3D(fmiConfig.interfaceIds[j], t, &Zt, &Zr, wave);
+      gain_cache.insert(gain_cache.end(), 3, fmiConfig.impedanceSign[j]*Zt);
+      gain_cache.insert(gain_cache.end(), 3, fmiConfig.impedanceSign[j]*Zr);
+    }
+    else if(fmiConfig.kinds[j] == Interface1D) {
+      double Z, wave;
+      plugin->GetWaveImpedance1D(fmiConfig.interfaceIds[j], t, &Z, &wave);
+      gain_cache.push_back(fmiConfig.impedanceSign[j]*Z);
+    }
+  }
+  gain_valid = true;
+  gain_time = t;
+  return gain_cache;
+}
+
+
 /*
  * Jacobian routine. Compute J(t,y) = df/dy. *
+ *
+ * The FMU gives df/dy for fixed inputs. The forces from TLM interfaces
+ * change with the interface speeds v as u = wave + Z*v, which adds
+ * df/du * Z * dv/dy.
  */
+static int jacobian(realtype t, N_Vector y, DlsMat J)
+{
+  const std::vector<double>& gain = prepareJacobian(t, y);
+  size_t n_coupled = coupled_input_vr.size();
+
+  // Columns of df/dy and dv/dy
+  std::vector<fmi2Real> seed(n_states, 0.0);
+  std::vector<fmi2Real> column(jacobian_unknown_vr.size());
+  std::vector<fmi2Real> dvdy(n_coupled*n_states);
+  for(size_t j=0; j<n_states; ++j) {
+    seed[j] = 1.0;
+    fmistatus = fmi2_getDirectionalDerivative(fmu, jacobian_unknown_vr.data(), jacobian_unknown_vr.size(),
+                                              states_vr.data(), n_states, seed.data(), column.data());
+    seed[j] = 0.0;
+    if(fmistatus != fmi2OK) {
+      TLMErrorLog::Warning("fmi2_getDirectionalDerivative failed");
+      return -1;
+    }
+    for(size_t i=0; i<n_states; ++i) {
+      IJth(J,i+1,j+1) = column[i];
+    }
+    for(size_t k=0; k<n_coupled; ++k) {
+      dvdy[k*n_states+j] = column[n_states+k];
+    }
+  }
+
+  // Add df/du * Z * dv/dy, one input at a time
+  std::vector<fmi2Real> dfdu(n_states);
+  for(size_t k=0; k<n_coupled; ++k) {
+    if(gain[k] == 0.0) continue;
+    fmi2Real one = 1.0;
+    fmistatus = fmi2_getDirectionalDerivative(fmu, states_der_vr.data(), n_states,
+                                              &coupled_input_vr[k], 1, &one, dfdu.data());
+    if(fmistatus != fmi2OK) {
+      TLMErrorLog::Warning("fmi2_getDirectionalDerivative failed");
+      return -1;
+    }
+    for(size_t j=0; j<n_states; ++j) {
+      double dudy = gain[k]*dvdy[k*n_states+j];
+      if(dudy == 0.0) continue;
+      for(size_t i=0; i<n_states; ++i) {
+        IJth(J,i+1,j+1) += dfdu[i]*dudy;
+      }
+    }
+  }
+
+  return(0);
+}
+
+
+/*
+ * Jacobian times vector routine for the Krylov solvers. Compute
+ * Jv = df/dy*v + df/du * Z * dv/dy*v with two directional derivatives.
+ */
+static int jacobianTimesVector(realtype t, N_Vector y, N_Vector v, N_Vector Jv)
+{
+  const std::vector<double>& gain = prepareJacobian(t, y);
+  size_t n_coupled = coupled_input_vr.size();
+
+  std::vector<fmi2Real> seed(n_states);
+  std::vector<fmi2Real> result(jacobian_unknown_vr.size());
+  for(size_t i=0; i<n_states; ++i) {
+    seed[i] = Ith(v,i+1);
+  }
+  fmistatus = fmi2_getDirectionalDerivative(fmu, jacobian_unknown_vr.data(), jacobian_unknown_vr.size(),
+                                            states_vr.data(), n_states, seed.data(), result.data());
+  if(fmistatus != fmi2OK) {
+    TLMErrorLog::Warning("fmi2_getDirectionalDerivative failed");
+    return -1;
+  }
+  for(size_t i=0; i<n_states; ++i) {
+    Ith(Jv,i+1) = result[i];
+  }
+
+  if(n_coupled > 0) {
+    std::vector<fmi2Real> du(n_coupled);
+    for(size_t k=0; k<n_coupled; ++k) {
+      du[k] = gain[k]*result[n_states+k];
+    }
+    fmistatus = fmi2_getDirectionalDerivative(fmu, states_der_vr.data(), n_states,
+                                              coupled_input_vr.data(), n_coupled, du.data(), result.data());
+    if(fmistatus != fmi2OK) {
+      TLMErrorLog::Warning("fmi2_getDirectionalDerivative failed");
+      return -1;
+    }
+    for(size_t i=0; i<n_states; ++i) {
+      Ith(Jv,i+1) += result[i];
+    }
+  }
+
+  return(0);
+}
+
+
+static int jacobian_cvode(long int N, realtype t, N_Vector y, N_Vector fy, DlsMat J, void *user_data,
+                          N_Vector tmp1, N_Vector tmp2, N_Vector tmp3)
+{
+  return jacobian(t, y, J);
+}
+
+
+static int jacobian_ida(long int N, realtype t, realtype c_j, N_Vector yy, N_Vector yp, N_Vector rr, DlsMat J,
+                        void *user_data, N_Vector tmp1, N_Vector tmp2, N_Vector tmp3)
+{
+  // The residual is yp - f(y), so dF/dy + c_j*dF/dyp = c_j*I - df/dy
+  int flag = jacobian(t, yy, J);
+  if(flag != 0) {
+    return flag;
+  }
+  DenseScale(-1.0, J);
+  for(size_t i=0; i<n_states; ++i) {
+    IJth(J,i+1,i+1) += c_j;
+  }
+  return(0);
+}
+
+
+static int jtimes_cvode(N_Vector v, N_Vector Jv, realtype t, N_Vector y, N_Vector fy, void *user_data, N_Vector tmp)
+{
+  return jacobianTimesVector(t, y, v, Jv);
+}
+
+
+static int jtimes_ida(realtype t, N_Vector yy, N_Vector yp, N_Vector rr, N_Vector v, N_Vector Jv, realtype c_j,
+                      void *user_data, N_Vector tmp1, N_Vector tmp2)
+{
+  // (c_j*I - df/dy)*v
+  int flag = jacobianTimesVector(t, yy, v, Jv);
+  if(flag != 0) {
+    return flag;
+  }
+  for(size_t i=0; i<n_states; ++i) {
+    Ith(Jv,i+1) = c_j*Ith(v,i+1) - Ith(Jv,i+1);
+  }
+  return(0);
+}
+
+
+//Residual for the band-block-diagonal preconditioner of IDA
+static int residual_ida_local(long int N, realtype t, N_Vector yy, N_Vector yp, N_Vector rr, void *user_data)
+{
+  return rhs_ida(t, yy, yp, rr, user_data);
+}
 
 
 static int check_flag(void *flagvalue, const char *funcname, int opt)
@@ -513,55 +866,8 @@ int simulate_fmi2_cs()
 
     fmi2Real hsub = tlmConfig.hmax/fmiConfig.nSubSteps;
     for(size_t i=0; i<fmiConfig.nSubSteps; ++i) {
-      for(size_t j=0; j<fmiConfig.nInterfaces; ++j) {
-          if(fmiConfig.dimensions[j] == 6 &&
-             fmiConfig.causalities[j] == "Bidirectional") {
-              double position[3],orientation[9],speed[3],ang_speed[3],force[6];
-
-              //Read position and speed from FMU
-              fmistatus = fmi2_getReal(fmu,fmiConfig.position_vr[j],3,position);
-              fmistatus = fmi2_getReal(fmu,fmiConfig.orientation_vr[j],9,orientation);
-              fmistatus = fmi2_getReal(fmu,fmiConfig.speed_vr[j],3,speed);
-              fmistatus = fmi2_getReal(fmu,fmiConfig.ang_speed_vr[j],3,ang_speed);
-
-              //Get interpolated force
-              plugin->GetForce3D(fmiConfig.interfaceIds[j], tcur, position,orientation,speed,ang_speed,force);
-
-              for(size_t k=0; k<6; ++k) {
-                force[k] = -force[k];
-              }
-
-              //Write force to FMU
-              fmistatus = fmi2_setReal(fmu,fmiConfig.force_vr[j],6,force);
-          }
-          else if(fmiConfig.dimensions[j] == 1 &&
-                  fmiConfig.causalities[j] == "Bidirectional") {
-            double position,speed,force;
-
-            //Read position and speed from FMU
-            fmistatus = fmi2_getReal(fmu,fmiConfig.position_vr[j],1,&position);
-            fmistatus = fmi2_getReal(fmu,fmiConfig.speed_vr[j],1,&speed);
-
-            //Get interpolated force
-            plugin->GetForce1D(fmiConfig.interfaceIds[j], tcur, speed,&force);
-
-            if(fmiConfig.domains[j] != "Hydraulic") {
-                force = -force;
-            }
-
-            //Write force to FMU
-            fmistatus = fmi2_setReal(fmu,fmiConfig.force_vr[j],1,&force);
-          }
-          else if(fmiConfig.dimensions[j] == 1 &&
-                  fmiConfig.causalities[j] == "Input") {
-              double value;
-
-              //Get value
-              plugin->GetValueSignal(fmiConfig.interfaceIds[j], tcur, &value);
-
-              fmistatus = fmi2_setReal(fmu,fmiConfig.value_vr[j],1,&value);
-          }
-      }
+      //Write interpolated force to FMU
+      forceFromTlmToFmu(tcur);
 
       //Take one sub step
       TLMErrorLog::Info("Taking step!");
@@ -570,48 +876,8 @@ int simulate_fmi2_cs()
       //Increment time
       tcur+=hsub;
 
-      for(size_t j=0; j<fmiConfig.nInterfaces; ++j) {
-          if(fmiConfig.dimensions[j] == 6 &&
-             fmiConfig.causalities[j] == "Bidirectional") {
-              double force[6], position[3],orientation[9],speed[3],ang_speed[3];
-
-              //Read position and speed from FMU
-              fmistatus = fmi2_getReal(fmu,fmiConfig.position_vr[j],3,position);
-              fmistatus = fmi2_getReal(fmu,fmiConfig.orientation_vr[j],9,orientation);
-              fmistatus = fmi2_getReal(fmu,fmiConfig.speed_vr[j],3,speed);
-              fmistatus = fmi2_getReal(fmu,fmiConfig.ang_speed_vr[j],3,ang_speed);
-
-              //Get interpolated force
-              plugin->GetForce3D(fmiConfig.interfaceIds[j], tcur, position,orientation,speed,ang_speed,force);
-
-              //Write back motion for sub step
-              plugin->SetMotion3D(fmiConfig.interfaceIds[j], tcur, position, orientation, speed, ang_speed);
-          }
-          else if(fmiConfig.dimensions[j] == 1 &&
-                  fmiConfig.causalities[j] == "Bidirectional") {
-              double force, position, speed;
-
-              //Read position and speed from FMU
-              fmistatus = fmi2_getReal(fmu,fmiConfig.position_vr[j],1,&position);
-              fmistatus = fmi2_getReal(fmu,fmiConfig.speed_vr[j],1,&speed);
-
-              //Get interpolated force
-              plugin->GetForce1D(fmiConfig.interfaceIds[j], tcur, speed,&force);
-
-              //Write back motion for sub step
-              plugin->SetMotion1D(fmiConfig.interfaceIds[j], tcur, position, speed);
-          }
-          else if(fmiConfig.dimensions[j] == 1 &&
-                  fmiConfig.causalities[j] == "Output") {
-              double value;
-
-              //Read value from FMU
-              fmistatus = fmi2_getReal(fmu,fmiConfig.value_vr[j],1,&value);
-
-              //Write back value for sub step
-              plugin->SetValueSignal(fmiConfig.interfaceIds[j], tcur, value);
-          }
-      }
+      //Write back motion for sub step
+      motionFromFmuToTlm(tcur);
     }
   }
 
@@ -627,54 +893,96 @@ int simulate_fmi2_cs()
 
 
 
-// Event iteration auxiliary function
-void do_event_iteration(fmiHandle *fmu, fmi2EventInfo *eventInfo)
-{
-  eventInfo->newDiscreteStatesNeeded = fmi2True;
-  eventInfo->terminateSimulation     = fmi2False;
-  while (eventInfo->newDiscreteStatesNeeded && !eventInfo->terminateSimulation) {
-    fmi2_newDiscreteStates(fmu, eventInfo);
-  }
-}
+// Dormand-Prince 5(4) coefficients. The last stage is evaluated at the new
+// solution, so it is the first stage of the next step.
+static const double dp_c[7] = { 0.0, 1.0/5.0, 3.0/10.0, 4.0/5.0, 8.0/9.0, 1.0, 1.0 };
+static const double dp_a[7][6] = {
+  { 0.0 },
+  { 1.0/5.0 },
+  { 3.0/40.0, 9.0/40.0 },
+  { 44.0/45.0, -56.0/15.0, 32.0/9.0 },
+  { 19372.0/6561.0, -25360.0/2187.0, 64448.0/6561.0, -212.0/729.0 },
+  { 9017.0/3168.0, -355.0/33.0, 46732.0/5247.0, 49.0/176.0, -5103.0/18656.0 },
+  { 35.0/384.0, 0.0, 500.0/1113.0, 125.0/192.0, -2187.0/6784.0, 11.0/84.0 }
+};
+// Difference between the 5th and the 4th order weights
+static const double dp_e[7] = { 71.0/57600.0, 0.0, -71.0/16695.0, 71.0/1920.0,
+                                -17253.0/339200.0, 22.0/525.0, -1.0/40.0 };
 
 
-//Read motion from FMU and write it to TLMPlugin
-void motionFromFmuToTlm(double tcur)
+// Integrate y from t to tend with the adaptive Dormand-Prince 5(4) method.
+// k[0] must contain f(t,y) on entry, k[1]..k[6] and ytmp are work vectors.
+// h is the step size to try first, and is returned for the next call.
+static int dormandPrince(CVRhsFn f, realtype t, realtype tend, N_Vector y, N_Vector k[7], N_Vector ytmp,
+                         realtype& h, realtype hmax, realtype reltol, N_Vector abstol)
 {
-  for(size_t j=0; j<fmiConfig.nInterfaces; ++j) {
-    if(fmiConfig.dimensions[j] == 6 &&
-       fmiConfig.causalities[j] == "Bidirectional") {
-      double position[3],orientation[9],speed[3],ang_speed[3];
-
-      fmistatus = fmi2_getReal(fmu,fmiConfig.position_vr[j],3,position);
-      fmistatus = fmi2_getReal(fmu,fmiConfig.orientation_vr[j],9,orientation);
-      fmistatus = fmi2_getReal(fmu,fmiConfig.speed_vr[j],3,speed);
-      fmistatus = fmi2_getReal(fmu,fmiConfig.ang_speed_vr[j],3,ang_speed);
-
-       plugin->SetMotion3D(fmiConfig.interfaceIds[j], tcur, position, orientation, speed, ang_speed);
+  long int n = NV_LENGTH_S(y);
+  while(t < tend) {
+    // Stretch the step to tend rather than leave a sliver of a step behind
+    bool lastStep = (tend - t - h < 1e-10*h);
+    realtype hstep = lastStep ? tend - t : h;
+    // A tiny final step, e.g., left by rounding of t, is always accepted
+    bool tinyStep = (hstep <= 1e-14*std::max(1.0, std::fabs(t)));
+    if(tinyStep && !lastStep) {
+      TLMErrorLog::Warning("Runge-Kutta step size too small at time "+TLMErrorLog::ToStdStr(t));
+      return -1;
     }
-    else if(fmiConfig.dimensions[j] == 1 &&
-            fmiConfig.causalities[j] == "Bidirectional") {
-      double position,speed;
-
-      fmistatus = fmi2_getReal(fmu,fmiConfig.position_vr[j],1,&position);
-      fmistatus = fmi2_getReal(fmu,fmiConfig.speed_vr[j],1,&speed);
 
-      plugin->SetMotion1D(fmiConfig.interfaceIds[j], tcur, position, speed);
+    // Stages 2-7, the last one at the 5th order solution
+    for(int s=1; s<7; ++s) {
+      for(long int i=0; i<n; ++i) {
+        realtype sum = 0.0;
+        for(int j=0; j<s; ++j) {
+          sum += dp_a[s][j]*NV_Ith_S(k[j],i);
+        }
+        NV_Ith_S(ytmp,i) = NV_Ith_S(y,i) + hstep*sum;
+      }
+      if(f(t+dp_c[s]*hstep, ytmp, k[s], 0) != 0) {
+        return -1;
+      }
     }
-    else if(fmiConfig.dimensions[j] == 1 &&
-            fmiConfig.causalities[j] == "Output") {
-        double value;
-
-        fmistatus = fmi2_getReal(fmu,fmiConfig.value_vr[j],1,&value);
 
-        plugin->SetValueSignal(fmiConfig.interfaceIds[j], tcur, value);
+    // Weighted RMS norm of the local error estimate
+    realtype norm = 0.0;
+    for(long int i=0; i<n; ++i) {
+      realtype err = 0.0;
+      for(int j=0; j<7; ++j) {
+        err += dp_e[j]*NV_Ith_S(k[j],i);
+      }
+      realtype scale = NV_Ith_S(abstol,i) + reltol*std::max(std::fabs(NV_Ith_S(y,i)), std::fabs(NV_Ith_S(ytmp,i)));
+      norm += (hstep*err/scale)*(hstep*err/scale);
+    }
+    norm = n > 0 ? std::sqrt(norm/n) : 0.0;
+
+    // Step size controller, with a safety factor and limited change
+    realtype factor = (norm > 0.0) ? 0.9*std::pow(norm, -0.2) : 5.0;
+    factor = std::min(5.0, std::max(0.2, factor));
+
+    if(norm <= 1.0 || tinyStep) {
+      t = lastStep ? tend : t+hstep;
+      N_VScale(1.0, ytmp, y);
+      N_VScale(1.0, k[6], k[0]);
+      // A step shortened to reach tend says little about the next one
+      h = lastStep ? std::max(h, hstep*factor) : hstep*factor;
     }
+    else {
+      h = hstep*std::min(1.0, factor);
+    }
+    h = std::min(h, hmax);
   }
+  return 0;
 }
 
 
-
+// Event iteration auxiliary function
+void do_event_iteration(fmiHandle *fmu, fmi2EventInfo *eventInfo)
+{
+  eventInfo->newDiscreteStatesNeeded = fmi2True;
+  eventInfo->terminateSimulation     = fmi2False;
+  while (eventInfo->newDiscreteStatesNeeded && !eventInfo->terminateSimulation) {
+    fmi2_newDiscreteStates(fmu, eventInfo);
+  }
+}
 
 
 // Simulate function for model exchange
@@ -692,7 +1000,7 @@ int simulate_fmi2_me()
       TLMErrorLog::Info("Using explicit Euler solver.");
       break;
     case RungeKutta:
-      TLMErrorLog::Info("Using 4th order explicit Runge-Kutta solver.");
+      TLMErrorLog::Info("Using adaptive Dormand-Prince 5(4) Runge-Kutta solver.");
   }
 
   // jm_status_enu_t jmstatus;
@@ -856,18 +1164,53 @@ int simulate_fmi2_me()
     flag = CVodeSVtolerances(mem, reltol, abstol);
     if (check_flag(&flag, "CVodeSVtolerances", 1)) return(1);
 
-    /* Call CVDense to specify the CVDENSE dense linear solver */
-    TLMErrorLog::Info("Specifying linear solver (dense).");
-    flag = CVDense(mem, n_states);
-    if (check_flag(&flag, "CVDense", 1)) return(1);
+    if(simConfig.linsolver == Dense) {
+      /* Call CVDense to specify the CVDENSE dense linear solver */
+      TLMErrorLog::Info("Specifying linear solver (dense).");
+      flag = CVDense(mem, n_states);
+      if (check_flag(&flag, "CVDense", 1)) return(1);
+    }
+    else {
+      /* Krylov linear solver, left preconditioned by a banded difference
+       * quotient approximation of the Jacobian if a bandwidth is given */
+      int pretype = simConfig.bandwidth > 0 ? PREC_LEFT : PREC_NONE;
+      if(simConfig.linsolver == SPGMR) {
+        TLMErrorLog::Info("Specifying linear solver (SPGMR).");
+        flag = CVSpgmr(mem, pretype, 0);
+        if (check_flag(&flag, "CVSpgmr", 1)) return(1);
+      }
+      else if(simConfig.linsolver == SPBCGS) {
+        TLMErrorLog::Info("Specifying linear solver (SPBCGS).");
+        flag = CVSpbcg(mem, pretype, 0);
+        if (check_flag(&flag, "CVSpbcg", 1)) return(1);
+      }
+      else {
+        TLMErrorLog::Info("Specifying linear solver (SPTFQMR).");
+        flag = CVSptfqmr(mem, pretype, 0);
+        if (check_flag(&flag, "CVSptfqmr", 1)) return(1);
+      }
+      if(pretype != PREC_NONE) {
+        TLMErrorLog::Info("Specifying banded preconditioner, half-bandwidth "+TLMErrorLog::ToStdStr(simConfig.bandwidth)+".");
+        flag = CVBandPrecInit(mem, n_states, simConfig.bandwidth, simConfig.bandwidth);
+        if (check_flag(&flag, "CVBandPrecInit", 1)) return(1);
+      }
+    }
 
     TLMErrorLog::Info("Specifying maximum step size.");
     flag = CVodeSetMaxStep(mem, tlmConfig.hmax);
     if (check_flag(&flag, "CVodeSetMaxStep", 1)) return(1);
 
-    /* Set the Jacobian routine to Jac (user-supplied) */
-    //flag = CVDlsSetDenseJacFn(cvode_mem, Jac);        //TODO: Supply with jacobian somehow
-    //if (check_flag(&flag, "CVDlsSetDenseJacFn", 1)) return(1);
+    /* Set the Jacobian routines to the directional derivatives, if provided */
+    if(initializeJacobian()) {
+      if(simConfig.linsolver == Dense) {
+        flag = CVDlsSetDenseJacFn(mem, jacobian_cvode);
+        if (check_flag(&flag, "CVDlsSetDenseJacFn", 1)) return(1);
+      }
+      else {
+        flag = CVSpilsSetJacTimesVecFn(mem, jtimes_cvode);
+        if (check_flag(&flag, "CVSpilsSetJacTimesVecFn", 1)) return(1);
+      }
+    }
   }
   else if(simConfig.solver == IDA) {
     TLMErrorLog::Info("Initializing IDA solver.");
@@ -893,18 +1236,66 @@ int simulate_fmi2_me()
     flag = IDASVtolerances(mem, reltol, abstol);
     if (check_flag(&flag, "IDASVtolerances", 1)) return(1);
 
-    /* Call IDADense to specify the CVDENSE dense linear solver */
-    TLMErrorLog::Info("Specifying linear solver (dense).");
-    flag = IDADense(mem, n_states);
-    if (check_flag(&flag, "IDADense", 1)) return(1);
+    if(simConfig.linsolver == Dense) {
+      /* Call IDADense to specify the CVDENSE dense linear solver */
+      TLMErrorLog::Info("Specifying linear solver (dense).");
+      flag = IDADense(mem, n_states);
+      if (check_flag(&flag, "IDADense", 1)) return(1);
+    }
+    else {
+      /* Krylov linear solver, preconditioned by a band-block-diagonal
+       * difference quotient approximation if a bandwidth is given */
+      if(simConfig.linsolver == SPGMR) {
+        TLMErrorLog::Info("Specifying linear solver (SPGMR).");
+        flag = IDASpgmr(mem, 0);
+        if (check_flag(&flag, "IDASpgmr", 1)) return(1);
+      }
+      else if(simConfig.linsolver == SPBCGS) {
+        TLMErrorLog::Info("Specifying linear solver (SPBCGS).");
+        flag = IDASpbcg(mem, 0);
+        if (check_flag(&flag, "IDASpbcg", 1)) return(1);
+      }
+      else {
+        TLMErrorLog::Info("Specifying linear solver (SPTFQMR).");
+        flag = IDASptfqmr(mem, 0);
+        if (check_flag(&flag, "IDASptfqmr", 1)) return(1);
+      }
+      if(simConfig.bandwidth > 0) {
+        TLMErrorLog::Info("Specifying band-block-diagonal preconditioner, half-bandwidth "+TLMErrorLog::ToStdStr(simConfig.bandwidth)+".");
+        long int bw = simConfig.bandwidth;
+        flag = IDABBDPrecInit(mem, n_states, bw, bw, bw, bw, 0.0, residual_ida_local, NULL);
+        if (check_flag(&flag, "IDABBDPrecInit", 1)) return(1);
+      }
+    }
 
     TLMErrorLog::Info("Specifying maximum step size.");
     flag = IDASetMaxStep(mem, tlmConfig.hmax);
     if (check_flag(&flag, "IDASetMaxStep", 1)) return(1);
 
-    /* Set the Jacobian routine to Jac (user-supplied) */
-    //flag = CVDlsSetDenseJacFn(cvode_mem, Jac);        //TODO: Supply with jacobian somehow
-    //if (check_flag(&flag, "CVDlsSetDenseJacFn", 1)) return(1);
+    /* Set the Jacobian routines to the directional derivatives, if provided */
+    if(initializeJacobian()) {
+      if(simConfig.linsolver == Dense) {
+        flag = IDADlsSetDenseJacFn(mem, jacobian_ida);
+        if (check_flag(&flag, "IDADlsSetDenseJacFn", 1)) return(1);
+      }
+      else {
+        flag = IDASpilsSetJacTimesVecFn(mem, jtimes_ida);
+        if (check_flag(&flag, "IDASpilsSetJacTimesVecFn", 1)) return(1);
+      }
+    }
+  }
+
+  /* Work vectors and step size of the Runge-Kutta solver */
+  N_Vector rk_k[7] = { NULL };
+  N_Vector rk_ytmp = NULL;
+  realtype rk_h = hdef;
+  if(simConfig.solver == RungeKutta) {
+    for(int i=0; i<7; ++i) {
+      rk_k[i] = N_VNew_Serial(n_states);
+      if (check_flag((void *)rk_k[i], "N_VNew_Serial", 0)) return(1);
+    }
+    rk_ytmp = N_VNew_Serial(n_states);
+    if (check_flag((void *)rk_ytmp, "N_VNew_Serial", 0)) return(1);
   }
 
   double tc=tstart; //Cvode time
@@ -969,6 +1360,9 @@ int simulate_fmi2_me()
       Ith(yp,i+1) = states_der[i];
     }
 
+    //The FMU was changed above, outside rhs
+    invalidateJacobianCache();
+
     //Integrate using specified solver
     if(simConfig.solver == CVODE) {
       while(tc < tcur){
@@ -994,35 +1388,11 @@ int simulate_fmi2_me()
       }
     }
     else if(simConfig.solver == RungeKutta) {
-      N_Vector k1,k2,k3,k4;
-      k1 = N_VNew_Serial(n_states);
-      if (check_flag((void *)y, "N_VNew_Serial", 0)) return(1);
-      k2 = N_VNew_Serial(n_states);
-      if (check_flag((void *)y, "N_VNew_Serial", 0)) return(1);
-      k3 = N_VNew_Serial(n_states);
-      if (check_flag((void *)y, "N_VNew_Serial", 0)) return(1);
-      k4 = N_VNew_Serial(n_states);
-      if (check_flag((void *)y, "N_VNew_Serial", 0)) return(1);
-
-      k1 = yp;
-      for(k=0; k<n_states; ++k) {
-        Ith(y,k+1) = Ith(y,k+1) + hcur/2.0*Ith(k1,k+1);
-      }
-      rhs(tcur+hcur/2.0,y,yp,0);
-      k2 = yp;
-      for(k=0; k<n_states; ++k) {
-        Ith(y,k+1) = Ith(y,k+1) + hcur/2.0*Ith(k2,k+1);
-      }
-      rhs(tcur+hcur/2.0,y,yp,0);
-      k3 = yp;
-      for(k=0; k<n_states; ++k) {
-        Ith(y,k+1) = Ith(y,k+1) + hcur*Ith(k3,k+1);
-      }
-      rhs(tcur+hcur/2.0,y,yp,0);
-      k4 = yp;
-
-      for(k=0; k<n_states; ++k) {
-        Ith(y,k+1) = Ith(y,k+1)+hcur*(Ith(k1,k+1)+2*Ith(k2,k+1)+2*Ith(k3,k+1)+Ith(k4,k+1))/6.0;
+      N_VScale(1.0, yp, rk_k[0]);
+      flag = dormandPrince(rhs, tlast, tcur, y, rk_k, rk_ytmp, rk_h, hdef, reltol, abstol);
+      if(flag != 0) {
+        TLMErrorLog::FatalError("Runge-Kutta solver failed!");
+        exit(1);
       }
     }
 
@@ -1045,6 +1415,10 @@ int simulate_fmi2_me()
   free(states_der);
   free(event_indicators);
   free(event_indicators_prev);
+  for(int i=0; i<7; ++i) {
+    if(rk_k[i]) N_VDestroy_Serial(rk_k[i]);
+  }
+  if(rk_ytmp) N_VDestroy_Serial(rk_ytmp);
   fmi2_freeInstance(fmu);
   fmi4c_freeFmu(fmu);
   return 0;
@@ -1307,6 +1681,90 @@ void readFmiConfigFile()
 }
 
 
+// Resolves the kind of each interface and concatenates the value references
+// of all interfaces, so that each solver call reads and writes the interface
+// variables of the FMU with one fmi2_getReal and one fmi2_setReal.
+void compileValueReferences()
+{
+  fmiConfig.kinds.clear();
+  fmiConfig.forceSign.clear();
+  fmiConfig.impedanceSign.clear();
+  fmiConfig.output_vr.clear();
+  fmiConfig.input_vr.clear();
+  fmiConfig.output_offset.clear();
+  fmiConfig.input_offset.clear();
+
+  for(size_t j=0; j<fmiConfig.nInterfaces; ++j) {
+    interface_t kind = Unsupported;
+    if(fmiConfig.dimensions[j] == 6 && fmiConfig.causalities[j] == "Bidirectional") {
+      kind = Interface3D;
+    }
+    else if(fmiConfig.dimensions[j] == 1 && fmiConfig.causalities[j] == "Bidirectional") {
+      kind = Interface1D;
+    }
+    else if(fmiConfig.dimensions[j] == 1 && fmiConfig.causalities[j] == "Input") {
+      kind = SignalInput;
+    }
+    else if(fmiConfig.dimensions[j] == 1 && fmiConfig.causalities[j] == "Output") {
+      kind = SignalOutput;
+    }
+    else {
+      TLMErrorLog::Warning("Unsupported interface "+fmiConfig.interfaceNames[j]+" is ignored.");
+    }
+    fmiConfig.kinds.push_back(kind);
+
+    // Hydraulic interfaces use the sign convention of the TLM plugin
+    fmiConfig.forceSign.push_back(fmiConfig.domains[j] == "Hydraulic" ? 1.0 : -1.0);
+
+    // The plugin returns wave - Z*speed, with the speed negated for hydraulic
+    // interfaces (it lower-cases the first letter of the domain). The 3D force
+    // is negated before it is written to the FMU.
+    std::string domain = fmiConfig.domains[j];
+    if(!domain.empty()) domain[0] = std::tolower(domain[0]);
+    if(kind == Interface3D) {
+      fmiConfig.impedanceSign.push_back(1.0);
+    }
+    else {
+      fmiConfig.impedanceSign.push_back(fmiConfig.forceSign[j]*(domain == "hydraulic" ? 1.0 : -1.0));
+    }
+
+    fmiConfig.output_offset.push_back(fmiConfig.output_vr.size());
+    fmiConfig.input_offset.push_back(fmiConfig.input_vr.size());
+
+    std::vector<fmi2ValueReference>& out = fmiConfig.output_vr;
+    std::vector<fmi2ValueReference>& in = fmiConfig.input_vr;
+    switch(kind) {
+    case Interface3D:
+      out.insert(out.end(), fmiConfig.position_vr[j], fmiConfig.position_vr[j]+3);
+      out.insert(out.end(), fmiConfig.orientation_vr[j], fmiConfig.orientation_vr[j]+9);
+      out.insert(out.end(), fmiConfig.speed_vr[j], fmiConfig.speed_vr[j]+3);
+      out.insert(out.end(), fmiConfig.ang_speed_vr[j], fmiConfig.ang_speed_vr[j]+3);
+      in.insert(in.end(), fmiConfig.force_vr[j], fmiConfig.force_vr[j]+6);
+      break;
+    case Interface1D:
+      out.push_back(fmiConfig.position_vr[j][0]);
+      out.push_back(fmiConfig.speed_vr[j][0]);
+      in.push_back(fmiConfig.force_vr[j][0]);
+      break;
+    case SignalInput:
+      in.push_back(fmiConfig.value_vr[j][0]);
+      break;
+    case SignalOutput:
+      out.push_back(fmiConfig.value_vr[j][0]);
+      break;
+    default:
+      break;
+    }
+  }
+
+  output_values.assign(fmiConfig.output_vr.size(), 0.0);
+  input_values.assign(fmiConfig.input_vr.size(), 0.0);
+
+  TLMErrorLog::Info("Interface variables: "+TLMErrorLog::ToStdStr(int(fmiConfig.output_vr.size()))+" outputs, "+
+                    TLMErrorLog::ToStdStr(int(fmiConfig.input_vr.size()))+" inputs");
+}
+
+
 void readTlmConfigFile()
 {
   ifstream tlmConfigFile(TLM_CONFIG_FILE_NAME);
@@ -1359,10 +1817,14 @@ int main(int argc, char* argv[])
     cout << "  FMIWrapper [path] [fmu file] [additional arguments]" << endl << endl;
     cout << "Additional arguments:" << endl;
     cout << "  solver=[solver]    Set numerical solver (Euler, RungeKutta, CVODE or IDA)" << endl;
+    cout << "  linsolver=[solver] Set linear solver for CVODE and IDA (Dense, SPGMR, SPBCGS or SPTFQMR)" << endl;
+    cout << "  bandwidth=N        Half-bandwidth of the banded preconditioner for SPGMR, SPBCGS and SPTFQMR" << endl;
     cout << "  -d                 Enable additional debug output" << endl << endl;
     cout << "  -l X               Logging level for FMU" << endl << endl;
     cout << "                     (0 = nothing, 1 = fatal,   2 = error, 3 = warning," << endl << endl;
     cout << "                      4 = info,    5 = verbose, 6 = debug, 7 = all)" << endl << endl;
+    cout << "  -z                 Write a compressed variable log (logdata.csv.gz)" << endl << endl;
+    cout << "  -a                 Write the debug output from a background thread" << endl << endl;
     cout << "Example:" << endl;
     cout << "  FMIWrapper c:\\path\\to\\fmu model.fmu solver=CVODE -d -l 3" << endl;
     TLMErrorLog::FatalError("Too few arguments!");
@@ -1390,6 +1852,16 @@ int main(int argc, char* argv[])
       simConfig.solver = CVODE;
     else if(!strcmp(argv[i],"solver=IDA"))
       simConfig.solver = IDA;
+    else if(!strcmp(argv[i],"linsolver=Dense"))
+      simConfig.linsolver = Dense;
+    else if(!strcmp(argv[i],"linsolver=SPGMR"))
+      simConfig.linsolver = SPGMR;
+    else if(!strcmp(argv[i],"linsolver=SPBCGS"))
+      simConfig.linsolver = SPBCGS;
+    else if(!strcmp(argv[i],"linsolver=SPTFQMR"))
+      simConfig.linsolver = SPTFQMR;
+    else if(!strncmp(argv[i],"bandwidth=",10))
+      simConfig.bandwidth = atoi(argv[i]+10);
     else if(!strcmp(argv[i],"-d")) {
       TLMErrorLog::SetLogLevel(TLMLogLevel::Debug);
       //cout << "Activating debug output" << endl;
@@ -1406,6 +1878,12 @@ int main(int argc, char* argv[])
     else if(!strcmp(argv[i],"-v") && argc > i+1) {
       simConfig.variableFilter = argv[i+1];
     }
+    else if(!strcmp(argv[i],"-z")) {
+      simConfig.compressLog = true;
+    }
+    else if(!strcmp(argv[i],"-a")) {
+      simConfig.asyncLog = true;
+    }
   }
 
   cout << "Starting FMIWrapper. Debug output will be written to \"TLMlogfile.log\"." << endl;
@@ -1462,10 +1940,16 @@ int main(int argc, char* argv[])
 
   // Read TLM configuration
   readFmiConfigFile();
+  compileValueReferences();
 
   // Read FMI configuration
   readTlmConfigFile();
 
+  // Log from a background thread so that debug logging does not stall the solver
+  if(simConfig.asyncLog) {
+    TLMErrorLog::SetAsync(true);
+  }
+
   // Instantiate the TLMPlugin
   plugin = TLMPlugin::CreateInstance();
 
@@ -1565,6 +2049,7 @@ int main(int argc, char* argv[])
   }
 
   //Clean up
+  closeLogging();
   fmi2_freeInstance(fmu);
   fmi4c_freeFmu(fmu);
 
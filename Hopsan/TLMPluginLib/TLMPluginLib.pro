@@ -51,6 +51,8 @@ SOURCES += \
     ../../common/Communication/TLMClientComm.cc \
     ../../common/Communication/TLMCommUtil.cc \
     ../../common/Logging/TLMErrorLog.cc \
+    ../../common/Logging/TLMTrace.cc \
+    ../../common/Communication/TLMScheduling.cc \
     ../../common/Interfaces/TLMInterface.cc \
     ../../common/Plugin/TLMPlugin.cc \
     ../../3rdParty/misc/src/Bstring.cc \
@@ -1,4 +1,6 @@
 #include "Communication/ManagerCommHandler.h"
+#include "Logging/TLMTrace.h"
+#include "Communication/TLMScheduling.h"
 #include "tostr.h"
 #include <iostream>
 #include <sstream>
@@ -7,6 +9,9 @@
 #endif
 #include <cassert>
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
 
 #include <cstdlib>
 #ifndef NO_RTIME
@@ -25,11 +30,96 @@ using std::cerr;
 using std::endl;
 using std::multimap;
 
+InterfaceProfile& InterfaceProfile::operator=(const InterfaceProfile& other) {
+    StoreRelaxed(NumMessages, LoadRelaxed(other.NumMessages));
+    StoreRelaxed(NumBytes, LoadRelaxed(other.NumBytes));
+    StoreRelaxed(LastArrival, LoadRelaxed(other.LastArrival));
+    StoreRelaxed(MinInterArrival, LoadRelaxed(other.MinInterArrival));
+    StoreRelaxed(SumInterArrival, LoadRelaxed(other.SumInterArrival));
+    StoreRelaxed(MaxInterArrival, LoadRelaxed(other.MaxInterArrival));
+    StoreRelaxed(SentTime, LoadRelaxed(other.SentTime));
+    StoreRelaxed(NumLeads, LoadRelaxed(other.NumLeads));
+    StoreRelaxed(MinLead, LoadRelaxed(other.MinLead));
+    StoreRelaxed(SumLead, LoadRelaxed(other.SumLead));
+    StoreRelaxed(MaxLead, LoadRelaxed(other.MaxLead));
+    StoreRelaxed(WaitTime, LoadRelaxed(other.WaitTime));
+    StoreRelaxed(NumWaits, LoadRelaxed(other.NumWaits));
+    StoreRelaxed(NumExtrapolations, LoadRelaxed(other.NumExtrapolations));
+    StoreRelaxed(NumForwarded, LoadRelaxed(other.NumForwarded));
+    StoreRelaxed(SumResidence, LoadRelaxed(other.SumResidence));
+    StoreRelaxed(MaxResidence, LoadRelaxed(other.MaxResidence));
+    StoreRelaxed(SumLatency, LoadRelaxed(other.SumLatency));
+    StoreRelaxed(MaxLatency, LoadRelaxed(other.MaxLatency));
+    return *this;
+}
+
+void InterfaceProfile::Clear() {
+    StoreRelaxed(NumMessages, uint64_t(0));
+    StoreRelaxed(NumBytes, uint64_t(0));
+    StoreRelaxed(LastArrival, 0.0);
+    StoreRelaxed(MinInterArrival, 0.0);
+    StoreRelaxed(SumInterArrival, 0.0);
+    StoreRelaxed(MaxInterArrival, 0.0);
+    StoreRelaxed(SentTime, 0.0);
+    StoreRelaxed(NumLeads, uint64_t(0));
+    StoreRelaxed(MinLead, 0.0);
+    StoreRelaxed(SumLead, 0.0);
+    StoreRelaxed(MaxLead, 0.0);
+    StoreRelaxed(WaitTime, 0.0);
+    StoreRelaxed(NumWaits, 0);
+    StoreRelaxed(NumExtrapolations, 0);
+    StoreRelaxed(NumForwarded, uint64_t(0));
+    StoreRelaxed(SumResidence, 0.0);
+    StoreRelaxed(MaxResidence, 0.0);
+    StoreRelaxed(SumLatency, 0.0);
+    StoreRelaxed(MaxLatency, 0.0);
+}
+
+void InterfaceProfile::AddArrival(double now, size_t size) {
+    uint64_t n = LoadRelaxed(NumMessages);
+    if(n > 0) {
+        double dt = now - LoadRelaxed(LastArrival);
+        StoreRelaxed(SumInterArrival, LoadRelaxed(SumInterArrival) + dt);
+        if(n == 1 || dt < LoadRelaxed(MinInterArrival)) StoreRelaxed(MinInterArrival, dt);
+        if(dt > LoadRelaxed(MaxInterArrival)) StoreRelaxed(MaxInterArrival, dt);
+    }
+    StoreRelaxed(LastArrival, now);
+    StoreRelaxed(NumBytes, LoadRelaxed(NumBytes) + uint64_t(size));
+    StoreRelaxed(NumMessages, n + 1);
+}
+
+void InterfaceProfile::AddLead(double lead) {
+    uint64_t n = LoadRelaxed(NumLeads);
+    StoreRelaxed(SumLead, LoadRelaxed(SumLead) + lead);
+    if(n == 0 || lead < LoadRelaxed(MinLead)) StoreRelaxed(MinLead, lead);
+    if(n == 0 || lead > LoadRelaxed(MaxLead)) StoreRelaxed(MaxLead, lead);
+    StoreRelaxed(NumLeads, n + 1);
+}
+
+void InterfaceProfile::AddMessage(double residence, double latency) {
+    StoreRelaxed(NumForwarded, LoadRelaxed(NumForwarded) + 1);
+    StoreRelaxed(SumResidence, LoadRelaxed(SumResidence) + residence);
+    StoreRelaxed(SumLatency, LoadRelaxed(SumLatency) + latency);
+    if(residence > LoadRelaxed(MaxResidence)) StoreRelaxed(MaxResidence, residence);
+    if(latency > LoadRelaxed(MaxLatency)) StoreRelaxed(MaxLatency, latency);
+}
+
 // Run method executes all the protocols in the right order:
 // Startup, Check then Simulate
 void ManagerCommHandler::Run(CommunicationMode CommMode_In) {
     CommMode = CommMode_In;
 
+    Profiles.assign(TheModel.GetInterfacesNum(), InterfaceProfile());
+
+    // Busy polling applies to the component sockets, not to the monitors.
+    Comm.SetBusyPollTime(TheModel.GetSimParams().GetBusyPollTime());
+    ComponentRunTimes.assign(TheModel.GetComponentsNum(), 0.0);
+
+    if(!TraceDirectory.empty()) {
+        TLMTrace::Open(TraceDirectory, "manager");
+        TLMTrace::SetThreadName("main");
+    }
+
 #ifdef USE_THREADS
     pthread_attr_t attr;
     pthread_attr_init(&attr);
@@ -57,6 +147,18 @@ void ManagerCommHandler::Run(CommunicationMode CommMode_In) {
     pthread_join(writer, NULL);
 #endif
 
+    TLMTrace::Close();
+
+    ReportQueueStatistics();
+
+    if(CommMode == CoSimulationMode) {
+        ReportLinkStatistics();
+    }
+
+    if(!ProfileFile.empty() && CommMode == CoSimulationMode) {
+        WriteProfile();
+    }
+
     if(exceptionMsg.size() > 0) {
         throw(exceptionMsg);
     }
@@ -78,11 +180,286 @@ void ManagerCommHandler::HandleThreadException(const std::string &msg) {
     exceptionLock.unlock();
 }
 
+void ManagerCommHandler::ReportQueueStatistics() {
+    std::stringstream ss;
+    ss << "Send queue statistics: max depth per link = ";
+    if(MessageQueue.GetMaxDepth() > 0) {
+        ss << MessageQueue.GetMaxDepth();
+    }
+    else {
+        ss << "unbounded";
+    }
+    ss << ", high-water mark = " << MessageQueue.GetHighWaterMark()
+       << ", dropped monitor messages = " << MessageQueue.GetNumDropped();
+    TLMErrorLog::Info(ss.str());
+
+    std::vector<TLMQueueLinkStats> links;
+    MessageQueue.GetLinkStatistics(links);
+    for(size_t i = 0; i < links.size(); i++) {
+        const TLMQueueLinkStats& link = links[i];
+        if(link.InterfaceID < 0 || link.InterfaceID >= int(TheModel.GetInterfacesNum())) continue;
+
+        // Monitors get the data of the interface that sent it.
+        TLMInterfaceProxy& ifc = TheModel.GetTLMInterfaceProxy(link.InterfaceID);
+        TLMComponentProxy& comp = TheModel.GetTLMComponentProxy(ifc.GetComponentID());
+        std::stringstream ssLink;
+        ssLink << "Send queue of ";
+        // The component sockets are already closed, the monitor sockets are known.
+        if(std::find(MonitorSockets.begin(), MonitorSockets.end(), link.SocketHandle) != MonitorSockets.end()) {
+            ssLink << "monitor on socket " << link.SocketHandle << " for ";
+        }
+        ssLink << comp.GetName() << "." << ifc.GetName()
+               << ": high-water mark = " << link.HighWaterMark
+               << ", dropped = " << link.NumDropped;
+        TLMErrorLog::Info(ssLink.str());
+    }
+
+    TLMMessagePoolStats stats = GetMessagePoolStats();
+    std::stringstream ssPool;
+    ssPool << "Message pool statistics: live = " << stats.LiveBuffers << " (" << stats.LiveBytes << " bytes)"
+           << ", free = " << stats.FreeBuffers << " (" << stats.FreeBytes << " bytes)"
+           << ", peak = " << stats.PeakBytes << " bytes"
+           << ", allocations = " << stats.Allocations
+           << ", reuses = " << stats.Reuses
+           << ", trimmed = " << stats.Trimmed;
+    TLMErrorLog::Info(ssPool.str());
+}
+
+void ManagerCommHandler::UnpackWaitProfile(int compID, TLMMessage& mess) {
+    if(mess.Header.DataSize < int(sizeof(TLMCloseProfileHeader))
+       || mess.Header.DataSize % sizeof(double) != 0) {
+        return;
+    }
+    size_t numValues = mess.Header.DataSize / sizeof(double);
+
+    double* Next = (double*)(&mess.Data[0]);
+
+    // check if we have byte order missmatch in the message and perform
+    // swapping if needed
+    bool switch_byte_order =
+            (TLMMessageHeader::IsBigEndianSystem != mess.Header.SourceIsBigEndianSystem);
+    if(switch_byte_order) {
+        TLMCommUtil::ByteSwap(Next, sizeof(double), numValues);
+    }
+
+    // Older components send stale data with the close request.
+    const TLMCloseProfileHeader* header = (const TLMCloseProfileHeader*)Next;
+    if(header->Marker != TLM_CLOSE_PROFILE_MARKER) {
+        TLMErrorLog::Info("Close request of " + TheModel.GetTLMComponentProxy(compID).GetName()
+                          + " carries no profile, ignored.");
+        return;
+    }
+
+    ComponentRunTimes[compID] = header->RunTime;
+
+    // Newer versions append fields to the records, only the wait time is
+    // required. The records are read in the layout of this version.
+    size_t recordSize = size_t(header->RecordSize);
+    if(header->Version < 1 || recordSize < 3*sizeof(double) || recordSize % sizeof(double) != 0) {
+        TLMErrorLog::Warning("Unknown wait profile format from " + TheModel.GetTLMComponentProxy(compID).GetName()
+                             + ", ignored.");
+        return;
+    }
+    bool hasExtrapolations = (recordSize >= sizeof(TLMWaitProfile));
+
+    const char* records = (const char*)(header + 1);
+    size_t numProfiles = (mess.Header.DataSize - sizeof(TLMCloseProfileHeader)) / recordSize;
+    for(size_t i = 0; i < numProfiles; i++) {
+        TLMWaitProfile profile;
+        memcpy(&profile, records + i*recordSize, std::min(recordSize, sizeof(TLMWaitProfile)));
+
+        int id = int(profile.InterfaceID);
+        if(id < 0 || id >= int(Profiles.size())) continue;
+        if(TheModel.GetTLMInterfaceProxy(id).GetComponentID() != compID) continue;
+
+        StoreRelaxed(Profiles[id].WaitTime, profile.WaitTime);
+        StoreRelaxed(Profiles[id].NumWaits, int(profile.NumWaits));
+        if(hasExtrapolations) {
+            StoreRelaxed(Profiles[id].NumExtrapolations, int(profile.NumBackward + profile.NumForward));
+        }
+    }
+}
+
+size_t ManagerCommHandler::GetTimeDataRecordSize(TLMInterfaceProxy& ifc) {
+    if(ifc.GetDimensions() == 6) {
+        return sizeof(TLMTimeData3D);
+    }
+    else if(ifc.GetDimensions() == 1 && ifc.GetCausality() == "bidirectional") {
+        return sizeof(TLMTimeData1D);
+    }
+    return sizeof(TLMTimeDataSignal);
+}
+
+void ManagerCommHandler::UpdateLinkStatistics(TLMMessage& message) {
+    int srcID = message.Header.TLMInterfaceID;
+    if(srcID < 0 || srcID >= int(Profiles.size())) return;
+
+    int destID = TheModel.GetTLMInterfaceProxy(srcID).GetLinkedID();
+    if(destID < 0) return;
+
+    InterfaceProfile& link = Profiles[destID];
+    link.AddArrival(message.ReceiveTime, sizeof(TLMMessageHeader) + message.Header.DataSize);
+
+    // The records start with the time, the last one is the latest.
+    size_t recordSize = RecordSizes[srcID];
+    size_t numRecords = message.Header.DataSize / recordSize;
+    if(numRecords == 0) return;
+
+    double time;
+    memcpy(&time, &message.Data[(numRecords-1)*recordSize], sizeof(double));
+    if(TLMMessageHeader::IsBigEndianSystem != message.Header.SourceIsBigEndianSystem) {
+        TLMCommUtil::ByteSwap(&time, sizeof(double));
+    }
+    StoreRelaxed(link.SentTime, time);
+
+    // The data sent by the other side is forwarded to the sending interface.
+    const InterfaceProfile& back = Profiles[srcID];
+    if(LoadRelaxed(back.NumMessages) > 0) {
+        link.AddLead(time - LoadRelaxed(back.SentTime));
+    }
+}
+
+void ManagerCommHandler::GetLinkStatistics(std::vector<TLMLinkStatistics>& stats) {
+    stats.clear();
+    for(int i = 0; i < int(Profiles.size()); i++) {
+        int linkedID = TheModel.GetTLMInterfaceProxy(i).GetLinkedID();
+        if(linkedID < 0) continue;
+
+        const InterfaceProfile& prof = Profiles[i];
+        uint64_t numMessages = LoadRelaxed(prof.NumMessages);
+        uint64_t numLeads = LoadRelaxed(prof.NumLeads);
+        uint64_t numForwarded = LoadRelaxed(prof.NumForwarded);
+
+        TLMLinkStatistics link;
+        link.InterfaceID = i;
+        link.LinkedID = linkedID;
+        link.NumMessages = double(numMessages);
+        link.NumBytes = double(LoadRelaxed(prof.NumBytes));
+        link.MinInterArrival = LoadRelaxed(prof.MinInterArrival);
+        link.AvgInterArrival = (numMessages > 1) ? LoadRelaxed(prof.SumInterArrival)/(numMessages-1) : 0.0;
+        link.MaxInterArrival = LoadRelaxed(prof.MaxInterArrival);
+        link.MinLead = LoadRelaxed(prof.MinLead);
+        link.AvgLead = (numLeads > 0) ? LoadRelaxed(prof.SumLead)/numLeads : 0.0;
+        link.MaxLead = LoadRelaxed(prof.MaxLead);
+        link.NumExtrapolations = LoadRelaxed(prof.NumExtrapolations);
+        link.WaitTime = LoadRelaxed(prof.WaitTime);
+        link.AvgLatency = (numForwarded > 0) ? LoadRelaxed(prof.SumLatency)/numForwarded : 0.0;
+        link.MaxLatency = LoadRelaxed(prof.MaxLatency);
+        stats.push_back(link);
+    }
+}
+
+void ManagerCommHandler::PackLinkStatisticsMessage(TLMMessage& message) {
+    std::vector<TLMLinkStatistics> stats;
+    GetLinkStatistics(stats);
+
+    message.Header.MessageType = TLMMessageTypeConst::TLM_LINK_STATISTICS;
+    message.Header.TLMInterfaceID = -1;
+    message.Header.SourceIsBigEndianSystem = TLMMessageHeader::IsBigEndianSystem;
+    message.Header.DataSize = int(stats.size() * sizeof(TLMLinkStatistics));
+    message.Data.resize(message.Header.DataSize);
+    if(!stats.empty()) {
+        memcpy(&message.Data[0], &stats[0], message.Header.DataSize);
+    }
+}
+
+void ManagerCommHandler::ReportLinkStatistics() {
+    std::vector<TLMLinkStatistics> stats;
+    GetLinkStatistics(stats);
+
+    for(size_t i = 0; i < stats.size(); i++) {
+        const TLMLinkStatistics& link = stats[i];
+        TLMInterfaceProxy& ifc = TheModel.GetTLMInterfaceProxy(int(link.InterfaceID));
+        TLMInterfaceProxy& linked = TheModel.GetTLMInterfaceProxy(int(link.LinkedID));
+
+        std::stringstream ss;
+        ss << "Link " << TheModel.GetTLMComponentProxy(linked.GetComponentID()).GetName() << "." << linked.GetName()
+           << " -> " << TheModel.GetTLMComponentProxy(ifc.GetComponentID()).GetName() << "." << ifc.GetName()
+           << ": messages = " << link.NumMessages << " (" << link.NumBytes << " bytes)"
+           << ", inter-arrival min/avg/max = " << link.MinInterArrival << "/" << link.AvgInterArrival
+           << "/" << link.MaxInterArrival << " s"
+           << ", lead min/avg/max = " << link.MinLead << "/" << link.AvgLead << "/" << link.MaxLead
+           << ", extrapolations = " << link.NumExtrapolations;
+        TLMErrorLog::Info(ss.str());
+    }
+}
+
+void ManagerCommHandler::WriteProfile() {
+    std::ofstream out(ProfileFile.c_str());
+    if(!out.good()) {
+        TLMErrorLog::Warning("Failed to open profile file " + ProfileFile);
+        return;
+    }
+
+    out << "# TLM co-simulation profile, times in seconds\n";
+    out << "simulation," << SimulationWallTime << "\n";
+
+    // component,<name>,<run time>
+    for(int i = 0; i < TheModel.GetComponentsNum(); i++) {
+        out << "component," << TheModel.GetTLMComponentProxy(i).GetName() << ","
+            << ComponentRunTimes[i] << "\n";
+    }
+
+    // interface,<name>,<linked name>,<wait time>,<waits>,<messages>,
+    //   <total residence>,<max residence>,<total latency>,<max latency>
+    for(int i = 0; i < int(TheModel.GetInterfacesNum()); i++) {
+        TLMInterfaceProxy& ifc = TheModel.GetTLMInterfaceProxy(i);
+        if(ifc.GetLinkedID() < 0) continue;
+
+        TLMInterfaceProxy& linked = TheModel.GetTLMInterfaceProxy(ifc.GetLinkedID());
+        const InterfaceProfile& prof = Profiles[i];
+
+        out << "interface,"
+            << TheModel.GetTLMComponentProxy(ifc.GetComponentID()).GetName() << "." << ifc.GetName() << ","
+            << TheModel.GetTLMComponentProxy(linked.GetComponentID()).GetName() << "." << linked.GetName() << ","
+            << LoadRelaxed(prof.WaitTime) << "," << LoadRelaxed(prof.NumWaits) << ","
+            << LoadRelaxed(prof.NumForwarded) << ","
+            << LoadRelaxed(prof.SumResidence) << "," << LoadRelaxed(prof.MaxResidence) << ","
+            << LoadRelaxed(prof.SumLatency) << "," << LoadRelaxed(prof.MaxLatency) << "\n";
+    }
+
+    // link,<from>,<to>,<messages>,<bytes>,<min/avg/max inter-arrival>,
+    //   <min/avg/max lead>,<extrapolations>
+    std::vector<TLMLinkStatistics> stats;
+    GetLinkStatistics(stats);
+    for(size_t i = 0; i < stats.size(); i++) {
+        const TLMLinkStatistics& link = stats[i];
+        TLMInterfaceProxy& ifc = TheModel.GetTLMInterfaceProxy(int(link.InterfaceID));
+        TLMInterfaceProxy& linked = TheModel.GetTLMInterfaceProxy(int(link.LinkedID));
+
+        out << "link,"
+            << TheModel.GetTLMComponentProxy(linked.GetComponentID()).GetName() << "." << linked.GetName() << ","
+            << TheModel.GetTLMComponentProxy(ifc.GetComponentID()).GetName() << "." << ifc.GetName() << ","
+            << link.NumMessages << "," << link.NumBytes << ","
+            << link.MinInterArrival << "," << link.AvgInterArrival << "," << link.MaxInterArrival << ","
+            << link.MinLead << "," << link.AvgLead << "," << link.MaxLead << ","
+            << link.NumExtrapolations << "\n";
+    }
+
+    TLMErrorLog::Info("Profile written to " + ProfileFile);
+}
+
 bool ManagerCommHandler::GotException(std::string &msg) {
     msg = exceptionMsg;
     return (msg.size() > 0);
 }
 
+// PlaceThread pins the calling manager thread to one of the manager CPUs,
+// taken in turn, and sets its scheduling policy.
+void ManagerCommHandler::PlaceThread(int index) {
+    const SimulationParams& params = TheModel.GetSimParams();
+
+    std::vector<int> cpus;
+    TLMScheduling::ParseCPUList(params.GetManagerCPUs(), cpus);
+    if(!cpus.empty()) {
+        std::vector<int> cpu(1, cpus[index % cpus.size()]);
+        TLM_LOG_INFO("Pinning manager thread " + TLMErrorLog::ToStdStr(index) + " to CPU " + TLMErrorLog::ToStdStr(cpu[0]));
+        TLMScheduling::SetThreadAffinity(cpu);
+    }
+
+    TLMScheduling::SetThreadScheduling(params.GetSchedulingPolicy(), params.GetSchedulingPriority());
+}
+
 // RunStartupProtocol implements startup protocol that
 // enables client registration at the manager
 void ManagerCommHandler::RunStartupProtocol() {
@@ -476,12 +853,36 @@ void ManagerCommHandler::SetupInterfaceRequestMessage(TLMMessage& mess) {
 }
 
 
+int ManagerCommHandler::ResumeComponents() {
+    int nPaused = 0;
+    int sendingSocket = MessageQueue.GetSendingSocket();
+    for(int iSock = 0; iSock < TheModel.GetComponentsNum(); iSock++) {
+        std::pair<int,int>& link = FullLinks[iSock];
+        if(link.first < 0) continue;
+
+        int hdl = TheModel.GetTLMComponentProxy(iSock).GetSocketHandle();
+        if(hdl == sendingSocket || !MessageQueue.IsLinkFull(link.first, link.second)) {
+            link = std::make_pair(-1, -1);
+            Comm.AddActiveSocket(hdl);
+        }
+        else {
+            nPaused++;
+        }
+    }
+    return nPaused;
+}
+
 // ReaderThreadRun processes incomming messages and creates
 // messages to be sent.
 void ManagerCommHandler::ReaderThreadRun() {
+    TLMTrace::SetThreadName("reader");
+    PlaceThread(0);
 
     // Handle start-up
-    RunStartupProtocol();
+    {
+        TLMTraceScope trace(TraceRegistration);
+        RunStartupProtocol();
+    }
 
     // Check that startup completed correctly
     int StartupOK = TheModel.CheckProxyComm();
@@ -507,10 +908,29 @@ void ManagerCommHandler::ReaderThreadRun() {
     Comm.SwitchToRunningMode();
     runningMode = RunMode;
 
+    // Record sizes of the time data, used for the link statistics.
+    RecordSizes.resize(TheModel.GetInterfacesNum());
+    for(int i = 0; i < int(TheModel.GetInterfacesNum()); i++) {
+        RecordSizes[i] = GetTimeDataRecordSize(TheModel.GetTLMInterfaceProxy(i));
+    }
+
+    // Setup timer for the profile.
+    tTM_Info tInfo;
+    TM_Init(&tInfo);
+    TM_Start(&tInfo);
+
     int nClosedSock = 0;
     std::vector<int> closedSockets;
+    FullLinks.assign(TheModel.GetComponentsNum(), std::make_pair(-1, -1));
     while(nClosedSock < TheModel.GetComponentsNum() || DisconnectedMonitors.size() < MonitorSockets.size()) {
-        Comm.SelectReadSocket(); // wait for a change
+        // The writer does not signal the reader when a link gets room, so
+        // paused components are checked again every millisecond.
+        if(ResumeComponents() > 0) {
+            Comm.SelectReadSocket(0.001);
+        }
+        else {
+            Comm.SelectReadSocket(); // wait for a change
+        }
 
         for(int iSock =  TheModel.GetComponentsNum() - 1; iSock >= 0; --iSock) {
             TLMComponentProxy& comp = TheModel.GetTLMComponentProxy(iSock);
@@ -519,23 +939,57 @@ void ManagerCommHandler::ReaderThreadRun() {
             if((std::find(closedSockets.begin(), closedSockets.end(), iSock) == closedSockets.end())
                && (hdl != 0) && Comm.HasData(hdl)) { // there is data to be received on the socket
 
-                TLMMessage* message = MessageQueue.GetReadSlot();
+                // Receive the header first so that the data buffer
+                // can be taken from the matching size class.
+                TLMMessageHeader header;
+                double traceStart = TLMTrace::IsEnabled() ? TLMTrace::Now() : -1.0;
+                bool received = TLMCommUtil::ReceiveMessageHeader(hdl, header);
+
+                TLMMessage* message = MessageQueue.GetReadSlot(received ? header.DataSize : 0);
                 message->SocketHandle = hdl;
-                if(TLMCommUtil::ReceiveMessage(*message)) {
+                message->Header = header;
+                if(received && TLMCommUtil::ReceiveMessageData(*message)) {
+                    // The latency of the forwarded message is measured from here.
+                    message->ReceiveTime = TLMCommUtil::GetWallClockTime();
+
+                    if(traceStart >= 0.0) {
+                        TLMTrace::AddEvent(TraceReceive, traceStart, TLMTrace::Now(),
+                                           header.TLMInterfaceID, header.MessageType);
+                    }
+
                     if(message->Header.MessageType == TLMMessageTypeConst::TLM_CLOSE_REQUEST) {
+                        UnpackWaitProfile(iSock, *message);
                         MessageQueue.ReleaseSlot(message);
                         TLMErrorLog::Info("Received close permission request from "+comp.GetName());
                         closedSockets.push_back(iSock);
                         nClosedSock++;
                     }
                     else if(CommMode == CoSimulationMode) {
+                        // Record the results before the message is marshaled,
+                        // the header still holds the sender interface ID.
+                        if(Recorder != NULL) {
+                            Recorder->RecordTimeData(*message);
+                        }
+
+                        if(message->Header.MessageType == TLMMessageTypeConst::TLM_TIME_DATA) {
+                            UpdateLinkStatistics(*message);
+                        }
+
                         MarshalMessage(*message);
 
                         // Forward message for monitoring.
                         ForwardToMonitor(*message);
 
-                        // Place in send buffer
+                        // Place in send buffer, the writer may release it at once.
+                        bool isTimeData = (message->Header.MessageType == TLMMessageTypeConst::TLM_TIME_DATA);
+                        std::pair<int,int> link(message->SocketHandle, message->Header.TLMInterfaceID);
                         MessageQueue.PutWriteSlot(message);
+
+                        // Stop reading the component until its link has room.
+                        if(isTimeData && MessageQueue.IsLinkFull(link.first, link.second)) {
+                            FullLinks[iSock] = link;
+                            Comm.PauseActiveSocket(hdl);
+                        }
                     }
                     else {
                         // CommMode == InterfaceRequestMode
@@ -554,6 +1008,17 @@ void ManagerCommHandler::ReaderThreadRun() {
 
     TLMErrorLog::Info("Simulation complete.");
 
+    TM_Stop(&tInfo);
+    SimulationWallTime = tInfo.total.tv_sec + tInfo.total.tv_nsec/1.0e9;
+
+    if(Recorder != NULL) {
+        Recorder->Close();
+    }
+
+    // The time data still queued for the components must be sent before
+    // they are allowed to close their sockets.
+    MessageQueue.WaitUntilSent();
+
     for(int iSock : closedSockets) {
       TLMMessage message;
       TLMComponentProxy& comp = TheModel.GetTLMComponentProxy(iSock);
@@ -585,12 +1050,25 @@ void ManagerCommHandler::ReaderThreadRun() {
 }
 
 void ManagerCommHandler::WriterThreadRun() {
+    TLMTrace::SetThreadName("writer");
+    PlaceThread(1);
 
     TLMMessage* tlm_mess = 0;
     TLMErrorLog::Info(string("TLM manager is ready to send messages"));
 
     while((tlm_mess = MessageQueue.GetWriteSlot()) != NULL) {
-        TLMCommUtil::SendMessage(*tlm_mess);
+        // Only the forwarded time data has a receive time, not the monitor messages.
+        double sendTime = (tlm_mess->ReceiveTime > 0.0) ? TLMCommUtil::GetWallClockTime() : 0.0;
+
+        // Monitor messages share their data with the forwarded message.
+        TLMCommUtil::SendMessage(tlm_mess->SocketHandle, tlm_mess->Header, MessageQueue.GetSlotData(tlm_mess));
+
+        int destID = tlm_mess->Header.TLMInterfaceID;
+        if(sendTime > 0.0 && tlm_mess->Header.MessageType == TLMMessageTypeConst::TLM_TIME_DATA
+           && destID >= 0 && destID < int(Profiles.size())) {
+            Profiles[destID].AddMessage(sendTime - tlm_mess->ReceiveTime,
+                                        TLMCommUtil::GetWallClockTime() - tlm_mess->ReceiveTime);
+        }
         //TLMMessage &mm = *tlm_mess;
         //TLMCommUtil::SendMessage(mm);
         MessageQueue.ReleaseSlot(tlm_mess);
@@ -625,7 +1103,7 @@ void ManagerCommHandler::MarshalMessage(TLMMessage& message) {
         message.SocketHandle = destComp.GetSocketHandle();
         message.Header.TLMInterfaceID = destID;
 
-        if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
+        if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
             TLMErrorLog::Info(string("Forwarding from " +
                                     TheModel.GetTLMComponentProxy(src.GetComponentID()).GetName() + '.'+
                                     src.GetName()
@@ -714,13 +1192,30 @@ void ManagerCommHandler::UnpackAndStoreTimeData(TLMMessage& message) {
 }
 
 
-int ManagerCommHandler::ProcessInterfaceMonitoringMessage(TLMMessage& message) {
+int ManagerCommHandler::ProcessInterfaceMonitoringMessage(TLMMessage& message, double& samplingInterval) {
     if(message.Header.MessageType != TLMMessageTypeConst::TLM_REG_INTERFACE) {
         TLMErrorLog::FatalError("Interface monitoring registration message expected");
     }
     
+    // The name is ended by a zero character if a monitor request follows.
+    const char* spec = (const char*)(& message.Data[0]);
+    size_t specLength = 0;
+    while(specLength < size_t(message.Header.DataSize) && spec[specLength] != 0) {
+        specLength++;
+    }
+
+    samplingInterval = 0.0;
+    if(size_t(message.Header.DataSize) >= specLength + 1 + sizeof(TLMMonitorRequest)) {
+        TLMMonitorRequest request;
+        memcpy(&request, spec + specLength + 1, sizeof(TLMMonitorRequest));
+        if(TLMMessageHeader::IsBigEndianSystem != message.Header.SourceIsBigEndianSystem) {
+            TLMCommUtil::ByteSwap(&request, sizeof(double), sizeof(TLMMonitorRequest)/sizeof(double));
+        }
+        if(request.SamplingInterval > 0.0) samplingInterval = request.SamplingInterval;
+    }
+
     // First, find the interface in the meta model
-    string aNameAndType ((const char*)(& message.Data[0]), message.Header.DataSize);
+    string aNameAndType (spec, specLength);
     string aName, type;
     bool readingType=false;
     for(size_t i=0; i<aNameAndType.size(); ++i) {
@@ -769,10 +1264,101 @@ int ManagerCommHandler::ProcessInterfaceMonitoringMessage(TLMMessage& message) {
     return IfcID;
 }
 
+MonitorSubscription::MonitorSubscription(int hdl, double samplingInterval, double startTime,
+                                         double delay, size_t recordSize) :
+    SocketHandle(hdl),
+    SamplingInterval(samplingInterval),
+    StartTime(startTime),
+    Delay(delay),
+    RecordSize(recordSize),
+    NextNeededTime(startTime - 2*delay),
+    PrevRecord(),
+    HavePrev(false),
+    PrevSent(false)
+{
+}
+
+// Returns the first sampling instant strictly after "time". The monitor requests
+// data at StartTime + k*SamplingInterval, which translates to interface data at
+// one delay (current wave) and two delays (damped wave) before that instant.
+double MonitorSubscription::NextSampleTime(double time) const {
+    const double offsets[2] = { Delay, 2*Delay };
+    double next = 0.0;
+    for(int i = 0; i < 2; i++) {
+        double k = floor((time + offsets[i] - StartTime)/SamplingInterval) + 1.0;
+        double t = StartTime + k*SamplingInterval - offsets[i];
+        while(t <= time) {
+            k += 1.0;
+            t = StartTime + k*SamplingInterval - offsets[i];
+        }
+        if(i == 0 || t < next) next = t;
+    }
+    return next;
+}
+
+// Select the records of "in" that bracket the sampling instants. The last record
+// before an instant and the first record after it are forwarded. Since the
+// record before may come from an earlier message it is kept in PrevRecord.
+int MonitorSubscription::Decimate(const TLMMessage& in, TLMMessage& out) {
+    if(in.Header.DataSize <= 0 || in.Header.DataSize % RecordSize != 0) {
+        return 0;
+    }
+
+    // Tolerance so that a monitor request drifting slightly past a sample,
+    // due to accumulated time steps, still finds its right bracket.
+    const double tol = 1e-6*SamplingInterval;
+
+    const int nRecords = in.Header.DataSize / RecordSize;
+    int nOut = 0;
+
+    out.Header = in.Header;
+    if(out.Data.size() < size_t(in.Header.DataSize) + RecordSize) {
+        out.Data.resize(in.Header.DataSize + RecordSize);
+    }
+
+    const unsigned char* rec = &in.Data[0];
+    for(int i = 0; i < nRecords; i++, rec += RecordSize) {
+        double time;
+        memcpy(&time, rec, sizeof(double)); // time is the first field of all time data records
+
+        if(time >= NextNeededTime + tol) {
+            // This record is the right bracket, the previous one the left bracket
+            if(HavePrev && !PrevSent) {
+                memcpy(&out.Data[nOut*RecordSize], &PrevRecord[0], RecordSize);
+                nOut++;
+            }
+            memcpy(&out.Data[nOut*RecordSize], rec, RecordSize);
+            nOut++;
+            PrevSent = true;
+
+            NextNeededTime = NextSampleTime(time);
+        }
+        else if(!HavePrev) {
+            // Always forward the first record.
+            memcpy(&out.Data[nOut*RecordSize], rec, RecordSize);
+            nOut++;
+            PrevSent = true;
+        }
+        else {
+            PrevSent = false;
+        }
+
+        PrevRecord.assign(rec, rec + RecordSize);
+        HavePrev = true;
+    }
+
+    out.Header.DataSize = nOut*RecordSize;
+    return nOut;
+}
+
 void ManagerCommHandler::ForwardToMonitor(TLMMessage& message) {
     if(MonitorsDisconnected)
         return;
 
+    // The messages are queued after the lock is released.
+    std::vector<TLMMessage*> monitorMessages;
+    std::vector<bool> mayDrop;
+
     monitorMapLock.lock();
 
     // We forward to the sender!
@@ -786,44 +1372,82 @@ void ManagerCommHandler::ForwardToMonitor(TLMMessage& message) {
         }
 
         // Forward to all connected monitoring ports
-        multimap<int,int>::iterator pos;
+        multimap<int,MonitorSubscription>::iterator pos;
         for(pos = monitorInterfaceMap.lower_bound(TLMInterfaceID);
              pos != monitorInterfaceMap.upper_bound(TLMInterfaceID);
              pos++) {
             
-            if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
+            MonitorSubscription& sub = pos->second;
+            int hdl = sub.SocketHandle;
+
+            // Decimated feeds only get the samples bracketing the sampling instants.
+            // Data in foreign byte order is forwarded as is.
+            if(sub.IsDecimated() && message.Header.SourceIsBigEndianSystem == TLMMessageHeader::IsBigEndianSystem) {
+                TLMMessage* newMessage = MessageQueue.GetReadSlot(message.Header.DataSize);
+                int nRecords = sub.Decimate(message, *newMessage);
+                if(nRecords == 0) {
+                    MessageQueue.ReleaseSlot(newMessage);
+                    continue;
+                }
+
+                if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
+                    TLMErrorLog::Info("Forwarding " + TLMErrorLog::ToStdStr(nRecords) + " samples to monitor, interface "
+                                      + TLMErrorLog::ToStdStr(TLMInterfaceID)
+                                      + " on socket " + TLMErrorLog::ToStdStr(hdl));
+                }
+
+                newMessage->SocketHandle = hdl;
+                newMessage->Header.TLMInterfaceID = TLMInterfaceID;
+
+                // The subscription has moved on past these samples, dropping them
+                // would leave the monitor without both sides of a bracket.
+                monitorMessages.push_back(newMessage);
+                mayDrop.push_back(false);
+                continue;
+            }
+
+            if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
                 TLMErrorLog::Info("Forwarding to monitor, interface " + TLMErrorLog::ToStdStr(TLMInterfaceID)
-                                  + " on socket " + TLMErrorLog::ToStdStr(pos->second));
+                                  + " on socket " + TLMErrorLog::ToStdStr(hdl));
             }
             
-            int hdl = pos->second;
-            
-            TLMMessage* newMessage = MessageQueue.GetReadSlot();
+            // The data is shared with the forwarded message, only the
+            // header is rewritten for each monitor.
+            TLMMessage* newMessage = MessageQueue.GetSharedSlot(&message);
 
             newMessage->SocketHandle = hdl;
-            memcpy(&newMessage->Header, &message.Header, sizeof(TLMMessageHeader));
             newMessage->Header.TLMInterfaceID = TLMInterfaceID;
 
-            newMessage->Header.DataSize = message.Header.DataSize;
-            if(newMessage->Data.size() < newMessage->Header.DataSize) {
-                newMessage->Data.resize(newMessage->Header.DataSize);
-            }
-            
-            memcpy(&newMessage->Data[0], &message.Data[0], newMessage->Header.DataSize);
-
-            MessageQueue.PutWriteSlot(newMessage);
+            monitorMessages.push_back(newMessage);
+            mayDrop.push_back(true);
         }
     }
     else {
-        if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
+        if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
             TLMErrorLog::Info("Nothing to forward for monitor interface " + TLMErrorLog::ToStdStr(TLMInterfaceID));
         }
     }
     monitorMapLock.unlock();
+
+    // A monitor that does not keep up loses full rate messages, it never holds
+    // back the reader and, through it, the co-simulation. Decimated messages
+    // only carry the bracketing samples and are always queued.
+    for(size_t i = 0; i < monitorMessages.size(); i++) {
+        int hdl = monitorMessages[i]->SocketHandle;
+        if(!mayDrop[i]) {
+            MessageQueue.PutWriteSlot(monitorMessages[i]);
+        }
+        else if(!MessageQueue.TryPutWriteSlot(monitorMessages[i]) && TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
+            TLMErrorLog::Info("Monitor queue full, message dropped for interface " + TLMErrorLog::ToStdStr(TLMInterfaceID)
+                              + " on socket " + TLMErrorLog::ToStdStr(hdl));
+        }
+    }
 }
 
 
 void ManagerCommHandler::MonitorThreadRun() {
+    TLMTrace::SetThreadName("monitor");
+    PlaceThread(2);
     TLMErrorLog::Info("In monitoring");
     
     if(TheModel.GetSimParams().GetMonitorPort() <= 0) {
@@ -897,7 +1521,18 @@ void ManagerCommHandler::MonitorThreadRun() {
             message->SocketHandle = hdl;
             
             if(!TLMCommUtil::ReceiveMessage(*message)) {
-                TLMErrorLog::Warning("Failed to get message from monitor, disconected?");
+                std::vector<int>::iterator query = std::find(QuerySockets.begin(), QuerySockets.end(), hdl);
+                if(query != QuerySockets.end()) {
+                    // Statistics queries disconnect without a close request.
+                    TLMErrorLog::Info("Statistics query connection closed.");
+                    monitorMapLock.lock();
+                    MonitorSockets.erase(std::find(MonitorSockets.begin(), MonitorSockets.end(), hdl));
+                    QuerySockets.erase(query);
+                    monitorMapLock.unlock();
+                }
+                else {
+                    TLMErrorLog::Warning("Failed to get message from monitor, disconected?");
+                }
                 //abort();
                 monComm.DropActiveSocket(hdl);
                 MessageQueue.ReleaseSlot(message);
@@ -919,8 +1554,17 @@ void ManagerCommHandler::MonitorThreadRun() {
                 monitorMapLock.unlock();
                 MessageQueue.ReleaseSlot(message);
             }
+            else if(message->Header.MessageType == TLMMessageTypeConst::TLM_LINK_STATISTICS) {
+                TLMErrorLog::Info("Received link statistics request from monitor.");
+                PackLinkStatisticsMessage(*message);
+                MessageQueue.PutWriteSlot(message);
+                if(std::find(QuerySockets.begin(), QuerySockets.end(), hdl) == QuerySockets.end()) {
+                    QuerySockets.push_back(hdl);
+                }
+            }
             else {
-                int IfcID = ProcessInterfaceMonitoringMessage(*message);
+                double samplingInterval = 0.0;
+                int IfcID = ProcessInterfaceMonitoringMessage(*message, samplingInterval);
                 MessageQueue.PutWriteSlot(message);
 
                 if(IfcID >= 0) {
@@ -945,8 +1589,21 @@ void ManagerCommHandler::MonitorThreadRun() {
                     else {
                     }
 #else
+                    TLMInterfaceProxy& ifc = TheModel.GetTLMInterfaceProxy(IfcID);
+                    double delay = TheModel.GetTLMConnection(ifc.GetConnectionID()).GetParams().Delay;
+
+                    size_t recordSize = GetTimeDataRecordSize(ifc);
+
+                    if(samplingInterval > 0.0) {
+                        TLMErrorLog::Info("Monitor sampling interval for interface " + ToStr(IfcID)
+                                          + " is " + TLMErrorLog::ToStdStr(samplingInterval));
+                    }
+
+                    MonitorSubscription sub(hdl, samplingInterval, TheModel.GetSimParams().GetStartTime(),
+                                            delay, recordSize);
+
                     monitorMapLock.lock();
-                    monitorInterfaceMap.insert(std::make_pair(IfcID, hdl));
+                    monitorInterfaceMap.insert(std::make_pair(IfcID, sub));
                     monitorMapLock.unlock();
 #endif
 
@@ -11,11 +11,15 @@
 #include <string>
 #include <map>
 // note: <map> must be above all, because of a VC2005 bug (on _Wherenode)
+#include <vector>
+#include <atomic>
+#include <stdint.h>
 
 #include "Communication/TLMCommUtil.h"
 #include "Communication/TLMManagerComm.h"
 #include "Communication/TLMMessageQueue.h"
 #include "CompositeModels/CompositeModel.h"
+#include "Logging/TLMResultRecorder.h"
 
 #include "TLMThreadSynch.h"
 
@@ -23,6 +27,145 @@
 #include <unistd.h>
 #endif
 
+//! \class MonitorSubscription
+//! MonitorSubscription keeps the state of one monitored interface for one
+//! monitoring connection. A subscription with a positive sampling interval
+//! only receives the time data samples that bracket the instants the monitor
+//! will request, i.e., StartTime + k*SamplingInterval shifted back by one and
+//! two TLM delays (the monitor also evaluates the damped, delayed wave).
+class MonitorSubscription {
+public:
+    //! Constructor.
+    //! \param hdl Socket handle of the monitoring connection.
+    //! \param samplingInterval Monitor sampling interval, 0 to forward all messages.
+    //! \param startTime Simulation start time, i.e., the first sampling instant.
+    //! \param delay TLM delay of the monitored connection.
+    //! \param recordSize Size in bytes of one time data record of the interface.
+    MonitorSubscription(int hdl, double samplingInterval, double startTime, double delay, size_t recordSize);
+
+    //! Socket handle of the monitoring connection.
+    int SocketHandle;
+
+    //! Sampling interval, 0 means no decimation.
+    double SamplingInterval;
+
+    //! Check if this subscription decimates the forwarded time data.
+    bool IsDecimated() const { return SamplingInterval > 0.0 && RecordSize > 0; }
+
+    //! Select the records of "in" that are needed by the monitor and copy them
+    //! into "out" (header included). Returns the number of records copied,
+    //! 0 means that nothing needs to be forwarded.
+    int Decimate(const TLMMessage& in, TLMMessage& out);
+
+private:
+    //! Returns the first sampling instant strictly after "time".
+    double NextSampleTime(double time) const;
+
+    //! First sampling instant.
+    double StartTime;
+
+    //! TLM delay of the monitored connection.
+    double Delay;
+
+    //! Size in bytes of one time data record.
+    size_t RecordSize;
+
+    //! Next instant that must be bracketed by forwarded samples.
+    double NextNeededTime;
+
+    //! The last record received, needed as left bracket of the next instant.
+    std::vector<unsigned char> PrevRecord;
+
+    //! True if PrevRecord contains a record.
+    bool HavePrev;
+
+    //! True if PrevRecord was already forwarded.
+    bool PrevSent;
+};
+
+//! Update of a counter that has a single writer thread, the other
+//! threads only read it. No read-modify-write operation is needed.
+template<typename T>
+inline void StoreRelaxed(std::atomic<T>& counter, T value) {
+    counter.store(value, std::memory_order_relaxed);
+}
+
+template<typename T>
+inline T LoadRelaxed(const std::atomic<T>& counter) {
+    return counter.load(std::memory_order_relaxed);
+}
+
+//! \struct InterfaceProfile
+//! InterfaceProfile collects the statistics of the time data forwarded to
+//! one interface, i.e., of the link from the interface it is connected to,
+//! and the time the component owning the interface spent waiting for it,
+//! reported by the component at close. The arrival statistics are updated
+//! by the reader thread, the forwarding statistics by the writer thread.
+//! The monitor thread reads them at any time, hence the atomic counters.
+//! The two groups are kept on separate cache lines.
+struct InterfaceProfile {
+    // Updated by the reader thread.
+
+    //! Number of time data messages and their total size including the headers.
+    std::atomic<uint64_t> NumMessages, NumBytes;
+
+    //! Wall clock time of the last arrival and the time between two arrivals.
+    std::atomic<double> LastArrival, MinInterArrival, SumInterArrival, MaxInterArrival;
+
+    //! Latest simulation time in the data sent over the link.
+    std::atomic<double> SentTime;
+
+    //! Lead of the sender's simulation time over the receiver's when a message arrives.
+    std::atomic<uint64_t> NumLeads;
+    std::atomic<double> MinLead, SumLead, MaxLead;
+
+    //! Time the component waited for data on this interface.
+    std::atomic<double> WaitTime;
+
+    //! Number of times the component waited.
+    std::atomic<int> NumWaits;
+
+    //! Number of requests the interface extrapolated, reported by the component at close.
+    std::atomic<int> NumExtrapolations;
+
+    //! Keeps the writer thread counters off the cache line of the reader thread counters.
+    char Padding[64];
+
+    // Updated by the writer thread.
+
+    //! Number of time data messages sent on to this interface.
+    std::atomic<uint64_t> NumForwarded;
+
+    //! Total and maximum time the messages spent in the send queue.
+    std::atomic<double> SumResidence, MaxResidence;
+
+    //! Total and maximum time from receiving a message until it was sent on.
+    std::atomic<double> SumLatency, MaxLatency;
+
+    //! Keeps the next profile off this cache line.
+    char PaddingEnd[64];
+
+    InterfaceProfile() { Clear(); }
+
+    InterfaceProfile(const InterfaceProfile& other) { *this = other; }
+
+    //! Copy the counters, only safe while no other thread updates them.
+    InterfaceProfile& operator=(const InterfaceProfile& other);
+
+    //! Reset all counters.
+    void Clear();
+
+    //! Add the arrival of a message of "size" bytes at wall clock time "now"
+    //! (reader thread).
+    void AddArrival(double now, size_t size);
+
+    //! Add the lead of the sender over the receiver (reader thread).
+    void AddLead(double lead);
+
+    //! Add the timing of one forwarded message (writer thread).
+    void AddMessage(double residence, double latency);
+};
+
 //! \class ManagerCommHandler
 //! ManagerCommHandler class implements the communication protocol 
 //! It uses the classes defined in TLMManagerComm.h
@@ -51,12 +194,44 @@ private:
     //! The mode of communication either real co-simulation or interface information request.
     CommunicationMode CommMode;
 
-    //! The multimap to store monitoring interface sockets.
-    std::multimap<int,int> monitorInterfaceMap;
+    //! The multimap to store monitoring subscriptions (interface ID to monitor socket).
+    std::multimap<int,MonitorSubscription> monitorInterfaceMap;
 
     //! The multimap mutex for synchronisation of "monitorInterfaceMap" access
     SimpleLock monitorMapLock;
 
+    //! Optional recorder of the simulation results, fed by the reader thread.
+    TLMResultRecorder* Recorder;
+
+    //! Profile file name, no profile is written if empty.
+    std::string ProfileFile;
+
+    //! Profile of each interface, indexed by interface ID. The message
+    //! timing is updated by the writer thread, the wait times by the reader.
+    std::vector<InterfaceProfile> Profiles;
+
+    //! Run time reported by each component, indexed by component ID.
+    std::vector<double> ComponentRunTimes;
+
+    //! Wall clock time of the time data exchange.
+    double SimulationWallTime;
+
+    //! Trace directory, no trace is written if empty.
+    std::string TraceDirectory;
+
+    //! Size of one time data record sent by each interface, indexed by
+    //! interface ID. Set when the time data exchange starts.
+    std::vector<size_t> RecordSizes;
+
+    //! Monitor connections that only query the link statistics. They are
+    //! dropped when closed, they do not ask for close permission.
+    std::vector<int> QuerySockets;
+
+    //! The full link, i.e., socket handle and interface ID, each component
+    //! is paused for, indexed by component ID. The reader does not read a
+    //! paused component, so TCP holds it back. (-1,-1) if not paused.
+    std::vector<std::pair<int,int> > FullLinks;
+
 public:
     //! The current running mode. Mainly used for monitoring.
     enum RunningMode{ StartUpMode, RunMode, ShutdownMode };
@@ -74,7 +249,7 @@ private:
 public:
     //! Constructor.
     ManagerCommHandler(omtlm_CompositeModel& Model):
-        MessageQueue(),
+        MessageQueue(Model.GetSimParams().GetMessageQueueDepth()),
         Comm(Model.GetComponentsNum(), Model.GetSimParams().GetPort()),
         TheModel(Model),
         MonitorConnected(false),
@@ -82,6 +257,15 @@ public:
         CommMode(CoSimulationMode),
         monitorInterfaceMap(),
         monitorMapLock(),
+        Recorder(NULL),
+        ProfileFile(),
+        Profiles(),
+        ComponentRunTimes(),
+        SimulationWallTime(0.0),
+        TraceDirectory(),
+        RecordSizes(),
+        QuerySockets(),
+        FullLinks(),
         runningMode(StartUpMode),
         exceptionMsg(""),
         exceptionLock()
@@ -97,7 +281,8 @@ public:
     static void* thread_ReaderThreadRun(void * arg) {
         ManagerCommHandler* con = (ManagerCommHandler*)arg;
 
-        if(con->TheModel.GetSimParams().GetMonitorPort() > 0) {
+        // The results are written by the recorder, no need to wait for a monitor.
+        if(con->Recorder == NULL && con->TheModel.GetSimParams().GetMonitorPort() > 0) {
             while(!con->MonitorConnected) {
 #ifndef _MSC_VER
                 usleep(10000); // micro seconds
@@ -140,6 +325,10 @@ public:
 
     void ProcessRegParameterMessage(int compID, TLMMessage& mess);
 
+    //! Pin the calling manager thread to a CPU and set its scheduling
+    //! policy according to the simulation parameters.
+    void PlaceThread(int index);
+
     //! ReaderThreadRun processes incomming messages and creates
     //! messages to be sent.
     void ReaderThreadRun();
@@ -148,7 +337,8 @@ public:
     static void* thread_WriterThreadRun(void * arg) {
         ManagerCommHandler* con = (ManagerCommHandler*)arg;
 
-        if(con->TheModel.GetSimParams().GetMonitorPort() > 0) {
+        // The results are written by the recorder, no need to wait for a monitor.
+        if(con->Recorder == NULL && con->TheModel.GetSimParams().GetMonitorPort() > 0) {
             while(!con->MonitorConnected) {
 #ifndef _MSC_VER
                 usleep(10000); // micro seconds
@@ -197,9 +387,33 @@ public:
     //! Initialize and run the monitoring thread.
     void MonitorThreadRun();
 
+    //! Set the recorder that writes the simulation results from the
+    //! routed time data. Must be called before Run, the recorder is
+    //! not owned by the manager.
+    void SetResultRecorder(TLMResultRecorder* recorder) { Recorder = recorder; }
+
+    //! Write the wait time and message latency profile to "fileName" when
+    //! the simulation is done, see WriteProfile. Must be called before Run.
+    void SetProfileFile(const std::string& fileName) { ProfileFile = fileName; }
+
+    //! Write a trace of the manager threads to "directory", the components
+    //! started by the manager write their traces there as well. See TLMTrace.
+    //! Must be called before Run.
+    void SetTraceDirectory(const std::string& directory) { TraceDirectory = directory; }
+
     //! Get the current running state.
     RunningMode getRunState() { return runningMode; }
 
+    //! Get the statistics of every connected link, one entry per
+    //! receiving interface. Can be called while the simulation runs.
+    void GetLinkStatistics(std::vector<TLMLinkStatistics>& stats);
+
+    //! Get the message buffer pool statistics (live, free and peak bytes).
+    TLMMessagePoolStats GetMessagePoolStats() { return MessageQueue.GetPoolStats(); }
+
+    //! Release unused message buffers until at most maxFreeBytes bytes are kept.
+    void TrimMessagePool(size_t maxFreeBytes = 0) { MessageQueue.TrimPool(maxFreeBytes); }
+
     //! Check if we got an exception and return exception message.
     //! \param[out] msg The exception message, or empty string if no exception occured.
     //! \return True if an exception occured, false otherwise.
@@ -220,16 +434,53 @@ private:
 
     //! Process interface monitoring requests.
     //! Each TLM interface might be monitored by one or several
-    //! external processes.
-    int ProcessInterfaceMonitoringMessage(TLMMessage& message);
+    //! external processes. A TLMMonitorRequest may follow the name to
+    //! request a decimated feed, the interval is returned in
+    //! samplingInterval (0 if not given).
+    int ProcessInterfaceMonitoringMessage(TLMMessage& message, double& samplingInterval);
+
+    //! Select the sockets of the paused components again whose link has
+    //! room, or which the writer is sending to: such a component may be
+    //! blocked sending to the reader and would never read its data.
+    //! Returns the number of components still paused, see FullLinks.
+    int ResumeComponents();
 
     //! Forwards message to monitoring ports if necessary.
+    //! The monitor messages share the data of "message", which must be
+    //! a slot obtained from MessageQueue.
     void ForwardToMonitor(TLMMessage& message);
 
     //! Thread exception handler.
     //! Shuts down all communications and sets the exception message.
     //! Invoked by threads.
     void HandleThreadException(const std::string& msg);
+
+    //! Report send queue statistics (depth limit, high-water marks and
+    //! dropped monitor messages, per link) and message pool statistics to the log.
+    void ReportQueueStatistics();
+
+    //! Extracts the run time and wait profile a component sent with
+    //! its close request. Data without TLM_CLOSE_PROFILE_MARKER, i.e.,
+    //! the stale data older components send, is ignored.
+    void UnpackWaitProfile(int compID, TLMMessage& mess);
+
+    //! Write the profile of the simulation, the components and the
+    //! connected interfaces to ProfileFile. The tlmprofile tool turns
+    //! it into a critical path report.
+    void WriteProfile();
+
+    //! Size of one time data record sent by the interface.
+    static size_t GetTimeDataRecordSize(TLMInterfaceProxy& ifc);
+
+    //! Update the statistics of the link a time data message is sent over.
+    //! Called by the reader thread before the message is marshaled.
+    void UpdateLinkStatistics(TLMMessage& message);
+
+    //! Reply to a link statistics request with the packed TLMLinkStatistics.
+    void PackLinkStatisticsMessage(TLMMessage& message);
+
+    //! Report the link statistics to the log.
+    void ReportLinkStatistics();
 };
 
 #endif
@@ -129,6 +129,8 @@ public:
         GenForce[3] = 0.0; GenForce[4] = 0.0; GenForce[5] = 0.0;
     }
 
+    TLMTimeData3D(const TLMTimeData3D& td) = default;
+
     TLMTimeData3D& operator=(const TLMTimeData3D& td) {
         if(&td != this) {
             time = td.time;
@@ -177,6 +179,8 @@ public:
         GenForce = 0.0;
     }
 
+    TLMTimeData1D(const TLMTimeData1D& td) = default;
+
     TLMTimeData1D& operator=(const TLMTimeData1D& td) {
         if(&td != this) {
             time = td.time;
@@ -208,6 +212,8 @@ public:
         Value = 0.0;
     }
 
+    TLMTimeDataSignal(const TLMTimeDataSignal& td) = default;
+
     TLMTimeDataSignal& operator=(const TLMTimeDataSignal& td) {
         if(&td != this) {
             time = td.time;
@@ -218,4 +224,97 @@ public:
     }
 };
 
+//! Marks the data of a close request that carries the run time and the wait
+//! profile of a component. Components built before the profile was added
+//! send the data of their last message with the close request, which must
+//! be ignored.
+#define TLM_CLOSE_PROFILE_MARKER (-7.43e307)
+
+//! Version of the close request data. The records of a newer version
+//! only append fields, so the manager reads the fields it knows.
+#define TLM_CLOSE_PROFILE_VERSION 1
+
+//! Start of the data of a close request, followed by one TLMWaitProfile
+//! record per interface. Note that the structure MUST contain only "double"
+//! numbers (important for byte swapping).
+struct TLMCloseProfileHeader {
+    //! Always TLM_CLOSE_PROFILE_MARKER.
+    double Marker;
+
+    //! Total wall clock run time of the component.
+    double RunTime;
+
+    //! TLM_CLOSE_PROFILE_VERSION of the sender.
+    double Version;
+
+    //! Size of one record in bytes.
+    double RecordSize;
+};
+
+//! Options of a monitor for one interface. Appended to the interface
+//! registration of a monitor, after the name that is then ended by a zero
+//! character. Note that the structure MUST contain only "double" numbers
+//! (important for byte swapping).
+struct TLMMonitorRequest {
+    //! Interval at which the monitor samples the interface, 0 to forward
+    //! all time data.
+    double SamplingInterval;
+};
+
+//! Time a component spent blocked waiting for data on one interface and
+//! the extrapolations of the interface, see TLMExtrapolationStats.
+//! Sent to the manager with the close request, after the
+//! TLMCloseProfileHeader. Note that the structure MUST contain only "double"
+//! numbers (important for byte swapping).
+struct TLMWaitProfile {
+    //! Interface ID.
+    double InterfaceID;
+
+    //! Total wall clock time spent waiting for data.
+    double WaitTime;
+
+    //! Number of times the component had to wait.
+    double NumWaits;
+
+    //! Number of requests extrapolated back and forward in time.
+    double NumBackward;
+    double NumForward;
+
+    //! Largest distance in time to the sample used, per direction.
+    double MaxBackwardError;
+    double MaxForwardError;
+};
+
+//! Statistics of the time data forwarded by the manager over one link,
+//! i.e., to one interface from the interface it is connected to.
+//! Sent to monitors on request (TLM_LINK_STATISTICS). Note that the
+//! structure MUST contain only "double" numbers (important for byte swapping).
+struct TLMLinkStatistics {
+    //! Receiving interface ID.
+    double InterfaceID;
+
+    //! Sending interface ID.
+    double LinkedID;
+
+    //! Number of time data messages and their total size in bytes.
+    double NumMessages;
+    double NumBytes;
+
+    //! Wall clock time between the arrival of two messages.
+    double MinInterArrival, AvgInterArrival, MaxInterArrival;
+
+    //! Simulation time of the sender minus that of the receiver when a
+    //! message arrives, negative if the sender lags behind.
+    double MinLead, AvgLead, MaxLead;
+
+    //! Extrapolations reported by the receiving component at close.
+    double NumExtrapolations;
+
+    //! Time the receiving component waited for data, reported at close.
+    double WaitTime;
+
+    //! Time from receiving a message until it was sent on.
+    double AvgLatency, MaxLatency;
+};
+
 #endif
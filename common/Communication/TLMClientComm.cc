@@ -42,7 +42,9 @@ using std::string;
 
 // Constructor
 TLMClientComm::TLMClientComm()
-    : SocketHandle(-1) {}
+    : SocketHandle(-1), SendLock(), ThreadSafe(false), MonitorRequest() {
+    MonitorRequest.SamplingInterval = 0.0;
+}
 
 TLMClientComm::~TLMClientComm() {
     if(SocketHandle != -1) {
@@ -50,6 +52,18 @@ TLMClientComm::~TLMClientComm() {
     }
 }
 
+void TLMClientComm::SendMessage(TLMMessage& mess) {
+    if(ThreadSafe) {
+        // The header and the data are sent separately, the lock keeps the
+        // messages of different threads from interleaving.
+        AutoLock lock(SendLock);
+        TLMCommUtil::SendMessage(mess);
+    }
+    else {
+        TLMCommUtil::SendMessage(mess);
+    }
+}
+
 
 // Fill in TLMMessage with the information from TLMTimeData vector
 // coming to given InterfaceID. This function is called by TLMPlugin
@@ -67,6 +81,31 @@ void TLMClientComm::PackTimeDataMessageSignal(int InterfaceID,
 }
 
 
+// Fill in the close request message with the profile header, holding
+// the run time of the component, followed by the wait profile of its
+// interfaces.
+void TLMClientComm::PackCloseRequestMessage(double runTime,
+                                            std::vector<TLMWaitProfile> &Profile,
+                                            TLMMessage &out_mess) {
+    TLMCloseProfileHeader header;
+    header.Marker = TLM_CLOSE_PROFILE_MARKER;
+    header.RunTime = runTime;
+    header.Version = TLM_CLOSE_PROFILE_VERSION;
+    header.RecordSize = sizeof(TLMWaitProfile);
+
+    out_mess.Header.MessageType =  TLMMessageTypeConst::TLM_CLOSE_REQUEST;
+    out_mess.Header.TLMInterfaceID = -1;
+    out_mess.Header.SourceIsBigEndianSystem = TLMMessageHeader::IsBigEndianSystem;
+    out_mess.Header.DataSize = sizeof(TLMCloseProfileHeader) + Profile.size() * sizeof(TLMWaitProfile);
+    out_mess.Data.clear();
+    out_mess.Data.resize(out_mess.Header.DataSize);
+    memcpy(& out_mess.Data[0], & header, sizeof(TLMCloseProfileHeader));
+    if(!Profile.empty()) {
+        memcpy(& out_mess.Data[sizeof(TLMCloseProfileHeader)], & Profile[0], Profile.size() * sizeof(TLMWaitProfile));
+    }
+}
+
+
 // Fill in TLMMessage with the information from TLMTimeData vector 
 // coming to given InterfaceID. This function is called by TLMPlugin
 //  when constructing messages with time-stamped data.
@@ -112,7 +151,7 @@ void TLMClientComm::UnpackTimeDataMessageSignal(TLMMessage &mess, std::deque<TLM
         TLMCommUtil::ByteSwap(Next, sizeof(double),  mess.Header.DataSize/sizeof(double));
 
     for(unsigned i = 0; i < mess.Header.DataSize/sizeof(TLMTimeDataSignal); i++, Next++) {
-        if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
+        if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
            TLMErrorLog::Info(" RECV for time= " + TLMErrorLog::ToStdStr(Next->time));
         }
         Data.push_back(*Next);
@@ -133,7 +172,7 @@ void TLMClientComm::UnpackTimeDataMessage3D(TLMMessage& mess, deque<TLMTimeData3
         TLMCommUtil::ByteSwap(Next, sizeof(double),  mess.Header.DataSize/sizeof(double));
 
     for(unsigned i = 0; i < mess.Header.DataSize/sizeof(TLMTimeData3D); i++, Next++) {
-        if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
+        if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
             TLMErrorLog::Info(" RECV for time= " + TLMErrorLog::ToStdStr(Next->time));
         }
         Data.push_back(*Next);
@@ -154,7 +193,7 @@ void TLMClientComm::UnpackTimeDataMessage1D(TLMMessage& mess, deque<TLMTimeData1
         TLMCommUtil::ByteSwap(Next, sizeof(double),  mess.Header.DataSize/sizeof(double));
 
     for(unsigned i = 0; i < mess.Header.DataSize/sizeof(TLMTimeData1D); i++, Next++) {
-        if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
+        if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
             TLMErrorLog::Info(" RECV for time= " + TLMErrorLog::ToStdStr(Next->time));
         }
         Data.push_back(*Next);
@@ -272,6 +311,14 @@ void TLMClientComm::CreateInterfaceRegMessage(std::string& Name, int dimensions,
     mess.Header.DataSize = specification.length();
     mess.Data.resize(specification.length());
     memcpy(&mess.Data[0], specification.c_str(), specification.length());
+
+    if(MonitorRequest.SamplingInterval > 0.0) {
+        // The name is ended by a zero character and followed by the request.
+        mess.Header.DataSize = specification.length() + 1 + sizeof(TLMMonitorRequest);
+        mess.Data.resize(mess.Header.DataSize);
+        mess.Data[specification.length()] = 0;
+        memcpy(&mess.Data[specification.length()+1], &MonitorRequest, sizeof(TLMMonitorRequest));
+    }
 }
 
 void TLMClientComm::CreateParameterRegMessage(std::string &Name, std::string &Value, TLMMessage &mess) {
@@ -13,6 +13,7 @@
 #include <string>
 #include <cstdlib>
 #include "Communication/TLMCommUtil.h"
+#include "Communication/TLMThreadSynch.h"
 #include "Logging/TLMErrorLog.h"
 #include "common.h"
 
@@ -21,6 +22,15 @@
 class TLMClientComm {
 
     int SocketHandle;
+
+    //! Serializes the messages sent by several threads in thread-safe mode.
+    SimpleLock SendLock;
+
+    //! Set if several threads may send at the same time.
+    bool ThreadSafe;
+
+    //! Options sent with the interface registrations of a monitor.
+    TLMMonitorRequest MonitorRequest;
     
 public:
 
@@ -30,6 +40,17 @@ public:
     //! Destructor, closes socket.
     ~TLMClientComm();
 
+    //! Enable the thread-safe mode where the messages sent by several
+    //! threads are not interleaved on the socket.
+    void SetThreadSafe(bool threadSafe) { ThreadSafe = threadSafe; }
+
+    //! Set the monitor options sent with the following interface
+    //! registrations, see TLMMonitorRequest.
+    void SetMonitorRequest(const TLMMonitorRequest& request) { MonitorRequest = request; }
+
+    //! Send a message to the TLM manager, see SetThreadSafe.
+    void SendMessage(TLMMessage& mess);
+
     //! Fill in TLMMessage with the information from TLMTimeData vector
     //! coming to given InterfaceID. This function is called by TLMPlugin
     //!  when constructing messages with time-stamped data.
@@ -43,6 +64,13 @@ public:
                                       std::vector<TLMTimeData3D> &Data,
                                       TLMMessage& out_mess);
 
+    //! Fill in the close request message. The data holds a
+    //! TLMCloseProfileHeader with the run time of the component followed
+    //! by the wait profile of its interfaces.
+    static void PackCloseRequestMessage(double runTime,
+                                        std::vector<TLMWaitProfile>& Profile,
+                                        TLMMessage& out_mess);
+
     //! Unpack TLMTimeData from TLMMessage into Data queue
     static void UnpackTimeDataMessageSignal(TLMMessage &mess, std::deque<TLMTimeDataSignal> &Data);
     static void UnpackTimeDataMessage1D(TLMMessage &mess, std::deque<TLMTimeData1D> &Data);
@@ -59,7 +87,8 @@ public:
     void CreateComponentRegMessage(std::string& Name, TLMMessage& mess);
 
     //! CreateInterfaceRegMessage packs interface name into a message
-    //! to be sent to the TLM manager
+    //! to be sent to the TLM manager. The monitor options, if any, follow
+    //! the name.
     void CreateInterfaceRegMessage(std::string& Name, int dimensions, std::string& causality, std::string domain, TLMMessage& mess);
 
     //! CreateInterfaceRegMessage packs interface name into a message
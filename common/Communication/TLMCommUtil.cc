@@ -1,7 +1,12 @@
 #include "Communication/TLMCommUtil.h"
 #include "Logging/TLMErrorLog.h"
+#include "Logging/TLMTrace.h"
 
 #include <string>
+#include <chrono>
+#include <thread>
+#include <cerrno>
+#include <cstdlib>
 
 // BZ306: due to this difficulr bug detailed loggning of each send/recv was added.
 // However for performance reasons, i.e. tp
@@ -27,8 +32,18 @@ TLMMessageHeader::TLMMessageHeader():
 
 // Send the TLMMessage pointed by mess via socket with handle SocketHandle
 void TLMCommUtil::SendMessage(TLMMessage& mess) {
+    const unsigned char* Data = mess.Data.empty() ? NULL : &mess.Data[0];
+    SendMessage(mess.SocketHandle, mess.Header, Data);
+}
+
+// Send a message header and the data it describes via socket with handle SocketHandle
+void TLMCommUtil::SendMessage(int SocketHandle, TLMMessageHeader& Header, const unsigned char* Data) {
+
+    int DataSize = Header.DataSize;
 
-    int DataSize = mess.Header.DataSize;
+    // The header may be byte swapped below.
+    double traceStart = TLMTrace::IsEnabled() ? TLMTrace::Now() : -1.0;
+    int traceInterfaceID = Header.TLMInterfaceID;
 
     if(doDetailedLogging) {
         TLMErrorLog::Info("SendMessage: wants to send "+
@@ -36,10 +51,10 @@ void TLMCommUtil::SendMessage(TLMMessage& mess) {
                          std::to_string(DataSize)+ " bytes ");
     }
 
-    if(TLMMessageHeader::IsBigEndianSystem != mess.Header.SourceIsBigEndianSystem) {
+    if(TLMMessageHeader::IsBigEndianSystem != Header.SourceIsBigEndianSystem) {
         // switch byte order for DataSize and InterfaceID
-        TLMCommUtil::ByteSwap(&mess.Header.DataSize, sizeof(mess.Header.DataSize));
-        TLMCommUtil::ByteSwap(&mess.Header.TLMInterfaceID, sizeof(mess.Header.TLMInterfaceID));
+        TLMCommUtil::ByteSwap(&Header.DataSize, sizeof(Header.DataSize));
+        TLMCommUtil::ByteSwap(&Header.TLMInterfaceID, sizeof(Header.TLMInterfaceID));
     }
 
 #if defined( WIN32) || defined(__APPLE__)
@@ -47,13 +62,13 @@ void TLMCommUtil::SendMessage(TLMMessage& mess) {
 #endif
 
     // NOTE, "MSG_MORE" flag is important for Linux socket performance!
-    int sendBytes = send(mess.SocketHandle, (const char*)&(mess.Header) , sizeof(TLMMessageHeader), MSG_MORE);
+    int sendBytes = send(SocketHandle, (const char*)&(Header) , sizeof(TLMMessageHeader), MSG_MORE);
 
     int attempts = 1;
     while(attempts < 10 && sendBytes < 0) {
         // try to resend
-        TLMErrorLog::Warning("Failed to send message header, will try again (code: "+std::to_string(sendBytes)+"), type = "+std::to_string(mess.Header.MessageType));
-        sendBytes = send(mess.SocketHandle, (const char*)&(mess.Header) , sizeof(TLMMessageHeader), MSG_MORE);
+        TLMErrorLog::Warning("Failed to send message header, will try again (code: "+std::to_string(sendBytes)+"), type = "+std::to_string(Header.MessageType));
+        sendBytes = send(SocketHandle, (const char*)&(Header) , sizeof(TLMMessageHeader), MSG_MORE);
         ++attempts;
     }
     if(sendBytes < 0) {
@@ -70,12 +85,12 @@ void TLMCommUtil::SendMessage(TLMMessage& mess) {
     }
 
     if(DataSize > 0) {
-        sendBytes = send(mess.SocketHandle, (const char*)&(mess.Data[0]), DataSize, 0);
+        sendBytes = send(SocketHandle, (const char*)Data, DataSize, 0);
         attempts = 1;
         if(attempts < 10 && sendBytes < 0) {
             // try to resend
             TLMErrorLog::Warning("Failed to send message data, will try to continue anyway");
-            sendBytes=send(mess.SocketHandle, (const char*)&(mess.Data[0]), DataSize, 0);
+            sendBytes=send(SocketHandle, (const char*)Data, DataSize, 0);
         };
         if(sendBytes < 0) {
             TLMErrorLog::FatalError("Failed to send message data. Aborting.");
@@ -92,6 +107,9 @@ void TLMCommUtil::SendMessage(TLMMessage& mess) {
 
     }
 
+    if(traceStart >= 0.0) {
+        TLMTrace::AddEvent(TraceSend, traceStart, TLMTrace::Now(), traceInterfaceID, Header.MessageType);
+    }
 
 }
 
@@ -107,13 +125,33 @@ void TLMCommUtil::SendMessage(TLMMessage& mess) {
 // Basic receive of a TLMMessage. Insures correct signature and
 // fixes byte order for the message header if necessary.
 // Note that the actual message data is not processed, just received, 
-bool TLMCommUtil::ReceiveMessage(TLMMessage& mess) {
-    int bcount = recv(mess.SocketHandle, (char*)(&mess.Header), sizeof(TLMMessageHeader) , MSG_WAITALL);
+bool TLMCommUtil::ReceiveMessage(TLMMessage& mess, double pollTime) {
+    double traceStart = TLMTrace::IsEnabled() ? TLMTrace::Now() : -1.0;
+
+    // Spin first, the blocking receive below then returns at once
+    // unless the data did not arrive within the poll time.
+    if(pollTime > 0.0) {
+        PollForData(mess.SocketHandle, pollTime);
+    }
+
+    if(!ReceiveMessageHeader(mess.SocketHandle, mess.Header)) {
+        return false;
+    }
+    bool received = ReceiveMessageData(mess);
+
+    if(traceStart >= 0.0) {
+        TLMTrace::AddEvent(TraceReceive, traceStart, TLMTrace::Now(), mess.Header.TLMInterfaceID, mess.Header.MessageType);
+    }
+    return received;
+}
+
+bool TLMCommUtil::ReceiveMessageHeader(int SocketHandle, TLMMessageHeader& Header) {
+    int bcount = recv(SocketHandle, (char*)(&Header), sizeof(TLMMessageHeader) , MSG_WAITALL);
     while((bcount >= 0) && (bcount <  static_cast<int>(sizeof(TLMMessageHeader)))) {
         // this should never happen, but it does...
         TLMErrorLog::Warning("Could not receive the header, will try again");
-        bcount += recv(mess.SocketHandle,
-                       (char*)(&mess.Header) + bcount,
+        bcount += recv(SocketHandle,
+                       (char*)(&Header) + bcount,
                        sizeof(TLMMessageHeader) - bcount,
                        MSG_WAITALL);
         if(bcount == 0)
@@ -137,11 +175,11 @@ bool TLMCommUtil::ReceiveMessage(TLMMessage& mess) {
         TLMErrorLog::Info("ReceiveMessage:recv() returned "+std::to_string(bcount)+ " bytes ");
     }
 
-    if(strncmp(mess.Header.Signature, TLMMessageHeader::TLMSignature, TLMMessageHeader::TLM_SIGNATURE_LENGTH) != 0) {
+    if(strncmp(Header.Signature, TLMMessageHeader::TLMSignature, TLMMessageHeader::TLM_SIGNATURE_LENGTH) != 0) {
         char sig1[TLMMessageHeader::TLM_SIGNATURE_LENGTH+1] = {0};
         char sig2[TLMMessageHeader::TLM_SIGNATURE_LENGTH+1] = {0};
 
-        strncpy(sig1, mess.Header.Signature, TLMMessageHeader::TLM_SIGNATURE_LENGTH);
+        strncpy(sig1, Header.Signature, TLMMessageHeader::TLM_SIGNATURE_LENGTH);
         strncpy(sig2, TLMMessageHeader::TLMSignature, TLMMessageHeader::TLM_SIGNATURE_LENGTH);
 
         // Just to make sure we have 0 terminated strings.
@@ -151,21 +189,25 @@ bool TLMCommUtil::ReceiveMessage(TLMMessage& mess) {
         TLMErrorLog::FatalError("Wrong signature in TLM message, incompatiple TLM format!\n" + std::string(sig1) + " != " + std::string(sig2));
     }
 
-    if(TLMMessageHeader::IsBigEndianSystem != mess.Header.SourceIsBigEndianSystem) {
+    if(TLMMessageHeader::IsBigEndianSystem != Header.SourceIsBigEndianSystem) {
         // switch byte order for DataSize and InterfaceID
-        TLMCommUtil::ByteSwap(&mess.Header.DataSize, sizeof(mess.Header.DataSize));
-        TLMCommUtil::ByteSwap(&mess.Header.TLMInterfaceID, sizeof(mess.Header.TLMInterfaceID));
+        TLMCommUtil::ByteSwap(&Header.DataSize, sizeof(Header.DataSize));
+        TLMCommUtil::ByteSwap(&Header.TLMInterfaceID, sizeof(Header.TLMInterfaceID));
     }
-    if(mess.Header.DataSize < 0) {
+    if(Header.DataSize < 0) {
         TLMErrorLog::FatalError("Negative size of data in TLM message. Protocol error.");
     }
+    return true;
+}
+
+bool TLMCommUtil::ReceiveMessageData(TLMMessage& mess) {
     if(mess.Header.DataSize > 0) {
 
         //mess.Data.clear(); // just to be on the safe side.
         if(mess.Data.size() < mess.Header.DataSize) {
             mess.Data.resize(mess.Header.DataSize);
         }
-        bcount = recv(mess.SocketHandle,(char*)&(mess.Data[0]), mess.Header.DataSize,  MSG_WAITALL);
+        int bcount = recv(mess.SocketHandle,(char*)&(mess.Data[0]), mess.Header.DataSize,  MSG_WAITALL);
         while((bcount >= 0) && (bcount <  mess.Header.DataSize)) {
             // this should never happen, but it does...
             TLMErrorLog::Warning("Could not receive the TLM data, will try again");
@@ -194,3 +236,69 @@ bool TLMCommUtil::ReceiveMessage(TLMMessage& mess) {
     return true;
 }
 
+bool TLMCommUtil::PollForData(int SocketHandle, double pollTime) {
+    double endTime = GetWallClockTime() + pollTime;
+    do {
+#ifdef WIN32
+        u_long available = 0;
+        if(ioctlsocket(SocketHandle, FIONREAD, &available) != 0 || available > 0) {
+            return true;
+        }
+#else
+        // A closed socket or an error is left to the blocking receive.
+        char c;
+        int bcount = recv(SocketHandle, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+        if(bcount >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            return true;
+        }
+#endif
+        // Give the core to another thread if there is one.
+        std::this_thread::yield();
+    } while(GetWallClockTime() < endTime);
+
+    return false;
+}
+
+double TLMCommUtil::GetWallClockTime() {
+    std::chrono::steady_clock::duration t = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration<double>(t).count();
+}
+
+void TLMEnvironment::Set(const std::string& name, const std::string& value) {
+    bool saved = false;
+    for(size_t i = 0; i < Saved.size(); i++) {
+        if(Saved[i].Name == name) saved = true;
+    }
+    if(!saved) {
+        SavedVariable var;
+        var.Name = name;
+        const char* old = getenv(name.c_str());
+        var.WasSet = (old != NULL);
+        var.Value = (old != NULL) ? old : "";
+        Saved.push_back(var);
+    }
+
+#ifdef _WIN32
+    _putenv_s(name.c_str(), value.c_str());
+#else
+    setenv(name.c_str(), value.c_str(), 1);
+#endif
+}
+
+void TLMEnvironment::Restore() {
+    for(size_t i = 0; i < Saved.size(); i++) {
+        const SavedVariable& var = Saved[i];
+#ifdef _WIN32
+        // An empty value removes the variable.
+        _putenv_s(var.Name.c_str(), var.WasSet ? var.Value.c_str() : "");
+#else
+        if(var.WasSet) {
+            setenv(var.Name.c_str(), var.Value.c_str(), 1);
+        }
+        else {
+            unsetenv(var.Name.c_str());
+        }
+#endif
+    }
+    Saved.clear();
+}
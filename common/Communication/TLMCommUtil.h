@@ -11,6 +11,7 @@
 #define TLMCommUtil_h_
 
 #include <vector>
+#include <string>
 #include <cstring>
 
 #include "Communication/TLMCalcData.h"
@@ -57,6 +58,8 @@ struct TLMMessageTypeConst {
     static const char TLM_CLOSE_REQUEST = 7;
     //! Close permission accepted
     static const char TLM_CLOSE_PERMISSION = 8;
+    //! Link statistics request from a monitor, and the reply
+    static const char TLM_LINK_STATISTICS = 9;
 };
 
 //! Message header used in all the messages sent between
@@ -109,14 +112,26 @@ struct TLMMessage {
     //! Data array (contents depends on the message type)
     std::vector<unsigned char> Data;
 
+    //! Wall clock time when the manager received the message,
+    //! see TLMCommUtil::GetWallClockTime. Zero if not measured.
+    double ReceiveTime;
+
     //! Constructor, initializes all attributes.
     TLMMessage()
         : SocketHandle(-1)
         , Header()
         , Data()
+        , ReceiveTime(0.0)
     {}
 };
 
+//! Environment variable with the busy-poll time of the components
+//! started by the manager, see TLMCommUtil::ReceiveMessage.
+#define TLM_BUSY_POLL_ENV "OMTLM_BUSY_POLL"
+
+//! Environment variable that enables the receiver thread in the components
+//! started by the manager, see PluginImplementer::StartReceiverThread.
+#define TLM_RECEIVER_THREAD_ENV "OMTLM_RECEIVER_THREAD"
 
 //! Class TLMCommUtil defines communication utility functions used both
 //! on client and server
@@ -150,12 +165,73 @@ public:
     //! Send the TLMMessage pointed by mess via socket with handle SocketHandle
     static void SendMessage(TLMMessage& mess);
 
+    //! Send a message header followed by Header.DataSize bytes from Data
+    //! via socket with handle SocketHandle. Used when the data is shared
+    //! between several messages.
+    static void SendMessage(int SocketHandle, TLMMessageHeader& Header, const unsigned char* Data);
+
     //! Basic receive of a TLMMessage. Insures correct signature and
     //! fixes byte order for the message header if necessary.
     //! Note that the actual message data is not processed, just received,
     //! Returns 'true' on success, 'false' if socket is closed, aborts on error.
-    static bool ReceiveMessage(TLMMessage& mess);
+    //! With a pollTime the receive spins for up to pollTime seconds before
+    //! it blocks, see PollForData.
+    static bool ReceiveMessage(TLMMessage& mess, double pollTime = 0.0);
+
+    //! Receive only the header of a TLMMessage from the socket. Insures correct
+    //! signature and fixes byte order. Used when the data buffer is chosen
+    //! according to the data size, see ReceiveMessageData.
+    //! Returns 'true' on success, 'false' if socket is closed, aborts on error.
+    static bool ReceiveMessageHeader(int SocketHandle, TLMMessageHeader& Header);
+
+    //! Receive the data of a TLMMessage whose header was already received
+    //! with ReceiveMessageHeader. The data array is resized if needed.
+    //! Returns 'true' on success, 'false' if socket is closed, aborts on error.
+    static bool ReceiveMessageData(TLMMessage& mess);
+
+    //! Monotonic wall clock time in seconds, used to measure wait
+    //! times and message latencies.
+    static double GetWallClockTime();
+
+    //! Spin without blocking until data, or an error, is pending on the
+    //! socket or pollTime seconds have passed. Returns true if the next
+    //! receive will not block. Busy polling avoids the wake up latency of
+    //! a blocking receive at the cost of a fully used core.
+    static bool PollForData(int SocketHandle, double pollTime);
+
+};
+
+//! TLMEnvironment sets environment variables for the processes started
+//! while it exists, e.g., the components started by the manager. The
+//! previous values are restored when it is destroyed, so that the settings
+//! do not leak into the calling process and later simulations.
+class TLMEnvironment {
+public:
+
+    TLMEnvironment() : Saved() {}
+
+    ~TLMEnvironment() { Restore(); }
+
+    //! Set a variable. The value it had before the first Set is restored.
+    void Set(const std::string& name, const std::string& value);
+
+    //! Restore the variables that were set.
+    void Restore();
+
+private:
+
+    //! Value of a variable before it was set.
+    struct SavedVariable {
+        std::string Name;
+        bool WasSet;
+        std::string Value;
+    };
+
+    std::vector<SavedVariable> Saved;
 
+    // Not copyable, the variables are restored once.
+    TLMEnvironment(const TLMEnvironment&);
+    TLMEnvironment& operator=(const TLMEnvironment&);
 };
 
 inline void TLMCommUtil::ByteSwap(void * Buff, size_t type_size, size_t items) {
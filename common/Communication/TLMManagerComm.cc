@@ -5,11 +5,13 @@
 */
 #include "Communication/TLMManagerComm.h"
 #include "Logging/TLMErrorLog.h"
+#include "Communication/TLMCommUtil.h"
 #include <cassert>
 #include <cstring>
 #include <vector>
 #include <algorithm>
 #include <iostream>
+#include <thread>
 
 using std::vector;
 using std::string;
@@ -108,10 +110,21 @@ int TLMManagerComm::CreateServerSocket() {
 }
 
 
-void TLMManagerComm::SelectReadSocket() {
+void TLMManagerComm::SelectReadSocket(double timeout) {
 
     int maxFD = -1;
     FD_ZERO(& CurFDSet);
+
+    // All sockets may be paused, then there is nothing to wait for.
+    if(ActiveSockets.empty()) {
+#ifndef WIN32
+        usleep(useconds_t(timeout * 1e6)); // micro seconds
+#else
+        Sleep(DWORD(timeout * 1e3)); // milli seconds
+#endif
+        return;
+    }
+
     for(vector<int>::iterator it = ActiveSockets.begin(); it != ActiveSockets.end(); it++) {
         FD_SET(*it, &CurFDSet);
         if(*it > maxFD) {
@@ -125,11 +138,29 @@ void TLMManagerComm::SelectReadSocket() {
 
     // sock is an intialized socket handle
 
-    tv.tv_sec = 0;
+    // In busy-poll mode the sockets are checked without blocking for a
+    // while, to avoid the wake up latency of the blocking select below.
+    if(BusyPollTime > 0.0) {
+        double endTime = TLMCommUtil::GetWallClockTime() + BusyPollTime;
+        fd_set allFDSet = CurFDSet;
+        do {
+            struct timeval zero;
+            zero.tv_sec = 0;
+            zero.tv_usec = 0;
+            CurFDSet = allFDSet;
+            if(select(maxFD + 1, &CurFDSet, NULL, NULL, &zero) > 0) {
+                return;
+            }
+            std::this_thread::yield();
+        } while(TLMCommUtil::GetWallClockTime() < endTime);
+        CurFDSet = allFDSet;
+    }
+
+    tv.tv_sec = long(timeout);
 
-    tv.tv_usec = 500000;
+    tv.tv_usec = long((timeout - tv.tv_sec) * 1e6);
 
-    /* wait 10 seconds for any data to be read from any single socket */
+    /* wait for any data to be read from any single socket */
 
     select(maxFD + 1, &CurFDSet, NULL, NULL, &tv);
 }
@@ -170,6 +201,10 @@ void TLMManagerComm::DropActiveSocket(int socket) {
     ActiveSockets.erase(std::find(ActiveSockets.begin(), ActiveSockets.end(), socket));
 }
 
+void TLMManagerComm::PauseActiveSocket(int socket) {
+    ActiveSockets.erase(std::find(ActiveSockets.begin(), ActiveSockets.end(), socket));
+}
+
 // Close all active sockets
 void TLMManagerComm::CloseAll() {
     std::vector<int>::iterator activeSockIter;
@@ -37,6 +37,9 @@ class TLMManagerComm {
     //! Number of clients processed
     const int NumClients;
 
+    //! Time in seconds SelectReadSocket spins before it blocks, 0 to always block.
+    double BusyPollTime;
+
 public:
 
     //! Constructor for the specified number of components.
@@ -47,7 +50,8 @@ public:
           ActiveSockets(),
           StartupMode(true),
           ServerPort (portNr),
-          NumClients(numClients)
+          NumClients(numClients),
+          BusyPollTime(0.0)
     {
         FD_ZERO(& CurFDSet);
     }
@@ -55,8 +59,13 @@ public:
     //! Create socket that will accept the client connections on port ServerPort
     int CreateServerSocket();
 
-    //! Run select on the active set of sockets
-    void SelectReadSocket();
+    //! Run select on the active set of sockets, waiting at most
+    //! "timeout" seconds.
+    void SelectReadSocket(double timeout = 0.5);
+
+    //! Set the time in seconds SelectReadSocket spins on the sockets before
+    //! it blocks, see TLMCommUtil::PollForData. 0 (default) always blocks.
+    void SetBusyPollTime(double pollTime) { BusyPollTime = pollTime; }
 
     //! Check if the data is pending to be read on the specified socket
     //! Should be called after SelectReadSocket
@@ -76,6 +85,10 @@ public:
     //! Remove a socket handle from the active sockets set
     void DropActiveSocket(int socket);
 
+    //! Remove a socket handle from the active sockets set without closing
+    //! the socket. AddActiveSocket selects it again.
+    void PauseActiveSocket(int socket);
+
     //! Switch from startup mode, when components are sending registration
     //! requests and manager is accepting connections, to running mode, when
     //! manager forwards messages between components.
@@ -0,0 +1,243 @@
+/**
+ * File: TLMMessagePool.cc
+ *
+ * Implementation of the TLMMessagePool methods
+ */
+#include "Communication/TLMMessagePool.h"
+#include "Communication/TLMCalcData.h"
+#include <algorithm>
+#include <atomic>
+
+namespace {
+    //! Message buffer as handed out by the pool. Remembers the data
+    //! capacity accounted for in the pool statistics and, for
+    //! shared messages, the message that owns the data.
+    struct TLMPooledMessage : public TLMMessage {
+        size_t PoolCapacity;
+
+        //! Number of references: the message itself plus one for
+        //! each shared message using its data.
+        std::atomic<int> RefCount;
+
+        //! Message owning the data, NULL if the data is our own.
+        TLMPooledMessage* SharedSource;
+
+        TLMPooledMessage() : TLMMessage(), PoolCapacity(0), RefCount(1), SharedSource(NULL) {}
+    };
+}
+
+TLMMessagePool::TLMMessagePool(size_t maxFreeBytes)
+    : ClassCapacity()
+    , FreeLists()
+    , MaxFreeBytes(maxFreeBytes)
+    , Stats()
+    , PoolLock()
+{
+    const size_t recordSizes[] = { sizeof(TLMTimeDataSignal),
+                                   sizeof(TLMTimeData1D),
+                                   sizeof(TLMTimeData3D) };
+
+    // Class 0 is used for messages without data (control messages).
+    ClassCapacity.push_back(0);
+    for(size_t i = 0; i < sizeof(recordSizes)/sizeof(recordSizes[0]); ++i) {
+        for(size_t n = 1; n <= MAX_BATCH_RECORDS; n *= 2) {
+            ClassCapacity.push_back(n*recordSizes[i]);
+        }
+    }
+    std::sort(ClassCapacity.begin(), ClassCapacity.end());
+    ClassCapacity.erase(std::unique(ClassCapacity.begin(), ClassCapacity.end()), ClassCapacity.end());
+
+    FreeLists.resize(ClassCapacity.size());
+}
+
+TLMMessagePool::~TLMMessagePool() {
+    Clear();
+}
+
+int TLMMessagePool::GetClassIndex(size_t size) const {
+    std::vector<size_t>::const_iterator it = std::lower_bound(ClassCapacity.begin(), ClassCapacity.end(), size);
+    if(it == ClassCapacity.end()) return -1;
+    return int(it - ClassCapacity.begin());
+}
+
+TLMMessage* TLMMessagePool::Get(size_t size) {
+    int cls = GetClassIndex(size);
+    TLMPooledMessage* ret = NULL;
+
+    PoolLock.lock();
+    if(cls >= 0) {
+        // Take the smallest free buffer that is large enough.
+        for(size_t i = cls; i < FreeLists.size(); ++i) {
+            if(!FreeLists[i].empty()) {
+                ret = static_cast<TLMPooledMessage*>(FreeLists[i].back());
+                FreeLists[i].pop_back();
+                Stats.FreeBuffers--;
+                Stats.FreeBytes -= ret->PoolCapacity;
+                Stats.Reuses++;
+                break;
+            }
+        }
+    }
+    if(ret == NULL) {
+        Stats.Allocations++;
+    }
+    PoolLock.unlock();
+
+    size_t capacity = (cls >= 0) ? ClassCapacity[cls] : size;
+    if(ret == NULL) {
+        ret = new TLMPooledMessage();
+        ret->Data.reserve(capacity);
+    }
+    if(ret->Data.size() < capacity) {
+        ret->Data.resize(capacity);
+    }
+    ret->PoolCapacity = ret->Data.capacity();
+    ret->RefCount = 1;
+    ret->SharedSource = NULL;
+    ret->ReceiveTime = 0.0;
+
+    PoolLock.lock();
+    Stats.LiveBuffers++;
+    Stats.LiveBytes += ret->PoolCapacity;
+    if(Stats.LiveBytes + Stats.FreeBytes > Stats.PeakBytes) {
+        Stats.PeakBytes = Stats.LiveBytes + Stats.FreeBytes;
+    }
+    PoolLock.unlock();
+
+    return ret;
+}
+
+TLMMessage* TLMMessagePool::GetShared(TLMMessage* source) {
+    TLMPooledMessage* psource = static_cast<TLMPooledMessage*>(source);
+    TLMPooledMessage* ret = static_cast<TLMPooledMessage*>(Get(0));
+
+    psource->RefCount++;
+    ret->SharedSource = psource;
+    ret->Header = psource->Header;
+
+    return ret;
+}
+
+const unsigned char* TLMMessagePool::GetData(TLMMessage* mess) {
+    TLMPooledMessage* pmess = static_cast<TLMPooledMessage*>(mess);
+    if(pmess->SharedSource != NULL) {
+        pmess = pmess->SharedSource;
+    }
+    return pmess->Data.empty() ? NULL : &pmess->Data[0];
+}
+
+void TLMMessagePool::Release(TLMMessage* mess) {
+    Unref(mess, true);
+}
+
+void TLMMessagePool::Discard(TLMMessage* mess) {
+    Unref(mess, false);
+}
+
+void TLMMessagePool::Unref(TLMMessage* mess, bool keep) {
+    if(mess == NULL) return;
+    TLMPooledMessage* pmess = static_cast<TLMPooledMessage*>(mess);
+
+    // The last reference returns the buffer.
+    if(--pmess->RefCount > 0) return;
+
+    TLMPooledMessage* source = pmess->SharedSource;
+    pmess->SharedSource = NULL;
+
+    if(keep) {
+        Return(pmess);
+    }
+    else {
+        Delete(pmess);
+    }
+
+    // A shared message holds a reference to the data owner.
+    if(source != NULL) {
+        Unref(source, keep);
+    }
+}
+
+void TLMMessagePool::Return(TLMMessage* mess) {
+    TLMPooledMessage* pmess = static_cast<TLMPooledMessage*>(mess);
+
+    PoolLock.lock();
+    Stats.LiveBuffers--;
+    Stats.LiveBytes -= pmess->PoolCapacity;
+
+    // The buffer may have grown while in use, e.g., in ReceiveMessage.
+    pmess->PoolCapacity = pmess->Data.capacity();
+
+    // File the buffer under the largest class it can serve.
+    int cls = GetClassIndex(pmess->PoolCapacity);
+    if(cls >= 0 && ClassCapacity[cls] > pmess->PoolCapacity) {
+        cls--;
+    }
+
+    if(cls < 0) {
+        // Larger than the largest class, do not keep it.
+        Stats.Trimmed++;
+        PoolLock.unlock();
+        delete pmess;
+        return;
+    }
+
+    FreeLists[cls].push_back(pmess);
+    Stats.FreeBuffers++;
+    Stats.FreeBytes += pmess->PoolCapacity;
+    if(Stats.LiveBytes + Stats.FreeBytes > Stats.PeakBytes) {
+        Stats.PeakBytes = Stats.LiveBytes + Stats.FreeBytes;
+    }
+
+    if(MaxFreeBytes > 0 && Stats.FreeBytes > MaxFreeBytes) {
+        TrimLocked(MaxFreeBytes);
+    }
+    PoolLock.unlock();
+}
+
+void TLMMessagePool::Delete(TLMMessage* mess) {
+    TLMPooledMessage* pmess = static_cast<TLMPooledMessage*>(mess);
+
+    PoolLock.lock();
+    Stats.LiveBuffers--;
+    Stats.LiveBytes -= pmess->PoolCapacity;
+    PoolLock.unlock();
+
+    delete pmess;
+}
+
+void TLMMessagePool::TrimLocked(size_t maxFreeBytes) {
+    for(int i = int(FreeLists.size())-1; i >= 0 && Stats.FreeBytes > maxFreeBytes; --i) {
+        while(!FreeLists[i].empty() && Stats.FreeBytes > maxFreeBytes) {
+            TLMPooledMessage* pmess = static_cast<TLMPooledMessage*>(FreeLists[i].back());
+            FreeLists[i].pop_back();
+            Stats.FreeBuffers--;
+            Stats.FreeBytes -= pmess->PoolCapacity;
+            Stats.Trimmed++;
+            delete pmess;
+        }
+    }
+    // Empty (control message) buffers have no data but still count.
+    if(maxFreeBytes == 0) {
+        for(size_t i = 0; i < FreeLists.size(); ++i) {
+            while(!FreeLists[i].empty()) {
+                delete static_cast<TLMPooledMessage*>(FreeLists[i].back());
+                FreeLists[i].pop_back();
+                Stats.FreeBuffers--;
+                Stats.Trimmed++;
+            }
+        }
+    }
+}
+
+void TLMMessagePool::Trim(size_t maxFreeBytes) {
+    PoolLock.lock();
+    TrimLocked(maxFreeBytes);
+    PoolLock.unlock();
+}
+
+TLMMessagePoolStats TLMMessagePool::GetStats() {
+    PoolLock.lock();
+    TLMMessagePoolStats ret = Stats;
+    PoolLock.unlock();
+    return ret;
+}
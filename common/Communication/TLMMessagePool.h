@@ -0,0 +1,142 @@
+//!
+//! \file TLMMessagePool.h
+//!
+//! Defines the TLMMessagePool class, a thread safe size-class pool
+//! of message buffers used by TLMMessageQueue.
+//!
+
+#ifndef TLMMessagePool_h_
+#define TLMMessagePool_h_
+
+#include <vector>
+#include <cstddef>
+#include "TLMThreadSynch.h"
+#include "Communication/TLMCommUtil.h"
+
+//! Statistics of a TLMMessagePool. All byte counts refer to the
+//! reserved data capacity of the message buffers.
+struct TLMMessagePoolStats {
+    //! Number of buffers currently handed out.
+    size_t LiveBuffers;
+
+    //! Bytes in buffers currently handed out.
+    size_t LiveBytes;
+
+    //! Number of buffers waiting in the free lists.
+    size_t FreeBuffers;
+
+    //! Bytes in buffers waiting in the free lists.
+    size_t FreeBytes;
+
+    //! Largest value of LiveBytes+FreeBytes seen so far.
+    size_t PeakBytes;
+
+    //! Number of buffers allocated from the heap.
+    size_t Allocations;
+
+    //! Number of buffers handed out from the free lists.
+    size_t Reuses;
+
+    //! Number of buffers deleted by trimming.
+    size_t Trimmed;
+
+    //! Constructor, clears all counters.
+    TLMMessagePoolStats()
+        : LiveBuffers(0)
+        , LiveBytes(0)
+        , FreeBuffers(0)
+        , FreeBytes(0)
+        , PeakBytes(0)
+        , Allocations(0)
+        , Reuses(0)
+        , Trimmed(0)
+    {}
+};
+
+//! Class TLMMessagePool keeps free message buffers sorted in size classes.
+//! The classes are multiples of the time data record sizes
+//! (TLMTimeDataSignal, TLMTimeData1D and TLMTimeData3D), doubling up to
+//! MAX_BATCH_RECORDS records per message, so that a buffer that carried
+//! a batch of one interface type is reused for a batch of the same size.
+//! Buffers larger than the largest class are not kept.
+//! Messages are reference counted so that one data buffer can be
+//! sent to several destinations, see GetShared.
+class TLMMessagePool {
+
+    //! Maximum number of time data records per message covered by the size classes.
+    static const size_t MAX_BATCH_RECORDS = 64;
+
+    //! Capacity (in bytes) of each size class, sorted in ascending order.
+    std::vector<size_t> ClassCapacity;
+
+    //! Free buffers, one list per size class.
+    std::vector<std::vector<TLMMessage*> > FreeLists;
+
+    //! Maximum number of bytes kept in the free lists, 0 for no limit.
+    size_t MaxFreeBytes;
+
+    //! Pool statistics.
+    TLMMessagePoolStats Stats;
+
+    //! Lock protecting the free lists and the statistics.
+    SimpleLock PoolLock;
+
+    //! Return the smallest size class that holds "size" bytes or -1 if the size
+    //! is larger than the largest class.
+    int GetClassIndex(size_t size) const;
+
+    //! Drop one reference to a message buffer. The last reference puts the
+    //! buffer back in the free lists (keep) or deletes it (!keep).
+    void Unref(TLMMessage* mess, bool keep);
+
+    //! Put an unreferenced buffer back in the free lists.
+    void Return(TLMMessage* mess);
+
+    //! Delete an unreferenced buffer.
+    void Delete(TLMMessage* mess);
+
+    //! Delete buffers from the free lists, largest classes first,
+    //! until at most maxFreeBytes bytes are kept. Expects PoolLock to be held.
+    void TrimLocked(size_t maxFreeBytes);
+
+public:
+
+    //! Constructor
+    //! \param maxFreeBytes Maximum number of bytes kept in the free lists, 0 for no limit.
+    TLMMessagePool(size_t maxFreeBytes = 4*1024*1024);
+
+    //! Destructor, deletes all free buffers.
+    ~TLMMessagePool();
+
+    //! Get a message buffer with at least "size" bytes of data.
+    //! The data vector is resized to the capacity of the size class.
+    TLMMessage* Get(size_t size = 0);
+
+    //! Get a message that shares the data of "source" instead of copying it.
+    //! The header is copied and may be rewritten by the caller, the data
+    //! array of the returned message stays empty and must not be used.
+    //! Use GetData to get the shared data. The source is kept alive until
+    //! all messages sharing its data are released.
+    TLMMessage* GetShared(TLMMessage* source);
+
+    //! Get the data to be sent with a message obtained by Get or GetShared.
+    const unsigned char* GetData(TLMMessage* mess);
+
+    //! Return a message buffer obtained by Get or GetShared to the pool.
+    //! The buffer is reused once no shared message references it.
+    void Release(TLMMessage* mess);
+
+    //! Delete a message buffer obtained by Get or GetShared without keeping it.
+    void Discard(TLMMessage* mess);
+
+    //! Delete free buffers until at most maxFreeBytes bytes are kept.
+    void Trim(size_t maxFreeBytes = 0);
+
+    //! Delete all free buffers.
+    void Clear() { Trim(0); }
+
+    //! Get a copy of the pool statistics.
+    TLMMessagePoolStats GetStats();
+};
+
+#endif
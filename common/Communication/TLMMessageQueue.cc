@@ -18,38 +18,74 @@ TLMMessageQueue::~TLMMessageQueue() {
     }
     SendBufLock.unlock();
 
-    FreeBufLock.lock();
-    while(FreeBuffers.size() > 0) {
-        delete FreeBuffers.top();
-        FreeBuffers.pop();
-    }
-    FreeBufLock.unlock();
+    FreeBuffers.Clear();
 }
 
 
-TLMMessage* TLMMessageQueue::GetReadSlot() {
-    TLMMessage* ret = NULL;
-    FreeBufLock.lock();
-    if(FreeBuffers.size() > 0) {
-        ret = FreeBuffers.top();
-        FreeBuffers.pop();
-    }
-    FreeBufLock.unlock();
-    if(ret == NULL)
-        ret = new TLMMessage();
-    return ret;
+TLMMessage* TLMMessageQueue::GetReadSlot(size_t size) {
+    return FreeBuffers.Get(size);
 }
 
 // Put the message on the message send queue
 void TLMMessageQueue::PutWriteSlot(TLMMessage* mess) {
-    if(Terminated) return;
+    Put(mess, false);
+}
+
+// Put the message on the message send queue unless its link is full
+bool TLMMessageQueue::TryPutWriteSlot(TLMMessage* mess) {
+    return Put(mess, true);
+}
+
+TLMQueueLinkStats* TLMMessageQueue::FindLinkStats(const TLMMessage* mess) {
+    if(mess->Header.MessageType != TLMMessageTypeConst::TLM_TIME_DATA) {
+        return NULL;
+    }
+    std::pair<int,int> key(mess->SocketHandle, mess->Header.TLMInterfaceID);
+    std::map<std::pair<int,int>, TLMQueueLinkStats>::iterator it = LinkStats.find(key);
+    if(it == LinkStats.end()) {
+        it = LinkStats.insert(std::make_pair(key, TLMQueueLinkStats(key.first, key.second))).first;
+    }
+    return &it->second;
+}
+
+// The queue never blocks the caller: a producer waiting for the writer
+// could wait for a component that is itself blocked sending to the reader.
+// The reader rather stops reading a component whose link is full, see
+// ManagerCommHandler::ResumeComponents.
+bool TLMMessageQueue::Put(TLMMessage* mess, bool mayDrop) {
+    if(Terminated) return false;
 
     SendBufLock.lock();
+    if(Terminated) {
+        SendBufLock.unlock();
+        FreeBuffers.Discard(mess);
+        return false;
+    }
+
+    TLMQueueLinkStats* link = FindLinkStats(mess);
+    if(link != NULL) {
+        if(mayDrop && MaxDepth > 0 && link->Queued >= MaxDepth) {
+            link->NumDropped++;
+            NumDropped++;
+            SendBufLock.unlock();
+            ReleaseSlot(mess);
+            return false;
+        }
+        link->Queued++;
+        if(link->Queued > link->HighWaterMark) {
+            link->HighWaterMark = link->Queued;
+        }
+    }
+
     SendBuffers.push(mess);
+    if(SendBuffers.size() > HighWaterMark) {
+        HighWaterMark = SendBuffers.size();
+    }
     if(SendBuffers.size() == 1) {
         SenderWait.signal();
     }
     SendBufLock.unlock();
+    return true;
 }
 
 // Get the next message to be sent. May block if there are no
@@ -58,12 +94,25 @@ void TLMMessageQueue::PutWriteSlot(TLMMessage* mess) {
 TLMMessage* TLMMessageQueue::GetWriteSlot() {
     TLMMessage* ret = NULL;
     SendBufLock.lock();
+
+    // The previous message, if any, is sent.
+    SendingSocket = -1;
+    if(SendBuffers.empty()) {
+        SentWait.broadcast();
+    }
+
     if(SendBuffers.empty() && !Terminated) {
         SenderWait.wait(SendBufLock);
     }
     if(SendBuffers.size() >  0) {
         ret = SendBuffers.front();
         SendBuffers.pop();
+        SendingSocket = ret->SocketHandle;
+
+        TLMQueueLinkStats* link = FindLinkStats(ret);
+        if(link != NULL) {
+            link->Queued--;
+        }
     }
     SendBufLock.unlock();
 
@@ -73,29 +122,48 @@ TLMMessage* TLMMessageQueue::GetWriteSlot() {
     return ret;
 }
 
+void TLMMessageQueue::WaitUntilSent() {
+    SendBufLock.lock();
+    while((!SendBuffers.empty() || SendingSocket >= 0) && !Terminated) {
+        SentWait.wait(SendBufLock);
+    }
+    SendBufLock.unlock();
+}
+
+bool TLMMessageQueue::IsLinkFull(int socketHandle, int interfaceID) {
+    SendBufLock.lock();
+    bool full = false;
+    if(MaxDepth > 0) {
+        std::map<std::pair<int,int>, TLMQueueLinkStats>::const_iterator it =
+            LinkStats.find(std::make_pair(socketHandle, interfaceID));
+        full = (it != LinkStats.end() && it->second.Queued >= MaxDepth);
+    }
+    SendBufLock.unlock();
+    return full;
+}
+
+int TLMMessageQueue::GetSendingSocket() {
+    SendBufLock.lock();
+    int hdl = SendingSocket;
+    SendBufLock.unlock();
+    return hdl;
+}
+
 // Put a message back on the free slots stack.
 void TLMMessageQueue::ReleaseSlot(TLMMessage* mess) {
-    FreeBufLock.lock();
-    FreeBuffers.push(mess);
-    FreeBufLock.unlock();
+    FreeBuffers.Release(mess);
 }
 
 void TLMMessageQueue::Terminate() {
 
     //Clear free TLM messages
-    FreeBufLock.lock();
-    while(!FreeBuffers.empty()) {
-        TLMMessage *msg = FreeBuffers.top();
-        delete msg;
-        FreeBuffers.pop();
-    }
-    FreeBufLock.unlock();
+    FreeBuffers.Clear();
 
     //Clear messages from send queue (should probably not be any)
     SendBufLock.lock();
     while(!SendBuffers.empty()) {
         TLMMessage *msg = SendBuffers.front();
-        delete msg;
+        FreeBuffers.Discard(msg);
         SendBuffers.pop();
     }
     SendBufLock.unlock();
@@ -103,4 +171,35 @@ void TLMMessageQueue::Terminate() {
     Terminated = true;
     
     SenderWait.signal(); // to be sure that no one "hangs" on it
+    SentWait.broadcast();
+}
+
+void TLMMessageQueue::SetMaxDepth(size_t maxDepth) {
+    SendBufLock.lock();
+    MaxDepth = maxDepth;
+    SendBufLock.unlock();
+}
+
+size_t TLMMessageQueue::GetHighWaterMark() {
+    SendBufLock.lock();
+    size_t highWaterMark = HighWaterMark;
+    SendBufLock.unlock();
+    return highWaterMark;
+}
+
+size_t TLMMessageQueue::GetNumDropped() {
+    SendBufLock.lock();
+    size_t numDropped = NumDropped;
+    SendBufLock.unlock();
+    return numDropped;
+}
+
+void TLMMessageQueue::GetLinkStatistics(std::vector<TLMQueueLinkStats>& stats) {
+    SendBufLock.lock();
+    stats.clear();
+    std::map<std::pair<int,int>, TLMQueueLinkStats>::const_iterator it;
+    for(it = LinkStats.begin(); it != LinkStats.end(); ++it) {
+        stats.push_back(it->second);
+    }
+    SendBufLock.unlock();
 }
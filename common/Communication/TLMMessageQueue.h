@@ -8,9 +8,38 @@
 #define TLMMessageQueue_h_
 
 #include <queue>
-#include <stack>
+#include <map>
+#include <vector>
 #include "TLMThreadSynch.h"
 #include "Communication/TLMCommUtil.h"
+#include "Communication/TLMMessagePool.h"
+
+//! Send queue statistics of one link, i.e., of the time data queued for
+//! one interface on one socket (a component or a monitor).
+struct TLMQueueLinkStats {
+    //! Socket the messages are sent on.
+    int SocketHandle;
+
+    //! Interface ID in the header of the messages.
+    int InterfaceID;
+
+    //! Number of messages currently queued.
+    size_t Queued;
+
+    //! Largest number of messages queued at the same time.
+    size_t HighWaterMark;
+
+    //! Number of messages dropped because the link queue was full.
+    size_t NumDropped;
+
+    TLMQueueLinkStats(int hdl = -1, int ifcID = -1)
+        : SocketHandle(hdl)
+        , InterfaceID(ifcID)
+        , Queued(0)
+        , HighWaterMark(0)
+        , NumDropped(0)
+    {}
+};
 
 //! Class TLMMessageQueue is a thread-safe message queue as needed
 //! by the ManagerCommHandler class.
@@ -20,27 +49,62 @@ class TLMMessageQueue {
     SimpleLock SendBufLock;
     std::queue<TLMMessage*> SendBuffers;
 
-    //! Stack of free message buffers - to save allocations.
+    //! Pool of free message buffers sorted in size classes - to save allocations.
     //! Storage is messaged by this class.
-    SimpleLock FreeBufLock;
-    std::stack<TLMMessage*> FreeBuffers;
+    TLMMessagePool FreeBuffers;
 
     //! Nothing to be send. Wait on this.
     SimpleCond SenderWait;
 
+    //! Signalled when the sender is done with the queued messages.
+    SimpleCond SentWait;
+
+    //! Socket of the message the sender is sending, -1 while it waits
+    //! for the next message.
+    int SendingSocket;
+
+    //! Maximum number of time data messages queued per link. TryPutWriteSlot
+    //! drops the messages beyond it, the producers of PutWriteSlot are held
+    //! back with IsLinkFull. Zero means that the queue is unbounded.
+    size_t MaxDepth;
+
+    //! Largest send queue depth seen so far (high-water mark).
+    size_t HighWaterMark;
+
+    //! Total number of messages dropped by TryPutWriteSlot.
+    size_t NumDropped;
+
+    //! Statistics of each link, keyed by socket handle and interface ID.
+    //! Only time data messages are counted.
+    std::map<std::pair<int,int>, TLMQueueLinkStats> LinkStats;
+
     //! Terminated flag tells if the protocol is over and
     //! no more messages are expected in PutWriteSlot
     bool Terminated;
 
+    //! Queue the message, or drop it if "mayDrop" and its link is full.
+    bool Put(TLMMessage* mess, bool mayDrop);
+
+    //! Statistics of the link of a queued message, NULL if it is not time data.
+    //! SendBufLock must be held.
+    TLMQueueLinkStats* FindLinkStats(const TLMMessage* mess);
+
 public:
 
     //! Constructor
-    TLMMessageQueue()
+    //! \param maxDepth Maximum number of messages queued per link, 0 for
+    //!        unbounded.
+    TLMMessageQueue(size_t maxDepth = 0)
         : SendBufLock()
         , SendBuffers()
-        , FreeBufLock()
         , FreeBuffers()
         , SenderWait()
+        , SentWait()
+        , SendingSocket(-1)
+        , MaxDepth(maxDepth)
+        , HighWaterMark(0)
+        , NumDropped(0)
+        , LinkStats()
         , Terminated(false)
     {}
 
@@ -48,22 +112,69 @@ public:
     ~TLMMessageQueue();
 
     //! Get a free slot that can be filled in.
-    TLMMessage* GetReadSlot();
+    //! \param size Expected data size, used to select the buffer size class.
+    TLMMessage* GetReadSlot(size_t size = 0);
+
+    //! Get a slot that shares the data of "source" (zero-copy fan-out).
+    //! Only the header of the returned slot is to be rewritten.
+    TLMMessage* GetSharedSlot(TLMMessage* source) { return FreeBuffers.GetShared(source); }
 
-    //! Put the message on the message send queue
+    //! Get the data to be sent with a slot obtained by GetReadSlot or GetSharedSlot.
+    const unsigned char* GetSlotData(TLMMessage* mess) { return FreeBuffers.GetData(mess); }
+
+    //! Put the message on the message send queue. Never blocks, the
+    //! producer checks IsLinkFull afterwards and waits for room itself.
     void PutWriteSlot(TLMMessage* mess);
 
+    //! Put the message on the message send queue unless MaxDepth time data
+    //! messages are already queued on its link. Then the message is released
+    //! and counted as dropped, and false is returned. Never blocks. To be
+    //! used for messages that may be lost, i.e., the monitor feed.
+    bool TryPutWriteSlot(TLMMessage* mess);
+
     //! Get the next message to be sent. May block if there are no
     //! messages in the queue. Returns "NULL" if no messages to send
     //! left.
     TLMMessage* GetWriteSlot();
 
+    //! Wait until all queued messages are sent, i.e., the queue is empty
+    //! and the sender asks for the next message.
+    void WaitUntilSent();
+
+    //! Check if MaxDepth time data messages are queued for the interface
+    //! "interfaceID" on socket "socketHandle". Always false if unbounded.
+    bool IsLinkFull(int socketHandle, int interfaceID);
+
+    //! Get the socket of the message the sender is sending, -1 if none.
+    int GetSendingSocket();
+
     //! Put a message back on the free slots stack.
     void ReleaseSlot(TLMMessage* mess);
 
     //! Terminate function marks the end of communication protocol.
     //! It causes GetWriteSlot to return NULL.
     void Terminate();
+
+    //! Set the maximum queue depth per link, 0 for unbounded.
+    void SetMaxDepth(size_t maxDepth);
+
+    //! Get the maximum queue depth per link, 0 for unbounded.
+    size_t GetMaxDepth() const { return MaxDepth; }
+
+    //! Get the largest send queue depth seen so far.
+    size_t GetHighWaterMark();
+
+    //! Get the total number of messages dropped by TryPutWriteSlot.
+    size_t GetNumDropped();
+
+    //! Get the statistics of every link that queued time data.
+    void GetLinkStatistics(std::vector<TLMQueueLinkStats>& stats);
+
+    //! Get the message buffer pool statistics.
+    TLMMessagePoolStats GetPoolStats() { return FreeBuffers.GetStats(); }
+
+    //! Release free message buffers until at most maxFreeBytes bytes are kept.
+    void TrimPool(size_t maxFreeBytes = 0) { FreeBuffers.Trim(maxFreeBytes); }
 };
 
 #endif
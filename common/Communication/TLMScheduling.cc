@@ -0,0 +1,205 @@
+/**
+ * File: TLMScheduling.cc
+ *
+ * Implementation of the CPU affinity and scheduling settings
+ */
+#include "Communication/TLMScheduling.h"
+#include "Communication/TLMCommUtil.h"
+#include "Logging/TLMErrorLog.h"
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <fstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+bool TLMScheduling::ParseCPUList(const std::string& list, std::vector<int>& cpus) {
+    cpus.clear();
+
+    std::stringstream ss(list);
+    std::string item;
+    while(std::getline(ss, item, ',')) {
+        if(item.empty()) continue;
+
+        char* end;
+        long first = strtol(item.c_str(), &end, 10);
+        long last = first;
+        if(*end == '-') {
+            last = strtol(end + 1, &end, 10);
+        }
+        if(*end != '\0' || first < 0 || last < first) {
+            return false;
+        }
+
+        for(long cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(int(cpu));
+        }
+    }
+    return true;
+}
+
+bool TLMScheduling::IsValidPolicy(const std::string& policy) {
+    return policy.empty() || policy == "other" || policy == "fifo" || policy == "rr";
+}
+
+void TLMScheduling::GetAvailableCPUs(std::vector<int>& cpus) {
+    cpus.clear();
+
+#if defined(_WIN32)
+    DWORD_PTR processMask, systemMask;
+    if(GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)) {
+        for(int cpu = 0; cpu < int(8*sizeof(DWORD_PTR)); cpu++) {
+            if(processMask & (DWORD_PTR(1) << cpu)) cpus.push_back(cpu);
+        }
+    }
+#elif defined(__linux__)
+    cpu_set_t set;
+    if(sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for(int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if(CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+        }
+    }
+#endif
+
+    if(cpus.empty()) cpus.push_back(0);
+}
+
+int TLMScheduling::GetCacheDomain(int cpu) {
+#if defined(__linux__)
+    // The cache index with the highest level is the last level cache.
+    std::string cpuDir = "/sys/devices/system/cpu/cpu" + TLMErrorLog::ToStdStr(cpu) + "/cache/index";
+    int maxLevel = 0;
+    std::string shared;
+    for(int index = 0; ; index++) {
+        std::ifstream levelFile((cpuDir + TLMErrorLog::ToStdStr(index) + "/level").c_str());
+        int level = 0;
+        if(!(levelFile >> level)) break;
+
+        std::ifstream sharedFile((cpuDir + TLMErrorLog::ToStdStr(index) + "/shared_cpu_list").c_str());
+        std::string list;
+        if(level > maxLevel && (sharedFile >> list)) {
+            maxLevel = level;
+            shared = list;
+        }
+    }
+
+    std::vector<int> sharedCPUs;
+    if(ParseCPUList(shared, sharedCPUs) && !sharedCPUs.empty()) {
+        return sharedCPUs[0];
+    }
+#endif
+
+    return cpu;
+}
+
+bool TLMScheduling::SetThreadAffinity(const std::vector<int>& cpus) {
+    if(cpus.empty()) return true;
+
+#if defined(_WIN32)
+    DWORD_PTR mask = 0;
+    for(size_t i = 0; i < cpus.size(); i++) {
+        if(cpus[i] < int(8*sizeof(DWORD_PTR))) mask |= DWORD_PTR(1) << cpus[i];
+    }
+    if(mask == 0 || SetThreadAffinityMask(GetCurrentThread(), mask) == 0) {
+        TLMErrorLog::Warning("Failed to set the CPU affinity of the thread.");
+        return false;
+    }
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(size_t i = 0; i < cpus.size(); i++) {
+        if(cpus[i] < CPU_SETSIZE) CPU_SET(cpus[i], &set);
+    }
+    // On Linux, pid 0 refers to the calling thread.
+    if(sched_setaffinity(0, sizeof(set), &set) != 0) {
+        TLMErrorLog::Warning(std::string("Failed to set the CPU affinity of the thread: ") + strerror(errno));
+        return false;
+    }
+#else
+    TLMErrorLog::Warning("Setting the CPU affinity is not supported on this platform.");
+    return false;
+#endif
+
+    return true;
+}
+
+bool TLMScheduling::SetThreadScheduling(const std::string& policy, int priority) {
+    if(policy.empty()) return true;
+
+    if(!IsValidPolicy(policy)) {
+        TLMErrorLog::Warning("Unknown scheduling policy " + policy + ", use other, fifo or rr.");
+        return false;
+    }
+
+#if defined(_WIN32)
+    // Windows has no real-time policy for a single thread, the real-time
+    // policies are mapped to the highest thread priorities.
+    int winPriority = THREAD_PRIORITY_NORMAL;
+    if(policy != "other") {
+        winPriority = (priority > 50) ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST;
+    }
+    if(!SetThreadPriority(GetCurrentThread(), winPriority)) {
+        TLMErrorLog::Warning("Failed to set the thread priority.");
+        return false;
+    }
+#elif defined(__linux__)
+    int schedPolicy = SCHED_OTHER;
+    if(policy == "fifo") schedPolicy = SCHED_FIFO;
+    else if(policy == "rr") schedPolicy = SCHED_RR;
+
+    int minPriority = sched_get_priority_min(schedPolicy);
+    int maxPriority = sched_get_priority_max(schedPolicy);
+    if(priority < minPriority || priority > maxPriority) {
+        TLMErrorLog::Warning("Scheduling priority " + TLMErrorLog::ToStdStr(priority) + " is out of range for policy "
+                             + policy + ", using " + TLMErrorLog::ToStdStr(priority < minPriority ? minPriority : maxPriority));
+        priority = (priority < minPriority) ? minPriority : maxPriority;
+    }
+
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+
+    // On Linux, pid 0 refers to the calling thread.
+    if(sched_setscheduler(0, schedPolicy, &param) != 0) {
+        TLMErrorLog::Warning("Failed to set scheduling policy " + policy + ": " + strerror(errno));
+        return false;
+    }
+#else
+    (void)priority;
+    TLMErrorLog::Warning("Setting the scheduling policy is not supported on this platform.");
+    return false;
+#endif
+
+    return true;
+}
+
+void TLMScheduling::SetEnvironment(TLMEnvironment& env, const std::string& cpus, const std::string& policy, int priority) {
+    env.Set(TLM_CPUS_ENV, cpus);
+    env.Set(TLM_SCHED_POLICY_ENV, policy);
+    env.Set(TLM_SCHED_PRIORITY_ENV, TLMErrorLog::ToStdStr(priority));
+}
+
+void TLMScheduling::ApplyFromEnvironment() {
+    const char* cpus = getenv(TLM_CPUS_ENV);
+    if(cpus != NULL && cpus[0] != '\0') {
+        std::vector<int> cpuList;
+        if(ParseCPUList(cpus, cpuList)) {
+            TLMErrorLog::Info(std::string("Pinning the thread to CPUs ") + cpus);
+            SetThreadAffinity(cpuList);
+        }
+        else {
+            TLMErrorLog::Warning(std::string("Invalid CPU list in " TLM_CPUS_ENV ": ") + cpus);
+        }
+    }
+
+    const char* policy = getenv(TLM_SCHED_POLICY_ENV);
+    if(policy != NULL && policy[0] != '\0') {
+        const char* priority = getenv(TLM_SCHED_PRIORITY_ENV);
+        SetThreadScheduling(policy, priority != NULL ? atoi(priority) : 0);
+    }
+}
@@ -0,0 +1,54 @@
+//!
+//! \file TLMScheduling.h
+//!
+//! Defines the functions that pin the calling thread to a set of CPUs and
+//! set its scheduling policy. Used for the manager threads and, through
+//! the environment, for the solver thread of the components.
+//!
+
+#ifndef TLMScheduling_h_
+#define TLMScheduling_h_
+
+#include <string>
+#include <vector>
+
+class TLMEnvironment;
+
+//! Environment variables set by the manager for the components it starts.
+#define TLM_CPUS_ENV "OMTLM_CPUS"
+#define TLM_SCHED_POLICY_ENV "OMTLM_SCHED_POLICY"
+#define TLM_SCHED_PRIORITY_ENV "OMTLM_SCHED_PRIORITY"
+
+//! TLMScheduling sets the CPU affinity and the scheduling policy of the
+//! calling thread. Failures, e.g., missing permissions for a real-time
+//! policy, are logged as warnings and the thread keeps its settings.
+class TLMScheduling {
+public:
+    //! Parse a CPU list such as "0,2,4-7". Returns false on a syntax error.
+    static bool ParseCPUList(const std::string& list, std::vector<int>& cpus);
+
+    //! Check if the policy is one of "", "other", "fifo" or "rr".
+    static bool IsValidPolicy(const std::string& policy);
+
+    //! Get the CPUs the calling process may run on.
+    static void GetAvailableCPUs(std::vector<int>& cpus);
+
+    //! Returns the cache domain of the CPU, the lowest CPU sharing its last
+    //! level cache, or the CPU itself when the topology is unknown.
+    static int GetCacheDomain(int cpu);
+
+    //! Pin the calling thread to the CPUs, nothing is done for an empty list.
+    static bool SetThreadAffinity(const std::vector<int>& cpus);
+
+    //! Set the scheduling policy ("other", "fifo" or "rr") and priority of
+    //! the calling thread, nothing is done for an empty policy.
+    static bool SetThreadScheduling(const std::string& policy, int priority);
+
+    //! Set the environment of the component processes started from here.
+    static void SetEnvironment(TLMEnvironment& env, const std::string& cpus, const std::string& policy, int priority);
+
+    //! Apply the settings passed by the manager to the calling thread.
+    static void ApplyFromEnvironment();
+};
+
+#endif
@@ -8,8 +8,11 @@
 #include <sstream>
 #include <vector>
 #include <locale>
+#include <algorithm>
 #include "CompositeModels/CompositeModel.h"
 #include "Communication/TLMCommUtil.h"
+#include "Communication/TLMScheduling.h"
+#include "Logging/TLMTrace.h"
 //#include "portability.h"
 #include <cstdlib>
 
@@ -21,6 +24,9 @@
 #include <signal.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
 #else
 #include <process.h>
 #include <winsock2.h>
@@ -370,6 +376,21 @@ void omtlm_CompositeModel::StartComponents() {
 #else
     signal(SIGCHLD, child_signal_handler);
 #endif
+    // The settings are passed to the components in their environment,
+    // which is restored once they are started.
+    TLMEnvironment env;
+
+    PlaceComponents();
+
+    // The components spin on their socket if busy polling is enabled.
+    env.Set(TLM_BUSY_POLL_ENV, TLMErrorLog::ToStdStr(SimParams.GetBusyPollTime()));
+    // The components receive in a background thread if enabled.
+    env.Set(TLM_RECEIVER_THREAD_ENV, SimParams.GetReceiverThread() ? "1" : "0");
+    // The components write their traces next to the one of the manager.
+    if(TLMTrace::IsEnabled()) {
+        env.Set(TLM_TRACE_DIR_ENV, TLMTrace::GetDirectory());
+    }
+
     for(unsigned i = 0; i < Components.size(); i++) {
         TLMErrorLog::Info(string("-----  Starting External Tool  ----- "));
         TLMErrorLog::Info("Name: "+Components[i]->GetName());
@@ -411,10 +432,118 @@ void omtlm_CompositeModel::StartComponents() {
                          Components[i]->GetName() + " " +
                          TLMErrorLog::ToStdStr(maxStep));
 
+        // The components apply the CPU affinity and scheduling settings
+        // from their environment, see PluginImplementer::Init. A placed
+        // component is pinned to its CPU.
+        string cpus = SimParams.GetComponentCPUs();
+        if(Components[i]->GetCPU() >= 0) {
+            cpus = TLMErrorLog::ToStdStr(Components[i]->GetCPU());
+        }
+        TLMScheduling::SetEnvironment(env, cpus,
+                                      SimParams.GetSchedulingPolicy(),
+                                      SimParams.GetSchedulingPriority());
+
         Components[i]->StartComponent(SimParams, maxStep);
     }
 }
 
+// Place the components on the component CPUs. The components are ordered
+// so that strongly connected components follow each other, and are then
+// spread over the CPUs sorted by cache domain.
+void omtlm_CompositeModel::PlaceComponents() {
+    size_t numComps = Components.size();
+    if(SimParams.GetComponentPlacement() != "graph" || numComps == 0) return;
+
+    std::vector<int> cpuList;
+    TLMScheduling::ParseCPUList(SimParams.GetComponentCPUs(), cpuList);
+    if(cpuList.empty()) {
+        TLMScheduling::GetAvailableCPUs(cpuList);
+    }
+
+    // CPUs that share the last level cache are kept next to each other.
+    std::vector<std::pair<int, int> > cpus;
+    for(size_t i = 0; i < cpuList.size(); i++) {
+        cpus.push_back(std::make_pair(TLMScheduling::GetCacheDomain(cpuList[i]), cpuList[i]));
+    }
+    std::sort(cpus.begin(), cpus.end());
+
+    // Each connection exchanges a message in both directions every delay,
+    // so the link weight is the message rate 1/Delay.
+    std::vector<std::vector<double> > weight(numComps, std::vector<double>(numComps, 0.0));
+    std::vector<double> totalWeight(numComps, 0.0);
+    for(size_t i = 0; i < Connections.size(); i++) {
+        int from = Interfaces[Connections[i]->GetFromID()]->GetComponentID();
+        int to = Interfaces[Connections[i]->GetToID()]->GetComponentID();
+        if(from == to) continue;
+
+        double rate = 1.0 / std::max(Connections[i]->GetParams().Delay, 1e-9);
+        weight[from][to] += rate;
+        weight[to][from] += rate;
+        totalWeight[from] += rate;
+        totalWeight[to] += rate;
+    }
+
+    // Greedy ordering: take the unplaced component most strongly connected
+    // to the last placed one, then to all placed ones, then overall.
+    std::vector<int> order;
+    std::vector<double> placedWeight(numComps, 0.0);
+    std::vector<bool> placed(numComps, false);
+    while(order.size() < numComps) {
+        int best = -1;
+        for(size_t j = 0; j < numComps; j++) {
+            if(placed[j]) continue;
+            if(best < 0) {
+                best = int(j);
+                continue;
+            }
+            double lastJ = order.empty() ? 0.0 : weight[order.back()][j];
+            double lastBest = order.empty() ? 0.0 : weight[order.back()][best];
+            if(lastJ != lastBest) {
+                if(lastJ > lastBest) best = int(j);
+            }
+            else if(placedWeight[j] != placedWeight[best]) {
+                if(placedWeight[j] > placedWeight[best]) best = int(j);
+            }
+            else if(totalWeight[j] > totalWeight[best]) {
+                best = int(j);
+            }
+        }
+
+        placed[best] = true;
+        order.push_back(best);
+        for(size_t j = 0; j < numComps; j++) {
+            placedWeight[j] += weight[best][j];
+        }
+    }
+
+    // The components take consecutive CPUs. With more components than CPUs,
+    // neighbours in the order share a CPU.
+    std::vector<int> domain(numComps);
+    for(size_t k = 0; k < numComps; k++) {
+        size_t index = (numComps <= cpus.size()) ? k : k * cpus.size() / numComps;
+        const std::pair<int, int>& cpu = cpus[index];
+        Components[order[k]]->SetCPU(cpu.second);
+        domain[order[k]] = cpu.first;
+    }
+
+    TLMErrorLog::Info("-----  Component placement  ----- ");
+    for(size_t k = 0; k < numComps; k++) {
+        TLMComponentProxy& comp = *Components[order[k]];
+        TLMErrorLog::Info("Component " + comp.GetName() + ": CPU " + TLMErrorLog::ToStdStr(comp.GetCPU())
+                          + ", cache domain " + TLMErrorLog::ToStdStr(domain[order[k]]));
+    }
+
+    double sharedRate = 0.0, totalRate = 0.0;
+    for(size_t i = 0; i < numComps; i++) {
+        for(size_t j = i + 1; j < numComps; j++) {
+            totalRate += weight[i][j];
+            if(domain[i] == domain[j]) sharedRate += weight[i][j];
+        }
+    }
+    TLMErrorLog::Info("Message rate within cache domains: " + TLMErrorLog::ToStdStr(sharedRate)
+                      + " of " + TLMErrorLog::ToStdStr(totalRate) + " 1/s");
+}
+
 bool omtlm_CompositeModel::CheckProxyComm() {
     for(ComponentsVector::iterator it = Components.begin(); it!=Components.end(); ++it) {
         if(((*it)->GetSocketHandle() < 0) || !(*it)->GetReadyToSim()) {
@@ -533,7 +662,9 @@ void TLMComponentProxy::StartComponent(SimulationParams& SimParams, double MaxSt
         command << " " << serverName.c_str();
         command << " " << ModelName.c_str();
         TLMErrorLog::Info(string("Starting ") + command.str());
-        if(!CreateProcessA(NULL, (char *)command.str().c_str(), NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi)) {
+        // A placed component is started suspended and pinned before it runs.
+        DWORD creationFlags = (CPU >= 0) ? CREATE_SUSPENDED : 0;
+        if(!CreateProcessA(NULL, (char *)command.str().c_str(), NULL, NULL, FALSE, creationFlags, NULL, NULL, &si, &pi)) {
             TLMErrorLog::FatalError("StartComponent: Failed to start the component " + Name + " with command " + StartCommand + "."
                                                                                                                                 "Error is " + GetLastErrorStdStr());
             exit(-1);
@@ -541,6 +672,13 @@ void TLMComponentProxy::StartComponent(SimulationParams& SimParams, double MaxSt
             TLMErrorLog::Info(string("CreateProcessA Success"));
         }
 
+        if(CPU >= 0) {
+            if(CPU >= int(8*sizeof(DWORD_PTR)) || !SetProcessAffinityMask(pi.hProcess, DWORD_PTR(1) << CPU)) {
+                TLMErrorLog::Warning("StartComponent: Failed to pin the component " + Name + " to CPU " + TLMErrorLog::ToStdStr(CPU));
+            }
+            ResumeThread(pi.hThread);
+        }
+
         // Close process and thread handles.
         CloseHandle(pi.hProcess);
         CloseHandle(pi.hThread);
@@ -573,6 +711,17 @@ void TLMComponentProxy::StartComponent(SimulationParams& SimParams, double MaxSt
             TLMErrorLog::FatalError("StartComponent: Failed to start a component");
             break;
         case 0:   // I'm a child. I'll execute the program
+#ifdef __linux__
+            // Pin the child before exec, so that tools not using the TLM plugin
+            // are placed as well. Nothing is logged here since the manager
+            // threads may hold the log lock.
+            if(CPU >= 0 && CPU < CPU_SETSIZE) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(CPU, &set);
+                sched_setaffinity(0, sizeof(set), &set);
+            }
+#endif
             execlp(StartCommand.c_str(), StartCommand.c_str(),
                     Name.c_str(),
                     startTime.c_str(),
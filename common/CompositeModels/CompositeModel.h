@@ -243,6 +243,9 @@ class TLMComponentProxy {
     //! system (cG).
     double cX_A_cG[9];
 
+    //! CPU the component process is pinned to, -1 if not placed.
+    int CPU;
+
 public:
 
     //! Constructor.
@@ -260,7 +263,8 @@ public:
         SolverMode(aSolverMode),
         GeometryFile(aGeometryFile),
         SocketHandle(-1),
-        ReadyToSim(false)
+        ReadyToSim(false),
+        CPU(-1)
       //cX_R_cG_cG,
       //cX_A_cG
     {
@@ -299,6 +303,16 @@ public:
     //! Start the component executable
     void StartComponent(SimulationParams& SimParams, double MaxStep);
 
+    //! Set the CPU the component process is pinned to, -1 for no pinning.
+    void SetCPU(int cpu) {
+        CPU = cpu;
+    }
+
+    //! Returns the CPU the component process is pinned to, -1 if not placed.
+    int GetCPU() const {
+        return CPU;
+    }
+
     //! SetSocketHandle assigns a socket handle used for communications with the component.
     void SetSocketHandle(int hdl) {
         if((SocketHandle != -1)  && (hdl != -1)) {
@@ -417,10 +431,42 @@ class SimulationParams {
     //! Connection timeout in seconds used by server
     int Timeout;
 
+    //! Maximum number of time data messages waiting in the manager send
+    //! queue per link. Further full rate monitor messages are dropped (the
+    //! samples of decimated monitors are kept), and a component is not read
+    //! until its link has room again. Zero means unbounded.
+    int MessageQueueDepth;
+
+    //! CPUs of the manager threads, e.g., "2,3". The reader, writer and
+    //! monitor threads are pinned to one CPU each in turn. Empty for no pinning.
+    std::string ManagerCPUs;
+
+    //! CPUs the component processes are pinned to. Empty for no pinning.
+    std::string ComponentCPUs;
+
+    //! Scheduling policy of the manager threads and the components,
+    //! "other", "fifo" or "rr". Empty to keep the default policy.
+    std::string SchedulingPolicy;
+
+    //! Scheduling priority used with SchedulingPolicy.
+    int SchedulingPriority;
+
+    //! Placement of the component processes on the component CPUs, "shared"
+    //! for all components on all CPUs or "graph" for one CPU per component,
+    //! chosen from the connection graph.
+    std::string ComponentPlacement;
+
+    //! Time in seconds the manager reader and the components spin on their
+    //! sockets before they block, 0 to always block.
+    double BusyPollTime;
+
+    //! Set if the components receive their time data in a background thread.
+    bool ReceiverThread;
+
 public:
 
     //! Constructor
-    SimulationParams() {
+    SimulationParams() : MessageQueueDepth(0), SchedulingPriority(0), ComponentPlacement("shared"), BusyPollTime(0.0), ReceiverThread(false) {
         Set("127.0.0.1", 11111, 0.0, 1.0, 12111);
     }
 
@@ -505,6 +551,54 @@ public:
     //! Set write time step.
     void SetWriteTimeStep(double wts) { WriteTimeStep = wts; }
 
+    //! Returns the manager send queue depth per link, 0 for unbounded.
+    int GetMessageQueueDepth() const { return MessageQueueDepth; }
+
+    //! Set the manager send queue depth per link, 0 for unbounded.
+    void SetMessageQueueDepth(int depth) { MessageQueueDepth = depth; }
+
+    //! Returns the CPU list of the manager threads.
+    const std::string& GetManagerCPUs() const { return ManagerCPUs; }
+
+    //! Set the CPU list of the manager threads, e.g., "2,3" or "2-4".
+    void SetManagerCPUs(const std::string& cpus) { ManagerCPUs = cpus; }
+
+    //! Returns the CPU list of the component processes.
+    const std::string& GetComponentCPUs() const { return ComponentCPUs; }
+
+    //! Set the CPU list of the component processes.
+    void SetComponentCPUs(const std::string& cpus) { ComponentCPUs = cpus; }
+
+    //! Returns the scheduling policy, empty for the default policy.
+    const std::string& GetSchedulingPolicy() const { return SchedulingPolicy; }
+
+    //! Returns the scheduling priority.
+    int GetSchedulingPriority() const { return SchedulingPriority; }
+
+    //! Set the scheduling policy ("other", "fifo" or "rr") and priority.
+    void SetScheduling(const std::string& policy, int priority) {
+        SchedulingPolicy = policy;
+        SchedulingPriority = priority;
+    }
+
+    //! Returns the component placement, "shared" or "graph".
+    const std::string& GetComponentPlacement() const { return ComponentPlacement; }
+
+    //! Set the component placement, "shared" or "graph".
+    void SetComponentPlacement(const std::string& placement) { ComponentPlacement = placement; }
+
+    //! Returns the busy-poll time in seconds, 0 if disabled.
+    double GetBusyPollTime() const { return BusyPollTime; }
+
+    //! Set the busy-poll time in seconds, 0 to disable busy polling.
+    void SetBusyPollTime(double pollTime) { BusyPollTime = pollTime; }
+
+    //! Returns true if the components use a receiver thread.
+    bool GetReceiverThread() const { return ReceiverThread; }
+
+    //! Enable or disable the receiver thread of the components.
+    void SetReceiverThread(bool enable) { ReceiverThread = enable; }
+
 };
 
 //! Class CompositeModel
@@ -621,6 +715,10 @@ public:
     //! Start component executables
     void StartComponents();
 
+    //! Place the components on the component CPUs so that components
+    //! connected by links with short delays share a cache domain.
+    void PlaceComponents();
+
     //! Get the reference to the Model simulation parameters
     SimulationParams& GetSimParams() {
         return SimParams;
@@ -6,6 +6,7 @@
 
 #include "CompositeModels/CompositeModelReader.h"
 #include "Logging/TLMErrorLog.h"
+#include "Communication/TLMScheduling.h"
 #include "Interfaces/TLMInterface.h"
 #include "double3.h"
 #include "double33.h"
@@ -258,6 +259,77 @@ void CompositeModelReader::ReadSimParams(xmlNode* node) {
         WriteTimeStep = atof((const char*)curAttrVal->content);
     }
 
+    int MessageQueueDepth = TheModel.GetSimParams().GetMessageQueueDepth();
+    curAttrVal = FindAttributeByName(node, "MessageQueueDepth", false);
+    if(curAttrVal != 0) {
+        MessageQueueDepth = atoi((const char*)curAttrVal->content);
+        if(MessageQueueDepth < 0) {
+            TLMErrorLog::FatalError("MessageQueueDepth must be non-negative, check your model!");
+        }
+    }
+
+    std::vector<int> cpus;
+    std::string ManagerCPUs = TheModel.GetSimParams().GetManagerCPUs();
+    curAttrVal = FindAttributeByName(node, "ManagerCPUs", false);
+    if(curAttrVal != 0) {
+        ManagerCPUs = (const char*)curAttrVal->content;
+        if(!TLMScheduling::ParseCPUList(ManagerCPUs, cpus)) {
+            TLMErrorLog::FatalError("Invalid ManagerCPUs list " + ManagerCPUs + ", check your model!");
+        }
+    }
+
+    std::string ComponentCPUs = TheModel.GetSimParams().GetComponentCPUs();
+    curAttrVal = FindAttributeByName(node, "ComponentCPUs", false);
+    if(curAttrVal != 0) {
+        ComponentCPUs = (const char*)curAttrVal->content;
+        if(!TLMScheduling::ParseCPUList(ComponentCPUs, cpus)) {
+            TLMErrorLog::FatalError("Invalid ComponentCPUs list " + ComponentCPUs + ", check your model!");
+        }
+    }
+
+    std::string SchedulingPolicy = TheModel.GetSimParams().GetSchedulingPolicy();
+    curAttrVal = FindAttributeByName(node, "SchedulingPolicy", false);
+    if(curAttrVal != 0) {
+        SchedulingPolicy = (const char*)curAttrVal->content;
+        if(!TLMScheduling::IsValidPolicy(SchedulingPolicy)) {
+            TLMErrorLog::FatalError("SchedulingPolicy must be other, fifo or rr, check your model!");
+        }
+    }
+
+    int SchedulingPriority = TheModel.GetSimParams().GetSchedulingPriority();
+    curAttrVal = FindAttributeByName(node, "SchedulingPriority", false);
+    if(curAttrVal != 0) {
+        SchedulingPriority = atoi((const char*)curAttrVal->content);
+    }
+
+    std::string ComponentPlacement = TheModel.GetSimParams().GetComponentPlacement();
+    curAttrVal = FindAttributeByName(node, "ComponentPlacement", false);
+    if(curAttrVal != 0) {
+        ComponentPlacement = (const char*)curAttrVal->content;
+        if(ComponentPlacement != "shared" && ComponentPlacement != "graph") {
+            TLMErrorLog::FatalError("ComponentPlacement must be shared or graph, check your model!");
+        }
+    }
+
+    double BusyPollTime = TheModel.GetSimParams().GetBusyPollTime();
+    curAttrVal = FindAttributeByName(node, "BusyPollTime", false);
+    if(curAttrVal != 0) {
+        BusyPollTime = atof((const char*)curAttrVal->content);
+        if(BusyPollTime < 0.0) {
+            TLMErrorLog::FatalError("BusyPollTime must not be negative, check your model!");
+        }
+    }
+
+    bool ReceiverThread = TheModel.GetSimParams().GetReceiverThread();
+    curAttrVal = FindAttributeByName(node, "ReceiverThread", false);
+    if(curAttrVal != 0) {
+        std::string value = (const char*)curAttrVal->content;
+        if(value != "true" && value != "false") {
+            TLMErrorLog::FatalError("ReceiverThread must be true or false, check your model!");
+        }
+        ReceiverThread = (value == "true");
+    }
+
     //curAttrVal = FindAttributeByName(node, "SimInputFile");
     //std::string Infile = (const char*)curAttrVal->content;
 
@@ -266,10 +338,21 @@ void CompositeModelReader::ReadSimParams(xmlNode* node) {
     TheModel.GetSimParams().SetStartTime(StartTime);
     TheModel.GetSimParams().SetEndTime(StopTime);
     TheModel.GetSimParams().SetWriteTimeStep(WriteTimeStep);
+    TheModel.GetSimParams().SetMessageQueueDepth(MessageQueueDepth);
+    TheModel.GetSimParams().SetManagerCPUs(ManagerCPUs);
+    TheModel.GetSimParams().SetComponentCPUs(ComponentCPUs);
+    TheModel.GetSimParams().SetScheduling(SchedulingPolicy, SchedulingPriority);
+    TheModel.GetSimParams().SetComponentPlacement(ComponentPlacement);
+    TheModel.GetSimParams().SetBusyPollTime(BusyPollTime);
+    TheModel.GetSimParams().SetReceiverThread(ReceiverThread);
 
     TLMErrorLog::Info("StartTime     = "+TLMErrorLog::ToStdStr(StartTime)+" s");
     TLMErrorLog::Info("StopTime      = "+TLMErrorLog::ToStdStr(StopTime)+" s");
     TLMErrorLog::Info("WriteTimeStep = "+TLMErrorLog::ToStdStr(WriteTimeStep)+" s");
+    TLMErrorLog::Info("MessageQueueDepth = "+TLMErrorLog::ToStdStr(MessageQueueDepth));
+    if(!SchedulingPolicy.empty()) {
+        TLMErrorLog::Info("SchedulingPolicy = "+SchedulingPolicy+", priority "+TLMErrorLog::ToStdStr(SchedulingPriority));
+    }
 }
 
 
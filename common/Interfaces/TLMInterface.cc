@@ -9,6 +9,7 @@
 #include "Plugin/TLMPlugin.h"
 #include <deque>
 #include <string>
+#include <cmath>
 #include "double33.h"
 
 using std::deque;
@@ -34,7 +35,10 @@ omtlm_TLMInterface::omtlm_TLMInterface(TLMClientComm& theComm, std::string& aNam
     waitForShutdownFlg(false),
     Dimensions(dimensions),
     Causality(causality),
-    Domain(domain) {
+    Domain(domain),
+    Extrapolation() {
+
+    NextExtrapolationWarning[0] = NextExtrapolationWarning[1] = 1;
 
     Message = new TLMMessage();
     Comm.CreateInterfaceRegMessage(aName, Dimensions, Causality, Domain, *Message);
@@ -58,10 +62,49 @@ omtlm_TLMInterface::omtlm_TLMInterface(TLMClientComm& theComm, std::string& aNam
 
 omtlm_TLMInterface::~omtlm_TLMInterface()
 {
+    if(Extrapolation.NumBackward > 0 || Extrapolation.NumForward > 0) {
+        TLMErrorLog::Info(std::string("Interface ") + GetName() + " extrapolated back " +
+                          TLMErrorLog::ToStdStr(int(Extrapolation.NumBackward)) + " times (max time error = " +
+                          TLMErrorLog::ToStdStr(Extrapolation.MaxBackwardError) + ") and forward " +
+                          TLMErrorLog::ToStdStr(int(Extrapolation.NumForward)) + " times (max time error = " +
+                          TLMErrorLog::ToStdStr(Extrapolation.MaxForwardError) + ")");
+    }
+
     delete Message;
 }
 
 
+// Count an extrapolation and log a rate limited warning.
+void omtlm_TLMInterface::CountExtrapolation(double time, double dataTime) {
+    bool forward = (time > dataTime);
+    double terror = fabs(time - dataTime);
+
+    long count;
+    double maxError;
+    if(forward) {
+        count = ++Extrapolation.NumForward;
+        if(terror > Extrapolation.MaxForwardError) Extrapolation.MaxForwardError = terror;
+        maxError = Extrapolation.MaxForwardError;
+    }
+    else {
+        count = ++Extrapolation.NumBackward;
+        if(terror > Extrapolation.MaxBackwardError) Extrapolation.MaxBackwardError = terror;
+        maxError = Extrapolation.MaxBackwardError;
+    }
+
+    if(count < NextExtrapolationWarning[forward]) return;
+    NextExtrapolationWarning[forward] *= 10;
+
+    if(TLMErrorLog::IsLogged(TLMLogLevel::Warning)) {
+        TLMErrorLog::Warning(std::string("Interface ") + GetName() + " needs to extrapolate " +
+                             (forward ? "forward" : "back") + " time= " + TLMErrorLog::ToStdStr(time) +
+                             ", time error = " + TLMErrorLog::ToStdStr(terror) +
+                             " (" + TLMErrorLog::ToStdStr(int(count)) + " times so far, max time error = " +
+                             TLMErrorLog::ToStdStr(maxError) + ")");
+    }
+}
+
+
 // Hermite cubic interpolation. For the given 4 data points t[i], f[i] and time,
 // such that t[0]<t[1]<time<t[2]<t[3], returns f(time). .
 double omtlm_TLMInterface::InterpolateHermite(double time, double t[4], double f[4]) {
@@ -12,10 +12,29 @@
 #include <queue>
 #include <vector>
 #include <string>
+#include <atomic>
 #include "Communication/TLMCommUtil.h"
 #include "Communication/TLMClientComm.h"
+#include "Communication/TLMThreadSynch.h"
 #include "common.h"
 
+//! Statistics of the requests an interface could not interpolate, i.e.,
+//! where the data had to be extrapolated back or forward in time.
+struct TLMExtrapolationStats {
+    //! Number of requests before the first received sample.
+    long NumBackward;
+
+    //! Number of requests after the last received sample.
+    long NumForward;
+
+    //! Largest distance in time to the sample used, per direction.
+    double MaxBackwardError;
+    double MaxForwardError;
+
+    TLMExtrapolationStats()
+        : NumBackward(0), NumForward(0), MaxBackwardError(0.0), MaxForwardError(0.0) {}
+};
+
 //!
 //! TLMInterface provides the client side functionality for a single TLM interface
 //!
@@ -59,6 +78,17 @@ public:
     //! Get parameters for the TLM connection attached to the interface
     const TLMConnectionParams& GetConnParams() const { return Params; }
 
+    //! Get the extrapolation statistics of the interface
+    const TLMExtrapolationStats& GetExtrapolationStats() const { return Extrapolation; }
+
+    //! Get the lock that guards the time data of the interface when the
+    //! plugin is used from several threads.
+    SimpleLock& GetDataLock() { return DataLock; }
+
+    //! Get the condition that is signalled with the data lock held when new
+    //! time data was unpacked by the receiver thread of the plugin.
+    SimpleCond& GetDataReady() { return DataReady; }
+
 protected:
 
     //! Linear interpolation (can be used for linear extrapolation as well)
@@ -74,12 +104,18 @@ protected:
     //! such that t[0]<t[1]<time<t[2]<t[3], returns f(time). .
     static double InterpolateHermite(double time, double t[4], double f[4]);
 
+    //! Count a request for "time" that is answered with the sample at
+    //! "dataTime" outside the received data. Warnings are rate limited,
+    //! the first one and then one every tenfold count is logged.
+    void CountExtrapolation(double time, double dataTime);
+
     //! Last time when the data was sent
     double LastSendTime;
 
     //! Next time when we don't have data for interpolation and need to wait for
-    //! the information from the couple simulation.
-    double NextRecvTime;
+    //! the information from the couple simulation. Atomic, so that the
+    //! plugin can check for new data without taking the data lock.
+    std::atomic<double> NextRecvTime;
 
     //! Message buffer used to transfer information between different methods
     TLMMessage *Message;
@@ -107,5 +143,18 @@ protected:
     int Dimensions;
     std::string Causality;
     std::string Domain;
+
+    //! Extrapolation statistics
+    TLMExtrapolationStats Extrapolation;
+
+    //! Count at which the next extrapolation warning is logged, per
+    //! direction (back, forward).
+    long NextExtrapolationWarning[2];
+
+    //! Guards the time data in thread-safe mode, see TLMPlugin::SetThreadSafe
+    SimpleLock DataLock;
+
+    //! Signalled when new time data has arrived, see GetDataReady
+    SimpleCond DataReady;
 };
 #endif
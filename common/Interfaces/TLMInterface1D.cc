@@ -18,7 +18,7 @@ TLMInterface1D::~TLMInterface1D() {
                          TLMErrorLog::ToStdStr(DataToSend.back().time));
 
         Comm.PackTimeDataMessage1D(InterfaceID, DataToSend, *Message);
-        TLMCommUtil::SendMessage(*Message);
+        Comm.SendMessage(*Message);
     }
 }
 
@@ -94,10 +94,7 @@ void TLMInterface1D::GetTimeData(TLMTimeData1D& Instance, std::deque<TLMTimeData
     }
     else {
         if(time <= Data[0].time) {
-            if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Warning) {
-                TLMErrorLog::Warning(std::string("Interface ") + GetName() + " needs to extrapolate back time= " +
-                                     TLMErrorLog::ToStdStr(time));
-            }
+            CountExtrapolation(time, Data[0].time);
             Instance = Data[0];
         }
         else {
@@ -107,11 +104,7 @@ void TLMInterface1D::GetTimeData(TLMTimeData1D& Instance, std::deque<TLMTimeData
                 Instance = Data[size-1];
             }
             else {
-                double terror = fabs(time-Data[size-1].time);
-                if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Warning) {
-                    TLMErrorLog::Warning(std::string("Interface ") + GetName() + " needs to extrapolate forward time= " +
-                                         TLMErrorLog::ToStdStr(time)+", time error = "+TLMErrorLog::ToStdStr(terror));
-                }
+                CountExtrapolation(time, Data[size-1].time);
                 if(size > 1) {
                     // linear extrapolation
                     InterpolateLinear(Instance, Data[size-2], Data[size-1], OnlyForce);
@@ -143,11 +136,9 @@ void TLMInterface1D::GetForce(double time,
         TLMPlugin::GetForce1D(speed, request, Params, force);
     }
 
-    if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Warning) {
-        TLMErrorLog::Warning("Time = "+std::to_string(time)+
-                             ", GetForce(speed="+std::to_string(speed)+
-                             ") returns force="+std::to_string(*force));
-    }
+    TLM_LOG_DEBUG("Time = "+std::to_string(time)+
+                  ", GetForce(speed="+std::to_string(speed)+
+                  ") returns force="+std::to_string(*force));
 }
 
 void TLMInterface1D::GetWave(double time, double *wave) {
@@ -206,7 +197,7 @@ void TLMInterface1D::SetTimeData(double time,
         item.GenForce   = -item.GenForce   +  Params.Zf * speed;
     }
 
-    if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
+    if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
         TLMErrorLog::Info(std::string("Interface ") + GetName() +
                           " SET for time= " + TLMErrorLog::ToStdStr(time));
     }
@@ -226,13 +217,13 @@ void TLMInterface1D::SetTimeData(double time,
 void TLMInterface1D::SendAllData() {
     LastSendTime = DataToSend.back().time;
 
-    if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
+    if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
         TLMErrorLog::Info(std::string("Interface ") + GetName() + " sends data for time= " +
                           TLMErrorLog::ToStdStr(LastSendTime));
     }
 
     Comm.PackTimeDataMessage1D(InterfaceID, DataToSend, *Message);
-    TLMCommUtil::SendMessage(*Message);
+    Comm.SendMessage(*Message);
     DataToSend.resize(0);
 
     // In data request mode we shutdown after sending the first data package.
@@ -18,13 +18,13 @@ TLMInterface3D::~TLMInterface3D() {
                          TLMErrorLog::ToStdStr(DataToSend.back().time));
 
         Comm.PackTimeDataMessage3D(InterfaceID, DataToSend, *Message);
-        TLMCommUtil::SendMessage(*Message);
+        Comm.SendMessage(*Message);
     }
 }
 
 
 void TLMInterface3D::UnpackTimeData(TLMMessage &mess) {
-    TLMErrorLog::Info(std::string("Interface ") + GetName());
+    TLM_LOG_INFO(std::string("Interface ") + GetName());
     Comm.UnpackTimeDataMessage3D(mess, TimeData);
 
     NextRecvTime =  TimeData.back().time + Params.Delay;
@@ -127,8 +127,7 @@ void TLMInterface3D::GetTimeData(TLMTimeData3D& Instance, std::deque<TLMTimeData
     }
     else {
         if(time <= Data[0].time) {
-            TLMErrorLog::Warning(std::string("Interface ") + GetName() + " needs to extrapolate back time= " +
-                                 TLMErrorLog::ToStdStr(time));
+            CountExtrapolation(time, Data[0].time);
             Instance = Data[0];
         }
         else {
@@ -138,8 +137,7 @@ void TLMInterface3D::GetTimeData(TLMTimeData3D& Instance, std::deque<TLMTimeData
                 Instance = Data[size-1];
             }
             else {
-                TLMErrorLog::Warning(std::string("Interface ") + GetName() + " needs to extrapolate forward time= " +
-                                     TLMErrorLog::ToStdStr(time));
+                CountExtrapolation(time, Data[size-1].time);
                 if(size > 1) {
                     // linear extrapolation
                     InterpolateLinear(Instance, Data[size-2], Data[size-1], OnlyForce);
@@ -240,7 +238,7 @@ void TLMInterface3D::SetTimeData(double time,
         item.GenForce[i+3] = -item.GenForce[i+3] +  Params.Zfr * ang_speed[i];
     }
 
-    if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
+    if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
         TLMErrorLog::Info(std::string("Interface ") + GetName() +
                          " SET for time= " + TLMErrorLog::ToStdStr(time)
                          //  		     + " force:"
@@ -316,7 +314,7 @@ void TLMInterface3D::TransformTimeDataToCG(std::vector<TLMTimeData3D>& timeData,
 void TLMInterface3D::SendAllData() {
     LastSendTime = DataToSend.back().time;
 
-    if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
+    if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
         TLMErrorLog::Info(std::string("Interface ") + GetName() + " sends data for time= " +
                          TLMErrorLog::ToStdStr(LastSendTime));
     }
@@ -325,7 +323,7 @@ void TLMInterface3D::SendAllData() {
     TransformTimeDataToCG(DataToSend, Params);
 
     Comm.PackTimeDataMessage3D(InterfaceID, DataToSend, *Message);
-    TLMCommUtil::SendMessage(*Message);
+    Comm.SendMessage(*Message);
     DataToSend.resize(0);
 
     // In data request mode we shutdown after sending the first data package.
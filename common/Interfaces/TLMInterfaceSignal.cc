@@ -27,13 +27,13 @@ void TLMInterfaceSignal::UnpackTimeData(TLMMessage &mess) {
 void TLMInterfaceSignal::SendAllData() {
     LastSendTime = DataToSend.back().time;
 
-    if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
+    if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
         TLMErrorLog::Info(std::string("Interface ") + GetName() + " sends data for time= " +
                          TLMErrorLog::ToStdStr(LastSendTime));
     }
 
     Comm.PackTimeDataMessageSignal(InterfaceID, DataToSend, *Message);
-    TLMCommUtil::SendMessage(*Message);
+    Comm.SendMessage(*Message);
     DataToSend.resize(0);
 
     // In data request mode we shutdown after sending the first data package.
@@ -107,8 +107,7 @@ void TLMInterfaceSignal::GetTimeData(TLMTimeDataSignal& Instance, std::deque<TLM
     }
     else {
         if (time <= Data[0].time) {
-            TLMErrorLog::Warning(std::string("Interface ") + GetName() + " needs to extrapolate back time= " +
-                                 TLMErrorLog::ToStdStr(time));
+            CountExtrapolation(time, Data[0].time);
             Instance = Data[0];
         }
         else{
@@ -118,8 +117,7 @@ void TLMInterfaceSignal::GetTimeData(TLMTimeDataSignal& Instance, std::deque<TLM
                 Instance = Data[size-1];
             }
             else {
-                TLMErrorLog::Warning(std::string("Interface ") + GetName() + " needs to extrapolate forward time= " +
-                                     TLMErrorLog::ToStdStr(time));
+                CountExtrapolation(time, Data[size-1].time);
                 if(size > 1) {
                     // linear extrapolation
                     linear_interpolate(Instance, Data[size-2], Data[size-1]);
@@ -14,13 +14,13 @@ TLMInterfaceOutput::TLMInterfaceOutput(TLMClientComm &theComm, std::string &aNam
 
 TLMInterfaceOutput::~TLMInterfaceOutput() {
     if(DataToSend.size() != 0) {
-        if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
+        if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
             TLMErrorLog::Info(std::string("Interface ") + GetName() + " sends rest of data for time= " +
                               TLMErrorLog::ToStdStr(DataToSend.back().time));
         }
 
         Comm.PackTimeDataMessageSignal(InterfaceID, DataToSend, *Message);
-        TLMCommUtil::SendMessage(*Message);
+        Comm.SendMessage(*Message);
     }
 }
 
@@ -35,7 +35,7 @@ void TLMInterfaceOutput::SetTimeData(double time,
     item.time = time;
     item.Value = value;
 
-    if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
+    if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
         TLMErrorLog::Info(std::string("Interface ") + GetName() +
                           " SET for time= " + TLMErrorLog::ToStdStr(time));
     }
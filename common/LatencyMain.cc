@@ -0,0 +1,198 @@
+//
+// File: LatencyMain.cc
+//
+// Measures the round trip time of TLM messages over a loopback socket, with
+// blocking receives and with busy polling (tlmmanager -b). An echo thread
+// plays the role of the manager and returns each message to the sender.
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <cstdlib>
+#include "Communication/TLMCommUtil.h"
+#include "Communication/TLMScheduling.h"
+#include "Logging/TLMErrorLog.h"
+
+#ifdef _MSC_VER
+#include "mygetopt.h"
+#else
+#include <getopt.h>
+#include <unistd.h>
+#endif
+
+#ifdef WIN32
+#include <ws2tcpip.h>
+#define closeSocket closesocket
+#else
+#define closeSocket close
+#endif
+
+using std::string;
+
+static void Usage() {
+    std::cout << "Usage: tlmlatency [-b <poll-time>] [-c <cpu-list>] [-n <round-trips>] [-s <data-size>]\n"
+                 "Measures the round trip time of TLM messages with blocking receives and with busy polling.\n"
+                 "-b <poll-time>   : busy-poll time in seconds, default 0.001\n"
+                 "-c <cpu-list>    : pin the sender and the echo thread to the CPUs, one each in turn\n"
+                 "-n <round-trips> : number of measured round trips, default 10000\n"
+                 "-s <data-size>   : message data size in bytes, default 64\n";
+    exit(1);
+}
+
+//! Create a connected pair of loopback TCP sockets.
+static void CreateSocketPair(int& first, int& second) {
+    int listenSocket = int(socket(AF_INET, SOCK_STREAM, 0));
+
+    struct sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    sa.sin_port = 0;
+
+    socklen_t len = sizeof(sa);
+    if(listenSocket < 0
+       || bind(listenSocket, (struct sockaddr*)&sa, sizeof(sa)) != 0
+       || listen(listenSocket, 1) != 0
+       || getsockname(listenSocket, (struct sockaddr*)&sa, &len) != 0) {
+        TLMErrorLog::FatalError("Failed to create the loopback server socket");
+    }
+
+    first = int(socket(AF_INET, SOCK_STREAM, 0));
+    if(first < 0 || connect(first, (struct sockaddr*)&sa, sizeof(sa)) != 0) {
+        TLMErrorLog::FatalError("Failed to connect to the loopback socket");
+    }
+
+    second = int(accept(listenSocket, NULL, NULL));
+    if(second < 0) {
+        TLMErrorLog::FatalError("Failed to accept the loopback connection");
+    }
+
+    closeSocket(listenSocket);
+}
+
+//! Pin the calling thread to the CPU with the index, if a list is given.
+static void PinThread(const std::vector<int>& cpus, int index) {
+    if(!cpus.empty()) {
+        TLMScheduling::SetThreadAffinity(std::vector<int>(1, cpus[index % cpus.size()]));
+    }
+}
+
+//! Return each received message to the sender, until the socket is closed.
+static void EchoThread(int socket, std::vector<int> cpus, double pollTime) {
+    PinThread(cpus, 1);
+
+    TLMMessage mess;
+    mess.SocketHandle = socket;
+    while(TLMCommUtil::ReceiveMessage(mess, pollTime)) {
+        TLMCommUtil::SendMessage(mess);
+    }
+}
+
+//! Run the round trips and print the statistics in microseconds.
+static void Measure(const string& mode, double pollTime, int numRoundTrips, int dataSize, const std::vector<int>& cpus) {
+    int sender, echo;
+    CreateSocketPair(sender, echo);
+    std::thread echoThread(EchoThread, echo, cpus, pollTime);
+
+    TLMMessage mess;
+    mess.SocketHandle = sender;
+    mess.Header.MessageType = TLMMessageTypeConst::TLM_TIME_DATA;
+    mess.Header.DataSize = dataSize;
+    mess.Data.resize(dataSize);
+
+    // The first round trips warm up the caches and the socket buffers.
+    int numWarmUp = std::min(numRoundTrips / 10, 1000);
+    std::vector<double> roundTrips;
+    roundTrips.reserve(numRoundTrips);
+    for(int i = 0; i < numWarmUp + numRoundTrips; i++) {
+        double start = TLMCommUtil::GetWallClockTime();
+        TLMCommUtil::SendMessage(mess);
+        if(!TLMCommUtil::ReceiveMessage(mess, pollTime)) {
+            TLMErrorLog::FatalError("The echo thread closed the socket");
+        }
+        if(i >= numWarmUp) {
+            roundTrips.push_back((TLMCommUtil::GetWallClockTime() - start) * 1e6);
+        }
+    }
+
+    closeSocket(sender);
+    echoThread.join();
+    closeSocket(echo);
+
+    std::sort(roundTrips.begin(), roundTrips.end());
+    double sum = 0.0;
+    for(size_t i = 0; i < roundTrips.size(); i++) {
+        sum += roundTrips[i];
+    }
+    size_t n = roundTrips.size();
+
+    std::cout << std::left << std::setw(10) << mode << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << roundTrips[0]
+              << std::setw(10) << sum / n
+              << std::setw(10) << roundTrips[n / 2]
+              << std::setw(10) << roundTrips[std::min(n - 1, n * 99 / 100)]
+              << std::setw(10) << roundTrips[n - 1] << "\n";
+}
+
+int main(int argc, char* argv[]) {
+    double busyPollTime = 1e-3;
+    int numRoundTrips = 10000;
+    int dataSize = 64;
+    std::vector<int> cpus;
+
+    int c;
+    while((c = getopt(argc, argv, "b:c:n:s:")) != -1) {
+        switch(c) {
+        case 'b':
+            busyPollTime = atof(optarg);
+            break;
+        case 'c':
+            if(!TLMScheduling::ParseCPUList(optarg, cpus)) Usage();
+            break;
+        case 'n':
+            numRoundTrips = atoi(optarg);
+            break;
+        case 's':
+            dataSize = atoi(optarg);
+            break;
+        default:
+            Usage();
+            break;
+        }
+    }
+    if(optind < argc || numRoundTrips <= 0 || dataSize < 0 || busyPollTime <= 0.0) {
+        Usage();
+    }
+
+#ifdef WIN32
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+    PinThread(cpus, 0);
+
+    // The sender and the echo thread both spin, which only pays off when
+    // each has a core of its own.
+    std::vector<int> available;
+    TLMScheduling::GetAvailableCPUs(available);
+    if(available.size() < 2 || cpus.size() == 1) {
+        std::cout << "Note: busy polling needs a dedicated core per thread, the threads share a core here.\n";
+    }
+
+    std::cout << numRoundTrips << " round trips of " << dataSize << " bytes, times in microseconds\n";
+    std::cout << std::left << std::setw(10) << "mode" << std::right
+              << std::setw(10) << "min" << std::setw(10) << "avg" << std::setw(10) << "median"
+              << std::setw(10) << "p99" << std::setw(10) << "max" << "\n";
+
+    Measure("blocking", 0.0, numRoundTrips, dataSize, cpus);
+    Measure("busy-poll", busyPollTime, numRoundTrips, dataSize, cpus);
+
+#ifdef WIN32
+    WSACleanup();
+#endif
+
+    return 0;
+}
@@ -0,0 +1,221 @@
+/**
+ * File: TLMCompressedStream.cc
+ *
+ * Implementation of the block compressed output streams
+ */
+#include "Logging/TLMCompressedStream.h"
+#include "Logging/TLMErrorLog.h"
+#include <cstring>
+#include <zlib.h>
+
+namespace {
+    //! Maximum uncompressed size of a block, as used by bgzip.
+    const size_t BlockSize = 0xff00;
+
+    //! Maximum size of a compressed block including header and footer.
+    const size_t MaxBlockSize = 0x10000;
+
+    //! Size of the gzip header with the BGZF extra field.
+    const size_t HeaderSize = 18;
+
+    //! Size of the gzip footer, CRC32 and uncompressed size.
+    const size_t FooterSize = 8;
+
+    //! Empty block marking the end of a BGZF file.
+    const unsigned char EOFBlock[28] = {
+        0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43,
+        0x02, 0x00, 0x1b, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+    };
+
+    //! Store a little endian value of "n" bytes.
+    void PutLittleEndian(unsigned char* p, unsigned long value, int n) {
+        for(int i = 0; i < n; i++) {
+            p[i] = (unsigned char)((value >> (8*i)) & 0xff);
+        }
+    }
+
+    //! Raw deflate of "size" bytes into "out", returns the compressed size or 0 if it does not fit.
+    size_t Deflate(const char* data, size_t size, unsigned char* out, size_t outSize, int level) {
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        if(deflateInit2(&zs, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) return 0;
+
+        zs.next_in = (Bytef*)data;
+        zs.avail_in = (uInt)size;
+        zs.next_out = out;
+        zs.avail_out = (uInt)outSize;
+
+        int status = deflate(&zs, Z_FINISH);
+        size_t compressedSize = zs.total_out;
+        deflateEnd(&zs);
+
+        return (status == Z_STREAM_END) ? compressedSize : 0;
+    }
+}
+
+TLMCompressedStreamBuf::TLMCompressedStreamBuf()
+    : std::streambuf(),
+      File(NULL),
+      FillBlock(),
+      FlushBlock(),
+      FlushSize(0),
+      OutBuffer(),
+      FlushPending(false),
+      StopCompressor(false),
+      Background(false),
+      BlockLock(),
+      FlushReadyCond(),
+      FlushDoneCond()
+{
+}
+
+TLMCompressedStreamBuf::~TLMCompressedStreamBuf() {
+    close();
+}
+
+bool TLMCompressedStreamBuf::open(const std::string& fileName, bool background) {
+    close();
+
+    File = fopen(fileName.c_str(), "wb");
+    if(File == NULL) return false;
+
+    FillBlock.resize(BlockSize);
+    FlushBlock.resize(BlockSize);
+    OutBuffer.resize(MaxBlockSize);
+    FlushSize = 0;
+    FlushPending = false;
+    StopCompressor = false;
+    setp(&FillBlock[0], &FillBlock[0] + BlockSize);
+
+#ifdef USE_THREADS
+    Background = background;
+    if(Background) {
+        pthread_create(&CompressorThread, NULL, thread_CompressorRun, (void*)this);
+    }
+#else
+    Background = false;
+#endif
+
+    return true;
+}
+
+void TLMCompressedStreamBuf::close() {
+    if(File == NULL) return;
+
+    SubmitBlock();
+
+#ifdef USE_THREADS
+    if(Background) {
+        BlockLock.lock();
+        StopCompressor = true;
+        FlushReadyCond.signal();
+        BlockLock.unlock();
+
+        pthread_join(CompressorThread, NULL);
+        Background = false;
+    }
+#endif
+
+    fwrite(EOFBlock, 1, sizeof(EOFBlock), File);
+    if(ferror(File)) {
+        TLMErrorLog::Warning("Failed to write compressed file.");
+    }
+    fclose(File);
+    File = NULL;
+
+    setp(NULL, NULL);
+}
+
+TLMCompressedStreamBuf::int_type TLMCompressedStreamBuf::overflow(int_type c) {
+    if(File == NULL) return traits_type::eof();
+
+    SubmitBlock();
+
+    if(!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+void TLMCompressedStreamBuf::SubmitBlock() {
+    size_t size = pptr() - pbase();
+    if(size == 0) return;
+
+    if(Background) {
+        BlockLock.lock();
+
+        // Wait until the compressor thread is done with the other block.
+        while(FlushPending) {
+            FlushDoneCond.wait(BlockLock);
+        }
+
+        FillBlock.swap(FlushBlock);
+        FlushSize = size;
+        FlushPending = true;
+        FlushReadyCond.signal();
+
+        BlockLock.unlock();
+    }
+    else {
+        CompressBlock(&FillBlock[0], size);
+    }
+
+    setp(&FillBlock[0], &FillBlock[0] + BlockSize);
+}
+
+void TLMCompressedStreamBuf::CompressBlock(const char* data, size_t size) {
+    unsigned char* out = &OutBuffer[0];
+    size_t outSize = MaxBlockSize - HeaderSize - FooterSize;
+
+    // Incompressible data might not fit, it is stored uncompressed instead.
+    size_t compressedSize = Deflate(data, size, out + HeaderSize, outSize, Z_DEFAULT_COMPRESSION);
+    if(compressedSize == 0) {
+        compressedSize = Deflate(data, size, out + HeaderSize, outSize, Z_NO_COMPRESSION);
+    }
+    if(compressedSize == 0) {
+        TLMErrorLog::Warning("Failed to compress data block.");
+        return;
+    }
+
+    size_t blockSize = HeaderSize + compressedSize + FooterSize;
+
+    // gzip header with the extra field "BC" holding the block size - 1.
+    const unsigned char header[] = { 0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43, 0x02, 0x00 };
+    memcpy(out, header, sizeof(header));
+    PutLittleEndian(out + 16, blockSize - 1, 2);
+
+    unsigned long crc = crc32(0L, Z_NULL, 0);
+    crc = crc32(crc, (const Bytef*)data, (uInt)size);
+    PutLittleEndian(out + HeaderSize + compressedSize, crc, 4);
+    PutLittleEndian(out + HeaderSize + compressedSize + 4, size, 4);
+
+    fwrite(out, 1, blockSize, File);
+}
+
+void* TLMCompressedStreamBuf::thread_CompressorRun(void* arg) {
+    TLMCompressedStreamBuf* buf = reinterpret_cast<TLMCompressedStreamBuf*>(arg);
+    buf->CompressorRun();
+    return NULL;
+}
+
+void TLMCompressedStreamBuf::CompressorRun() {
+    BlockLock.lock();
+
+    while(true) {
+        while(!FlushPending && !StopCompressor) {
+            FlushReadyCond.wait(BlockLock);
+        }
+        if(!FlushPending) break;
+
+        // FlushBlock is not touched by the writer until FlushPending is reset.
+        BlockLock.unlock();
+        CompressBlock(&FlushBlock[0], FlushSize);
+        BlockLock.lock();
+
+        FlushPending = false;
+        FlushDoneCond.signal();
+    }
+
+    BlockLock.unlock();
+}
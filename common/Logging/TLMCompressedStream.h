@@ -0,0 +1,135 @@
+//!
+//! \file TLMCompressedStream.h
+//!
+//! Defines output streams that write block compressed files.
+//!
+//! The files are written in the BGZF format, that is, a series of gzip
+//! members holding at most 64 KB of data each, followed by an empty end
+//! of file member. They can be read with any gzip tool (e.g., zcat),
+//! while the block sizes stored in the gzip headers allow tools like
+//! bgzip to seek in the file without decompressing everything before.
+//!
+
+#ifndef TLMCompressedStream_h_
+#define TLMCompressedStream_h_
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <streambuf>
+#include <cstdio>
+
+#include "Communication/TLMThreadSynch.h"
+
+//! \class TLMCompressedStreamBuf
+//! Stream buffer that collects the data in blocks and compresses each
+//! block to the file when it is full. When opened in background mode
+//! the blocks are compressed by a separate thread. The writer then only
+//! waits if the compressor thread has not finished the previous block.
+//! Flushing (e.g., std::endl) does not write a block, the data is
+//! written when a block is full or the stream is closed.
+class TLMCompressedStreamBuf : public std::streambuf {
+public:
+    TLMCompressedStreamBuf();
+
+    //! Destructor, closes the file.
+    ~TLMCompressedStreamBuf();
+
+    //! Open the file.
+    //! \param fileName Compressed file name, e.g., with extension ".gz".
+    //! \param background Compress in a separate thread.
+    //! \return True if the file could be opened.
+    bool open(const std::string& fileName, bool background);
+
+    //! Check if the file is open.
+    bool is_open() const { return File != NULL; }
+
+    //! Compress the remaining data, write the end of file marker and close the file.
+    void close();
+
+protected:
+    //! Called when the current block is full.
+    int_type overflow(int_type c);
+
+    //! Blocks are only written when they are full, nothing to do here.
+    int sync() { return 0; }
+
+private:
+    //! Hand the current block over for compression.
+    void SubmitBlock();
+
+    //! Compress one block and write it as a gzip member.
+    void CompressBlock(const char* data, size_t size);
+
+    //! Compressor thread main loop.
+    void CompressorRun();
+
+    //! Compressor thread entry point, "arg" is the stream buffer.
+    static void* thread_CompressorRun(void* arg);
+
+    // Not copyable.
+    TLMCompressedStreamBuf(const TLMCompressedStreamBuf&);
+    TLMCompressedStreamBuf& operator=(const TLMCompressedStreamBuf&);
+
+    //! The compressed file.
+    FILE* File;
+
+    //! Block that is filled, it is the put area of the stream buffer.
+    std::vector<char> FillBlock;
+
+    //! Block that is compressed by the compressor thread.
+    std::vector<char> FlushBlock;
+
+    //! Number of bytes in FlushBlock.
+    size_t FlushSize;
+
+    //! Output buffer of the compression.
+    std::vector<unsigned char> OutBuffer;
+
+    //! True while FlushBlock is owned by the compressor thread.
+    bool FlushPending;
+
+    //! True if the compressor thread should exit when FlushBlock is written.
+    bool StopCompressor;
+
+    //! True if the blocks are compressed in a separate thread.
+    bool Background;
+
+    //! Protects the block hand over.
+    SimpleLock BlockLock;
+
+    //! Signaled when a block is submitted or the compressor should stop.
+    SimpleCond FlushReadyCond;
+
+    //! Signaled when the compressor thread has written a block.
+    SimpleCond FlushDoneCond;
+
+#ifdef USE_THREADS
+    //! The compressor thread.
+    pthread_t CompressorThread;
+#endif
+};
+
+//! \class TLMCompressedOStream
+//! Output stream writing a block compressed file, see TLMCompressedStreamBuf.
+class TLMCompressedOStream : public std::ostream {
+public:
+    TLMCompressedOStream() : std::ostream(NULL), Buffer() { rdbuf(&Buffer); }
+
+    //! Open the file, see TLMCompressedStreamBuf::open.
+    void open(const std::string& fileName, bool background = true) {
+        if(!Buffer.open(fileName, background)) setstate(std::ios::failbit);
+    }
+
+    //! Check if the file is open.
+    bool is_open() const { return Buffer.is_open(); }
+
+    //! Write the remaining data and close the file.
+    void close() { Buffer.close(); }
+
+private:
+    //! The stream buffer.
+    TLMCompressedStreamBuf Buffer;
+};
+
+#endif
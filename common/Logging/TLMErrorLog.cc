@@ -9,6 +9,15 @@
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+
+#ifndef _MSC_VER
+#include <unistd.h>
+#else
+#include <windows.h>
+#endif
 
 
 //#define USE_ERRORLOG
@@ -42,6 +51,113 @@ void _strtime(char* timestring) {
 
 
 
+namespace {
+    //! Number of messages in the ring buffer of a thread.
+    const size_t LogRingSize = 1024;
+
+    //! A queued message.
+    struct LogEntry {
+        //! Global order of the message.
+        uint64_t Sequence;
+        TLMLogLevel Level;
+
+        //! Time when the message was logged, 0 if time stamps are off.
+        time_t Time;
+
+        std::string Text;
+    };
+
+    //! Single producer, single consumer ring of the messages of one thread.
+    //! The texts keep their capacity so that queuing does not allocate
+    //! once the ring is warm.
+    struct LogRing {
+        std::vector<LogEntry> Entries;
+
+        //! Next entry to write, only changed by the owning thread.
+        std::atomic<size_t> Head;
+
+        //! Next entry to read, only changed by the writer.
+        std::atomic<size_t> Tail;
+
+        //! Set when the owning thread exits, the ring is deleted once empty.
+        std::atomic<bool> Abandoned;
+
+        LogRing() : Entries(LogRingSize), Head(0), Tail(0), Abandoned(false) {}
+    };
+
+    //! Set once the ring of the calling thread is released, the thread
+    //! then writes its messages synchronously while it exits.
+    thread_local bool RingReleased = false;
+
+    //! Marks the ring of a thread as abandoned when the thread exits.
+    //! The writer may delete the ring right after, so it is forgotten.
+    struct LogRingOwner {
+        LogRing* Ring;
+        LogRingOwner() : Ring(NULL) {}
+        ~LogRingOwner() {
+            if(Ring != NULL) Ring->Abandoned.store(true, std::memory_order_release);
+            Ring = NULL;
+            RingReleased = true;
+        }
+    };
+
+    std::atomic<bool> AsyncOn(false);
+    std::atomic<bool> StopWriter(false);
+    std::atomic<uint64_t> Sequence(0);
+
+    //! All rings, the lock protects the vector, not the rings.
+    std::vector<LogRing*> Rings;
+    SimpleLock RingsLock;
+
+    //! Only one thread writes the pending messages at a time.
+    SimpleLock WritePendingLock;
+
+    thread_local LogRingOwner CurrentRing;
+
+    //! The ring of the calling thread, created on first use.
+    //! NULL if the thread is exiting and has released its ring.
+    LogRing* GetThreadRing() {
+        if(RingReleased) return NULL;
+        if(CurrentRing.Ring == NULL) {
+            LogRing* ring = new LogRing;
+            RingsLock.lock();
+            Rings.push_back(ring);
+            RingsLock.unlock();
+            CurrentRing.Ring = ring;
+        }
+        return CurrentRing.Ring;
+    }
+
+    void SleepMilliseconds(int ms) {
+#ifndef _MSC_VER
+        usleep(1000*ms);
+#else
+        Sleep(ms);
+#endif
+    }
+
+    const char* LevelPrefix(TLMLogLevel level) {
+        switch(level) {
+        case TLMLogLevel::Warning: return " Warning: ";
+        case TLMLogLevel::Info: return " Info: ";
+        default: return " Debug: ";
+        }
+    }
+
+    bool CompareSequence(const LogEntry* a, const LogEntry* b) {
+        return a->Sequence < b->Sequence;
+    }
+
+#ifdef USE_THREADS
+    pthread_t WriterThread;
+    bool AtExitRegistered = false;
+
+    void StopAsyncAtExit() {
+        TLMErrorLog::SetAsync(false);
+    }
+#endif
+}
+
 TLMLogLevel TLMErrorLog::LogLevel = TLMLogLevel::Fatal;
 bool  TLMErrorLog::ExceptionOn = false;
 bool  TLMErrorLog::NormalErrorLogOn = false;
@@ -60,6 +176,7 @@ void TLMErrorLog::Open() {
 
 void TLMErrorLog::Close()
 {
+  SetAsync(false);
   LogStreamLock.lock();
   if(outStream!=nullptr) {
     *outStream << TimeStr() << " Log finished." << std::endl;
@@ -75,6 +192,7 @@ void TLMErrorLog::Close()
 // then terminates the program abnormally.
 void TLMErrorLog::FatalError(const std::string& mess) {
     Open();
+    Flush();
     std::cout << TimeStr() << " Fatal error: " << mess << std::endl;
     *outStream << TimeStr() << " Fatal error: " << mess << std::endl;
     if(NormalErrorLogOn) {
@@ -99,10 +217,10 @@ void TLMErrorLog::FatalError(const std::string& mess) {
 // Warning function prints a warning message to log file
 //
 void  TLMErrorLog::Warning(const std::string& mess) {
-    if(LogLevel < TLMLogLevel::Warning) return;
+    if(!IsLogged(TLMLogLevel::Warning)) return;
     Open();
     //std::cout << TimeStr() << " Warning: " << mess << std::endl;
-    *outStream << TimeStr() << " Warning: " << mess << std::endl;
+    Write(TLMLogLevel::Warning, mess);
 
     if(NormalErrorLogOn) {
         _strtime(tmpbuf);
@@ -114,9 +232,9 @@ void  TLMErrorLog::Warning(const std::string& mess) {
 
 // Log function logs a message to log file
 void  TLMErrorLog::Info(const std::string& mess) {
-    if(LogLevel < TLMLogLevel::Info) return;
+    if(!IsLogged(TLMLogLevel::Info)) return;
     Open();
-    *outStream << TimeStr() << " Info: " << mess << std::endl;
+    Write(TLMLogLevel::Info, mess);
     if(NormalErrorLogOn) {
         _strtime(tmpbuf);
 #ifdef USE_ERRORLOG
@@ -128,9 +246,9 @@ void  TLMErrorLog::Info(const std::string& mess) {
 
 // Log function logs a message to log file
 void  TLMErrorLog::Debug(const std::string& mess) {
-    if(LogLevel < TLMLogLevel::Debug) return;
+    if(!IsLogged(TLMLogLevel::Debug)) return;
     Open();
-    *outStream << TimeStr() << " Debug: " << mess << std::endl;
+    Write(TLMLogLevel::Debug, mess);
     if(NormalErrorLogOn) {
         _strtime(tmpbuf);
 #ifdef USE_ERRORLOG
@@ -152,13 +270,162 @@ std::string  TLMErrorLog::ToStdStr(int val) {
 
 std::string  TLMErrorLog::TimeStr() {
     if(LogTimeOn) {
-        time_t rawtime;
-        struct tm * timeinfo;
-
-        time (&rawtime);
-        timeinfo = localtime (&rawtime);
-        return std::string(asctime(timeinfo));
+        return TimeStr(time(NULL));
     }
     else
         return std::string("");
 }
+
+std::string  TLMErrorLog::TimeStr(time_t rawtime) {
+    if(rawtime == 0) {
+        return std::string("");
+    }
+    struct tm * timeinfo = localtime (&rawtime);
+    return std::string(asctime(timeinfo));
+}
+
+
+void TLMErrorLog::SetOutStream(std::ostream& of) {
+    Flush();
+    LogStreamLock.lock();
+    outStream = &of;
+    LogStreamLock.unlock();
+}
+
+
+// Write a message, or queue it in the ring of the calling thread.
+void TLMErrorLog::Write(TLMLogLevel level, const std::string& mess) {
+    LogRing* ring = NULL;
+    if(AsyncOn.load(std::memory_order_acquire)) {
+        ring = GetThreadRing();
+        // A thread without a ring writes after the messages queued before.
+        if(ring == NULL) WritePending();
+    }
+
+    if(ring == NULL) {
+        LogStreamLock.lock();
+        *outStream << TimeStr() << LevelPrefix(level) << mess << std::endl;
+        LogStreamLock.unlock();
+        return;
+    }
+
+    size_t head = ring->Head.load(std::memory_order_relaxed);
+
+    // Write the pending messages if the ring is full, they are never dropped.
+    while(head - ring->Tail.load(std::memory_order_acquire) >= LogRingSize) {
+        WritePending();
+    }
+
+    LogEntry& entry = ring->Entries[head % LogRingSize];
+    entry.Sequence = Sequence.fetch_add(1, std::memory_order_relaxed);
+    entry.Level = level;
+    entry.Time = LogTimeOn ? time(NULL) : 0;
+    entry.Text.assign(mess);
+
+    ring->Head.store(head + 1, std::memory_order_release);
+}
+
+
+// Write the pending messages of all threads in the order they were logged.
+// Returns false if there was nothing to write.
+bool TLMErrorLog::WritePending() {
+    WritePendingLock.lock();
+
+    RingsLock.lock();
+    std::vector<LogRing*> rings(Rings);
+    RingsLock.unlock();
+
+    std::vector<size_t> heads(rings.size());
+    std::vector<const LogEntry*> entries;
+    for(size_t i = 0; i < rings.size(); i++) {
+        heads[i] = rings[i]->Head.load(std::memory_order_acquire);
+        for(size_t j = rings[i]->Tail.load(std::memory_order_relaxed); j != heads[i]; j++) {
+            entries.push_back(&rings[i]->Entries[j % LogRingSize]);
+        }
+    }
+
+    if(!entries.empty()) {
+        std::sort(entries.begin(), entries.end(), CompareSequence);
+
+        LogStreamLock.lock();
+        if(outStream != NULL) {
+            for(size_t i = 0; i < entries.size(); i++) {
+                *outStream << TimeStr(entries[i]->Time) << LevelPrefix(entries[i]->Level) << entries[i]->Text << "\n";
+            }
+            outStream->flush();
+        }
+        LogStreamLock.unlock();
+
+        for(size_t i = 0; i < rings.size(); i++) {
+            rings[i]->Tail.store(heads[i], std::memory_order_release);
+        }
+    }
+
+    // Delete the rings of the threads that have exited.
+    RingsLock.lock();
+    for(size_t i = 0; i < Rings.size(); ) {
+        LogRing* ring = Rings[i];
+        if(ring->Abandoned.load(std::memory_order_acquire)
+           && ring->Tail.load(std::memory_order_relaxed) == ring->Head.load(std::memory_order_relaxed)) {
+            delete ring;
+            Rings.erase(Rings.begin() + i);
+        }
+        else {
+            i++;
+        }
+    }
+    RingsLock.unlock();
+
+    WritePendingLock.unlock();
+
+    return !entries.empty();
+}
+
+
+void TLMErrorLog::Flush() {
+    if(AsyncOn.load(std::memory_order_acquire)) {
+        WritePending();
+    }
+}
+
+
+void TLMErrorLog::SetAsync(bool Enable) {
+#ifdef USE_THREADS
+    if(Enable == AsyncOn.load(std::memory_order_acquire)) return;
+
+    if(Enable) {
+        Open();
+        if(!AtExitRegistered) {
+            atexit(StopAsyncAtExit);
+            AtExitRegistered = true;
+        }
+        StopWriter.store(false, std::memory_order_relaxed);
+        AsyncOn.store(true, std::memory_order_release);
+        pthread_create(&WriterThread, NULL, thread_WriterRun, NULL);
+    }
+    else {
+        StopWriter.store(true, std::memory_order_release);
+        pthread_join(WriterThread, NULL);
+
+        // Messages queued while stopping are written synchronously from now on.
+        AsyncOn.store(false, std::memory_order_release);
+        WritePending();
+    }
+#else
+    (void)Enable;
+#endif
+}
+
+
+#ifdef USE_THREADS
+void* TLMErrorLog::thread_WriterRun(void* arg) {
+    (void)arg;
+    while(!StopWriter.load(std::memory_order_acquire)) {
+        if(!WritePending()) {
+            SleepMilliseconds(1);
+        }
+    }
+    WritePending();
+    return NULL;
+}
+#endif
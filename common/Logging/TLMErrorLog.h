@@ -14,10 +14,23 @@
 #include <ostream>
 #include <fstream>
 #include <iostream>
+#include <ctime>
 #include "Communication/TLMThreadSynch.h"
 
 enum TLMLogLevel { Disabled, Fatal, Warning, Info, Debug };
 
+//! Highest log level compiled in, e.g., -DTLM_MAX_LOG_LEVEL=Warning removes
+//! the info and debug messages logged with the TLM_LOG_* macros below.
+#ifndef TLM_MAX_LOG_LEVEL
+#define TLM_MAX_LOG_LEVEL Debug
+#endif
+
+//! Log macros that only build the message if the level is enabled, use
+//! them where the message is built from several parts or on a hot path.
+#define TLM_LOG_WARNING(mess) do { if(TLMErrorLog::IsLogged(TLMLogLevel::Warning)) TLMErrorLog::Warning(mess); } while(0)
+#define TLM_LOG_INFO(mess) do { if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) TLMErrorLog::Info(mess); } while(0)
+#define TLM_LOG_DEBUG(mess) do { if(TLMErrorLog::IsLogged(TLMLogLevel::Debug)) TLMErrorLog::Debug(mess); } while(0)
+
 //! Error handling is implemented in the most simple way
 //! with the functions that write messages to standard error output (cerr).
 //! In addition FatalError calls abort() to terminate the application.
@@ -50,6 +63,22 @@ public:
 
     static TLMLogLevel GetLogLevel() { return LogLevel; }
 
+    //! Check if messages of the given level are logged, both at compile
+    //! time (TLM_MAX_LOG_LEVEL) and at run time (SetLogLevel).
+    static bool IsLogged(TLMLogLevel level) {
+        return level <= TLMLogLevel::TLM_MAX_LOG_LEVEL && level <= LogLevel;
+    }
+
+    //! Enable/disable the asynchronous log backend. When enabled, messages
+    //! are put into a ring buffer of the calling thread, with the time they
+    //! were logged, and written to the output stream by a background thread. Requires USE_THREADS, without
+    //! threads the messages are always written synchronously.
+    //! Disabling writes the pending messages and stops the thread.
+    static void SetAsync(bool Enable);
+
+    //! Write all pending asynchronous messages to the output stream.
+    static void Flush();
+
     //! This function enables so that logs are duplicated to the normal *.log file as well.
     //! Input: if Enable is true - output is on, othewise - off.
     static void SetNormalErrorLogOn(bool Enable) { NormalErrorLogOn = Enable; }
@@ -58,7 +87,9 @@ public:
 
     //! Sets the output stream for output of all log, warning, and error messages.
     //! Default output stream id std::cout
-    static void SetOutStream(std::ostream& of) { outStream = &of; }
+    //! The pending asynchronous messages are written to the previous stream
+    //! first. The stream must be kept until Close or SetAsync(false).
+    static void SetOutStream(std::ostream& of);
 
     //! Sets the error mode to exception instead of abort()/exit().
     //! When exception mode is on TLMErrorLog will throw an exception on fatal error.
@@ -96,6 +127,20 @@ private:
 
     //! Open log file
     static  void Open();
+
+    //! Format a time as TimeStr does, an empty string for 0.
+    static std::string TimeStr(time_t rawtime);
+
+    //! Write a message to the output stream or queue it for the background thread.
+    static void Write(TLMLogLevel level, const std::string& mess);
+
+    //! Write the pending asynchronous messages, called by the background thread and Flush.
+    static bool WritePending();
+
+#ifdef USE_THREADS
+    //! Background thread writing the asynchronous messages.
+    static void* thread_WriterRun(void* arg);
+#endif
 };
 
 
@@ -0,0 +1,753 @@
+/**
+ * File: TLMResultRecorder.cc
+ *
+ * Implementation of the TLMResultRecorder methods
+ */
+#include "Logging/TLMResultRecorder.h"
+#include "Logging/TLMErrorLog.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "double3.h"
+#include "double33.h"
+#include "coordTransform.h"
+
+namespace {
+    //! Size of each of the two row buffers.
+    const size_t ResultBufferBytes = 256*1024;
+
+    //! A partially filled buffer is submitted when it holds rows
+    //! older than this (wall clock seconds), to keep the files current.
+    const double ResultBufferMaxAge = 1.0;
+
+    //! Number of rows kept in the telemetry segment.
+    const int TelemetryRingSize = 1024;
+
+    //! Maximum number of samples kept per channel. Rows are written with
+    //! the last data of the lagging channels when a channel has more.
+    const size_t MaxChannelSamples = 65536;
+
+    //! Linear interpolation (or extrapolation) between (t0,f0) and (t1,f1).
+    inline double Lerp(double time, double t0, double t1, double f0, double f1) {
+        return ((time - t0) * f1 - (time - t1) * f0) / (t1 - t0);
+    }
+
+    void InterpolateLinear(TLMTimeDataSignal& Instance, const TLMTimeDataSignal& p0, const TLMTimeDataSignal& p1) {
+        Instance.Value = Lerp(Instance.time, p0.time, p1.time, p0.Value, p1.Value);
+    }
+
+    void InterpolateLinear(TLMTimeData1D& Instance, const TLMTimeData1D& p0, const TLMTimeData1D& p1) {
+        Instance.Position = Lerp(Instance.time, p0.time, p1.time, p0.Position, p1.Position);
+        Instance.Velocity = Lerp(Instance.time, p0.time, p1.time, p0.Velocity, p1.Velocity);
+        Instance.GenForce = Lerp(Instance.time, p0.time, p1.time, p0.GenForce, p1.GenForce);
+    }
+
+    //! Same as TLMInterface3D::InterpolateLinear, the rotation is
+    //! interpolated using the relative angles between the two points.
+    void InterpolateLinear(TLMTimeData3D& Instance, const TLMTimeData3D& p0, const TLMTimeData3D& p1) {
+        const double time = Instance.time;
+        for(int j = 0; j < 3; j++) {
+            Instance.Position[j] = Lerp(time, p0.time, p1.time, p0.Position[j], p1.Position[j]);
+        }
+        for(int j = 0; j < 6; j++) {
+            Instance.Velocity[j] = Lerp(time, p0.time, p1.time, p0.Velocity[j], p1.Velocity[j]);
+            Instance.GenForce[j] = Lerp(time, p0.time, p1.time, p0.GenForce[j], p1.GenForce[j]);
+        }
+
+        const double* a = p0.RotMatrix;
+        double33 A0(a[0],a[1],a[2],a[3],a[4],a[5],a[6],a[7],a[8]);
+        a = p1.RotMatrix;
+        double33 A1(a[0],a[1],a[2],a[3],a[4],a[5],a[6],a[7],a[8]);
+
+        A1 = A0.T() * A1;
+        double3 phi = ATophi321(A1);
+        for(int j = 1; j <= 3; j++) {
+            phi(j) = Lerp(time, p0.time, p1.time, 0.0, phi(j));
+        }
+        A0 *= A321(phi);
+
+        double* r = Instance.RotMatrix;
+        A0.Get(r[0],r[1],r[2],r[3],r[4],r[5],r[6],r[7],r[8]);
+    }
+
+    //! Evaluate the samples in "Data" at Instance.time. The first and the
+    //! last sample are used outside of the sampled interval.
+    //! Data must not be empty.
+    template<class T>
+    void GetSample(T& Instance, const std::deque<T>& Data) {
+        double time = Instance.time;
+
+        if(time <= Data.front().time) {
+            Instance = Data.front();
+        }
+        else if(time >= Data.back().time) {
+            Instance = Data.back();
+        }
+        else {
+            // Find the first sample after "time", the interval is not empty here.
+            size_t i = Data.size() - 1;
+            while(Data[i-1].time > time) --i;
+            InterpolateLinear(Instance, Data[i-1], Data[i]);
+        }
+        Instance.time = time;
+    }
+
+    //! Append the records of a time data message to "Data".
+    template<class T>
+    void AppendRecords(std::deque<T>& Data, const TLMMessage& mess) {
+        size_t n = mess.Header.DataSize / sizeof(T);
+        bool swap = (TLMMessageHeader::IsBigEndianSystem != mess.Header.SourceIsBigEndianSystem);
+
+        // since mess.Data is continious we can just convert the pointer
+        const T* Next = (const T*)(&mess.Data[0]);
+
+        for(size_t i = 0; i < n; i++, Next++) {
+            T record = *Next;
+
+            // Check if we have byte order missmatch in the message and perform
+            // swapping if necessary.
+            if(swap) {
+                TLMCommUtil::ByteSwap(&record, sizeof(double), sizeof(T)/sizeof(double));
+            }
+
+            // Out of order samples (e.g., resent data) are ignored.
+            if(!Data.empty() && record.time < Data.back().time) continue;
+            Data.push_back(record);
+        }
+    }
+
+    //! Remove the samples before "time", leaving one for the interpolation.
+    template<class T>
+    void CleanData(std::deque<T>& Data, double time) {
+        while(Data.size() > 1 && Data[1].time <= time) {
+            Data.pop_front();
+        }
+    }
+}
+
+TLMResultRecorder::Channel::Channel()
+    : InterfaceID(-1), Kind(Channel3D), Name(), Zf(0.0), Zfr(0.0), Lag(0.0),
+      DataSignal(), Data1D(), Data3D(), SampleSignal(), Sample1D(), Sample3D()
+{
+}
+
+size_t TLMResultRecorder::Channel::GetNumSamples() const {
+    return DataSignal.size() + Data1D.size() + Data3D.size();
+}
+
+double TLMResultRecorder::Channel::GetLastTime() const {
+    if(!DataSignal.empty()) return DataSignal.back().time;
+    if(!Data1D.empty()) return Data1D.back().time;
+    if(!Data3D.empty()) return Data3D.back().time;
+    return -HUGE_VAL;
+}
+
+TLMResultRecorder::TLMResultRecorder(omtlm_CompositeModel& model, const std::string& baseName, double logStepSize,
+                                     const std::string& format)
+    : TheModel(model),
+      BaseName(baseName),
+      Format(format),
+      LogStepSize(logStepSize),
+      StartTime(model.GetSimParams().GetStartTime()),
+      EndTime(model.GetSimParams().GetEndTime()),
+      NumSteps(0),
+      NextStep(0),
+      NumForcedSteps(0),
+      Channels(),
+      ChannelIndex(),
+      Writer(NULL),
+      VariableNames(),
+      NumVariables(0),
+      RowsPerBuffer(1),
+      FillBuffer(),
+      FillRows(0),
+      FlushBuffer(),
+      FlushRows(0),
+      FlushPending(false),
+      StopWriter(false),
+      RowsWritten(0),
+      NumBufferWaits(0),
+      BufferLock(),
+      FlushReadyCond(),
+      FlushDoneCond(),
+      WriterRunning(false),
+      LastSubmitTime(0.0),
+      TelemetryName(),
+      TelemetryInterfaces(),
+      Telemetry(),
+      TelemetryColumns(),
+      TelemetryRow(),
+      MemoryResults(false),
+      MemoryInterfaces(),
+      MemoryColumns(),
+      MemoryValues(),
+      RunFile(),
+      TimerInfo(),
+      IsOpen(false)
+{
+    if(LogStepSize <= 0.0) {
+        LogStepSize = model.GetSimParams().GetWriteTimeStep();
+    }
+
+    // The last step is adjusted to meet the end time.
+    NumSteps = int(std::ceil((EndTime-StartTime)/LogStepSize - 1e-9));
+    if(NumSteps < 0) NumSteps = 0;
+
+    // Resolve the recorded interfaces once, in the order of the interfaces.
+    ChannelIndex.assign(model.GetInterfacesNum(), -1);
+    for(int i = 0; i < int(model.GetInterfacesNum()); i++) {
+        TLMInterfaceProxy& ifc = model.GetTLMInterfaceProxy(i);
+        TLMComponentProxy& component = model.GetTLMComponentProxy(ifc.GetComponentID());
+        if(ifc.GetConnectionID() < 0) continue;
+
+        Channel ch;
+        if(ifc.GetDimensions() == 6) {
+            ch.Kind = Channel3D;
+        }
+        else if(ifc.GetDimensions() == 1 && ifc.GetCausality() == "bidirectional") {
+            if(ifc.GetDomain() == "hydraulic") ch.Kind = ChannelHydraulic;
+            else if(ifc.GetDomain() == "mechanical") ch.Kind = ChannelMechanical;
+            else if(ifc.GetDomain() == "rotational") ch.Kind = ChannelRotational;
+            else if(ifc.GetDomain() == "electric") ch.Kind = ChannelElectric;
+            else {
+                TLMErrorLog::Warning("Interface " + ifc.GetName() + " of unknown domain "
+                                     + ifc.GetDomain() + " is not recorded.");
+                continue;
+            }
+        }
+        else if(ifc.GetDimensions() == 1 && ifc.GetCausality() == "output") {
+            ch.Kind = ChannelSignal;
+        }
+        else {
+            continue;
+        }
+
+        TLMConnection& connection = model.GetTLMConnection(ifc.GetConnectionID());
+        ch.InterfaceID = ifc.GetID();
+        ch.Name = component.GetName() + "." + ifc.GetName();
+        ch.Zf = connection.GetParams().Zf;
+        ch.Zfr = connection.GetParams().Zfr;
+
+        // tlmmonitor requests the data of the logging instant from its
+        // linked interface, which is the data sent one delay earlier. For
+        // the bidirectional interfaces it evaluates the damped wave one
+        // more delay back, which replaces the former (see MonitorTimeStep).
+        ch.Lag = connection.GetParams().Delay;
+        if(ch.Kind != ChannelSignal) ch.Lag *= 2;
+
+        ChannelIndex[ifc.GetID()] = int(Channels.size());
+        Channels.push_back(ch);
+    }
+}
+
+TLMResultRecorder::~TLMResultRecorder() {
+    if(IsOpen) {
+        StopWriterThread();
+        Writer->Close();
+        RunFile.close();
+    }
+    delete Writer;
+}
+
+void TLMResultRecorder::SetTelemetry(const std::string& segmentName, const std::vector<std::string>& interfaces) {
+    TelemetryName = segmentName;
+    TelemetryInterfaces = interfaces;
+}
+
+void TLMResultRecorder::SetMemoryResults(const std::vector<std::string>& interfaces) {
+    MemoryResults = true;
+    MemoryInterfaces = interfaces;
+}
+
+void TLMResultRecorder::GetMemoryResults(std::vector<std::string>& names, std::vector<std::vector<double> >& values) {
+    names.clear();
+    for(size_t i = 0; i < MemoryColumns.size(); i++) {
+        names.push_back(VariableNames[MemoryColumns[i]]);
+    }
+    values.clear();
+    values.swap(MemoryValues);
+}
+
+void TLMResultRecorder::SelectVariables(const std::vector<std::string>& interfaces, std::vector<int>& columns) const {
+    // Time and wall clock time are always selected.
+    columns.clear();
+    for(size_t i = 0; i < VariableNames.size(); i++) {
+        bool selected = (i < 2 || interfaces.empty());
+        for(size_t j = 0; j < interfaces.size() && !selected; j++) {
+            const std::string& prefix = interfaces[j];
+            selected = (VariableNames[i].compare(0, prefix.size(), prefix) == 0 &&
+                        (VariableNames[i].size() == prefix.size() || VariableNames[i][prefix.size()] == '.'));
+        }
+        if(selected) {
+            columns.push_back(int(i));
+        }
+    }
+}
+
+void TLMResultRecorder::OpenTelemetry() {
+    SelectVariables(TelemetryInterfaces, TelemetryColumns);
+    std::vector<std::string> names;
+    for(size_t i = 0; i < TelemetryColumns.size(); i++) {
+        names.push_back(VariableNames[TelemetryColumns[i]]);
+    }
+    TelemetryRow.resize(names.size());
+
+    if(!Telemetry.Open(TelemetryName, names, StartTime, EndTime, TelemetryRingSize)) {
+        int pid = TLMTelemetryPublisher::GetRunningPublisher(TelemetryName);
+        if(pid != 0) {
+            TLMErrorLog::Warning("Telemetry segment " + TelemetryName + " is in use by process "
+                                 + TLMErrorLog::ToStdStr(pid) + ", no telemetry published.");
+        }
+        else {
+            TLMErrorLog::Warning("Failed to create telemetry segment " + TelemetryName + ", no telemetry published.");
+        }
+        return;
+    }
+
+    TLMErrorLog::Info("Publishing telemetry of " + TLMErrorLog::ToStdStr(int(names.size()))
+                      + " variables as " + TelemetryName);
+}
+
+void TLMResultRecorder::Open() {
+    Writer = TLMResultWriter::CreateWriter(Format);
+    if(Writer == NULL) {
+        TLMErrorLog::FatalError("Unknown result file format " + Format + ", give up.");
+        return;
+    }
+
+    // Build the variable names for the header.
+    PrintHeader();
+
+    // Open file for data logging, that is, storing the co-simulation data.
+    std::string fileName = BaseName + Writer->GetExtension();
+    if(!Writer->Open(fileName, VariableNames)) {
+        TLMErrorLog::FatalError("Failed to open outfile " + fileName + ", give up.");
+        return;
+    }
+
+    // Open run file for logging of simulation progress.
+    RunFile.open((BaseName + ".run").c_str());
+    if(!RunFile.good()) {
+        TLMErrorLog::FatalError("Failed to open runfile " + BaseName + ".run, give up.");
+        return;
+    }
+
+    // Allocate the two row buffers.
+    NumVariables = int(VariableNames.size());
+    RowsPerBuffer = int(ResultBufferBytes / (NumVariables*sizeof(double)));
+    RowsPerBuffer = std::max(1, std::min(RowsPerBuffer, NumSteps+1));
+    FillBuffer.resize(size_t(RowsPerBuffer)*NumVariables);
+    FlushBuffer.resize(size_t(RowsPerBuffer)*NumVariables);
+    FillRows = FlushRows = RowsWritten = NumBufferWaits = 0;
+    FlushPending = StopWriter = false;
+
+    if(!TelemetryName.empty()) {
+        OpenTelemetry();
+    }
+
+    // The number of rows is known, so the arrays are allocated once.
+    MemoryColumns.clear();
+    MemoryValues.clear();
+    if(MemoryResults) {
+        SelectVariables(MemoryInterfaces, MemoryColumns);
+        MemoryValues.resize(MemoryColumns.size());
+        for(size_t i = 0; i < MemoryValues.size(); i++) {
+            MemoryValues[i].reserve(NumSteps+1);
+        }
+    }
+
+#ifdef USE_THREADS
+    // Start the writer thread.
+    pthread_create(&WriterThread, NULL, thread_WriterThreadRun, (void*)this);
+    WriterRunning = true;
+#endif
+
+    // Setup timer for run-time estimation.
+    TM_Init(&TimerInfo);
+    TM_Clear(&TimerInfo);
+    TM_Start(&TimerInfo);
+    LastSubmitTime = 0.0;
+
+    IsOpen = true;
+
+    TLMErrorLog::Info("Recording results to " + fileName + ", log step size " + TLMErrorLog::ToStdStr(LogStepSize));
+}
+
+double TLMResultRecorder::GetStepTime(int step) const {
+    double time = StartTime + step*LogStepSize;
+    if(step >= NumSteps || time > EndTime) time = EndTime;
+    return time;
+}
+
+void TLMResultRecorder::RecordTimeData(const TLMMessage& mess) {
+    if(!IsOpen || NextStep > NumSteps) return;
+    if(mess.Header.MessageType != TLMMessageTypeConst::TLM_TIME_DATA) return;
+
+    int id = mess.Header.TLMInterfaceID;
+    if(id < 0 || id >= int(ChannelIndex.size()) || ChannelIndex[id] < 0) return;
+
+    Channel& ch = Channels[ChannelIndex[id]];
+    if(ch.Kind == Channel3D) {
+        AppendRecords(ch.Data3D, mess);
+    }
+    else if(ch.Kind == ChannelSignal) {
+        AppendRecords(ch.DataSignal, mess);
+    }
+    else {
+        AppendRecords(ch.Data1D, mess);
+    }
+
+    // Write all rows that are complete.
+    while(NextStep <= NumSteps && IsStepReady(GetStepTime(NextStep))) {
+        WriteStep(GetStepTime(NextStep));
+        NextStep++;
+        CleanChannels(GetStepTime(NextStep));
+    }
+
+    // Do not keep the samples of this channel without bound while
+    // another one lags behind, e.g., since it sends no data.
+    while(NextStep <= NumSteps && ch.GetNumSamples() > MaxChannelSamples) {
+        WriteStep(GetStepTime(NextStep));
+        NextStep++;
+        NumForcedSteps++;
+        CleanChannels(GetStepTime(NextStep));
+    }
+}
+
+bool TLMResultRecorder::IsStepReady(double time) const {
+    for(size_t i = 0; i < Channels.size(); i++) {
+        if(Channels[i].GetLastTime() < time - Channels[i].Lag) return false;
+    }
+    return true;
+}
+
+void TLMResultRecorder::CleanChannels(double time) {
+    for(size_t i = 0; i < Channels.size(); i++) {
+        const double lagTime = time - Channels[i].Lag;
+        CleanData(Channels[i].DataSignal, lagTime);
+        CleanData(Channels[i].Data1D, lagTime);
+        CleanData(Channels[i].Data3D, lagTime);
+    }
+}
+
+void TLMResultRecorder::WriteStep(double time) {
+    // Evaluate the samples of all channels.
+    for(size_t i = 0; i < Channels.size(); i++) {
+        Channel& ch = Channels[i];
+        const double lagTime = time - ch.Lag;
+
+        if(ch.Kind == Channel3D) {
+            // Use the initial interface position until data is received.
+            if(ch.Data3D.empty()) {
+                ch.Sample3D = TheModel.GetTLMInterfaceProxy(ch.InterfaceID).getTime0Data3D();
+            }
+            else {
+                ch.Sample3D.time = lagTime;
+                GetSample(ch.Sample3D, ch.Data3D);
+            }
+            ch.Sample3D.time = lagTime;
+        }
+        else if(ch.Kind == ChannelSignal) {
+            ch.SampleSignal.time = lagTime;
+            if(!ch.DataSignal.empty()) GetSample(ch.SampleSignal, ch.DataSignal);
+        }
+        else {
+            ch.Sample1D.time = lagTime;
+            if(!ch.Data1D.empty()) GetSample(ch.Sample1D, ch.Data1D);
+        }
+    }
+
+    TM_Stop(&TimerInfo);
+
+    // As in tlmmonitor, the row is stamped with the time of the data of
+    // the first interface, but not before the start time.
+    double rowTime = time;
+    if(!Channels.empty()) rowTime = std::max(StartTime, time - Channels[0].Lag);
+
+    // Store data row, the run status is updated by the writer thread.
+    PrintData(rowTime);
+
+    // Publish the row as telemetry.
+    if(Telemetry.IsOpen()) {
+        const double* row = &FillBuffer[size_t(FillRows)*NumVariables];
+        for(size_t i = 0; i < TelemetryColumns.size(); i++) {
+            TelemetryRow[i] = row[TelemetryColumns[i]];
+        }
+        Telemetry.PublishRow(&TelemetryRow[0], NextStep, NumSteps);
+    }
+
+    // Keep the selected values in memory.
+    if(MemoryResults) {
+        const double* row = &FillBuffer[size_t(FillRows)*NumVariables];
+        for(size_t i = 0; i < MemoryColumns.size(); i++) {
+            MemoryValues[i].push_back(row[MemoryColumns[i]]);
+        }
+    }
+
+    FillRows++;
+
+    double wallTime = TimerInfo.total.tv_sec + TimerInfo.total.tv_nsec/1.0e9;
+    if(FillRows == RowsPerBuffer || wallTime - LastSubmitTime >= ResultBufferMaxAge) {
+        SubmitBuffer();
+        LastSubmitTime = wallTime;
+    }
+
+    TM_Start(&TimerInfo);
+}
+
+void TLMResultRecorder::SubmitBuffer() {
+    if(FillRows == 0) return;
+
+#ifdef USE_THREADS
+    BufferLock.lock();
+
+    // Wait until the writer thread is done with the other buffer.
+    if(FlushPending) {
+        NumBufferWaits++;
+        while(FlushPending) {
+            FlushDoneCond.wait(BufferLock);
+        }
+    }
+
+    FillBuffer.swap(FlushBuffer);
+    FlushRows = FillRows;
+    FlushPending = true;
+    FlushReadyCond.signal();
+
+    BufferLock.unlock();
+#else
+    WriteBuffer(FillBuffer, FillRows);
+#endif
+
+    FillRows = 0;
+}
+
+void TLMResultRecorder::WriteBuffer(const std::vector<double>& buffer, int numRows) {
+    Writer->WriteRows(&buffer[0], numRows);
+    RowsWritten += numRows;
+
+    // The first two values of the last row are the time and wall clock time.
+    const double* lastRow = &buffer[size_t(numRows-1)*NumVariables];
+    PrintRunStatus(lastRow[0], RowsWritten-1, lastRow[1]);
+}
+
+void* TLMResultRecorder::thread_WriterThreadRun(void* arg) {
+    TLMResultRecorder* recorder = reinterpret_cast<TLMResultRecorder*>(arg);
+    recorder->WriterThreadRun();
+    return NULL;
+}
+
+void TLMResultRecorder::WriterThreadRun() {
+    BufferLock.lock();
+
+    while(true) {
+        while(!FlushPending && !StopWriter) {
+            FlushReadyCond.wait(BufferLock);
+        }
+        if(!FlushPending) break;
+
+        // FlushBuffer is not touched by the recorder until FlushPending is reset.
+        BufferLock.unlock();
+        WriteBuffer(FlushBuffer, FlushRows);
+        BufferLock.lock();
+
+        FlushPending = false;
+        FlushDoneCond.signal();
+    }
+
+    BufferLock.unlock();
+}
+
+void TLMResultRecorder::StopWriterThread() {
+    SubmitBuffer();
+
+#ifdef USE_THREADS
+    if(!WriterRunning) return;
+
+    BufferLock.lock();
+    StopWriter = true;
+    FlushReadyCond.signal();
+    BufferLock.unlock();
+
+    pthread_join(WriterThread, NULL);
+    WriterRunning = false;
+#endif
+
+    assert(RowsWritten == NextStep);
+}
+
+void TLMResultRecorder::Close() {
+    if(!IsOpen) return;
+
+    if(NextStep <= NumSteps) {
+        TLMErrorLog::Info("Result recorder writes the remaining " + TLMErrorLog::ToStdStr(NumSteps-NextStep+1)
+                          + " rows using the last received data");
+    }
+    while(NextStep <= NumSteps) {
+        WriteStep(GetStepTime(NextStep));
+        NextStep++;
+    }
+
+    StopWriterThread();
+
+    // Readers that have the segment open can still read the final state.
+    Telemetry.SetDone();
+    Telemetry.Close();
+
+    if(NumForcedSteps > 0) {
+        TLMErrorLog::Warning("Result recorder wrote " + TLMErrorLog::ToStdStr(NumForcedSteps)
+                             + " rows with the last data of lagging interfaces");
+    }
+
+    if(NumBufferWaits > 0) {
+        TLMErrorLog::Info("Result recorder waited " + TLMErrorLog::ToStdStr(NumBufferWaits)
+                          + " times for the result writer thread");
+    }
+
+    Writer->Close();
+    RunFile.close();
+    IsOpen = false;
+}
+
+void TLMResultRecorder::PrintHeader() {
+    // First variables written are time and wall clock time.
+    VariableNames.clear();
+    VariableNames.push_back("time");
+    VariableNames.push_back("wallTime");
+
+    for(size_t i = 0; i < Channels.size(); i++) {
+        // Add all TLM variable names for all recorded interfaces
+        const std::string& name = Channels[i].Name;
+
+        switch(Channels[i].Kind) {
+        case Channel3D: {
+            const char* names3D[] = {
+                ".R[cG][cG](1) [m]", ".R[cG][cG](2) [m]", ".R[cG][cG](3) [m]", // Position vector
+                ".phi[cG](1) [rad]", ".phi[cG](2) [rad]", ".phi[cG](3) [rad]", // Orientation vector (three angles)
+                ".A(1,1) [-]", ".A(1,2) [-]", ".A(1,3) [-]",                   // Transformation matrix
+                ".A(2,1) [-]", ".A(2,2) [-]", ".A(2,3) [-]",
+                ".A(3,1) [-]", ".A(3,2) [-]", ".A(3,3) [-]",
+                ".vR[cG][cG,cG](1) [m/s]", ".vR[cG][cG,cG](2) [m/s]", ".vR[cG][cG,cG](3) [m/s]",       // velocity
+                ".Omega[cG][cG](1) [rad/s]", ".Omega[cG][cG](2) [rad/s]", ".Omega[cG][cG](3) [rad/s]", // angular velocity
+                ".F_tie[cG](1) [N]", ".F_tie[cG](2) [N]", ".F_tie[cG](3) [N]",                         // force vector
+                ".M_tie[cG][cG](1) [Nm]", ".M_tie[cG][cG](2) [Nm]", ".M_tie[cG][cG](3) [Nm]"           // torque vector
+            };
+            for(size_t j = 0; j < sizeof(names3D)/sizeof(names3D[0]); j++) {
+                VariableNames.push_back(name + names3D[j]);
+            }
+            break;
+        }
+        case ChannelHydraulic:
+            VariableNames.push_back(name + ".q [m^3/s]"); // Volume flow
+            VariableNames.push_back(name + ".p [Pa]");    // Pressure
+            break;
+        case ChannelMechanical:
+            VariableNames.push_back(name + ".x [m]");     // Position
+            VariableNames.push_back(name + ".v [m/s]");   // Speed
+            VariableNames.push_back(name + ".F [N]");     // Force
+            break;
+        case ChannelRotational:
+            VariableNames.push_back(name + ".phi [rad]"); // Position
+            VariableNames.push_back(name + ".w [rad/s]"); // Speed
+            VariableNames.push_back(name + ".T [Nm]");    // Force
+            break;
+        case ChannelElectric:
+            VariableNames.push_back(name + ".I [A]");     // Current
+            VariableNames.push_back(name + ".U [V]");     // Voltage
+            break;
+        case ChannelSignal:
+            VariableNames.push_back(name);                // Value
+            break;
+        }
+    }
+}
+
+void TLMResultRecorder::PrintData(double time) {
+    double wallTime = TimerInfo.total.tv_sec + TimerInfo.total.tv_nsec/1.0e9;
+
+    // The values are stored in the order of VariableNames.
+    double* value = &FillBuffer[size_t(FillRows)*NumVariables];
+    *value++ = time;
+    *value++ = wallTime;
+
+    for(size_t i = 0; i < Channels.size(); i++) {
+        const Channel& ch = Channels[i];
+
+        if(ch.Kind == Channel3D) {
+            const TLMTimeData3D& timeData = ch.Sample3D;
+
+            // Convert orientation matrix to angles
+
+            // first convert the matrices into double33 format
+            double33 A(timeData.RotMatrix[0], timeData.RotMatrix[1], timeData.RotMatrix[2],
+                    timeData.RotMatrix[3], timeData.RotMatrix[4], timeData.RotMatrix[5],
+                    timeData.RotMatrix[6], timeData.RotMatrix[7], timeData.RotMatrix[8]);
+
+            // Then convert to angles
+            double3 phi = ATophi321(A);
+
+            for(int j = 0; j < 3; j++) *value++ = timeData.Position[j];
+            for(int j = 1; j <= 3; j++) *value++ = phi(j);
+            for(int r = 1; r <= 3; r++) {
+                for(int c = 1; c <= 3; c++) *value++ = A(r,c);
+            }
+            for(int j = 0; j < 6; j++) *value++ = timeData.Velocity[j];
+
+            // Backward calculation of force from TLM wave.
+            // The wave sent by the interface is: C = - Force + Impedance * Velocity -> F = -(C - Imp*Vel)
+            for(int j = 0; j < 3; j++) *value++ = -timeData.GenForce[j] + ch.Zf * timeData.Velocity[j];
+            for(int j = 3; j < 6; j++) *value++ = -timeData.GenForce[j] + ch.Zfr * timeData.Velocity[j];
+        }
+        else if(ch.Kind == ChannelSignal) {
+            *value++ = ch.SampleSignal.Value;
+        }
+        else {
+            const TLMTimeData1D& timeData = ch.Sample1D;
+
+            // Backward calculation of force from TLM wave.
+            // The wave sent by the interface is: C = - Force + Impedance * Velocity -> F = -(C - Imp*Vel)
+            double force;
+            if(ch.Kind == ChannelHydraulic) {
+                force =  timeData.GenForce + ch.Zf * timeData.Velocity;
+            }
+            else {
+                force =  -timeData.GenForce + ch.Zf * timeData.Velocity;
+            }
+
+            if(ch.Kind == ChannelHydraulic || ch.Kind == ChannelElectric) {
+                *value++ = timeData.Velocity;     //Flow or current
+                *value++ = force;                 //Pressure or voltage
+            }
+            else {
+                *value++ = timeData.Position;     //Position or angle
+                *value++ = timeData.Velocity;     //Speed or angular velocity
+                *value++ = force;                 //Force or torque
+            }
+        }
+    }
+}
+
+void TLMResultRecorder::PrintRunStatus(double SimTime, int curStep, double wallTime) {
+    double progress = (NumSteps > 0) ? ((curStep*1.0)/(NumSteps*1.0))*100.0 : 100.0;
+    std::string statusStr = (curStep == NumSteps ? "Done" : "Running");
+
+    // Calculate average wall clock time for a single logging time step.
+    double avgStepTime = wallTime/(curStep+1);
+    double timeLeft = static_cast<double>(NumSteps-curStep)*avgStepTime;
+    int hLeft = timeLeft/3600;
+    int mLeft = (timeLeft - 3600.0*hLeft)/60;
+    int sLeft = (timeLeft - 3600.0*hLeft - 60.0*mLeft);
+
+    // Always write from beginning of file, that is, overwrite old data.
+    RunFile.seekp(0);
+    RunFile << "Status    : " << statusStr << std::endl;
+    RunFile << "Sim. time : " << SimTime   << std::endl;
+    RunFile << "Step      : " << curStep   << " of " << NumSteps << std::endl;
+    RunFile << "Progress  : " << progress   << "%" << std::endl;
+    RunFile << "            " << std::endl;
+    RunFile << "Estimated time left: " << hLeft << ":" << mLeft << ":" << sLeft << std::endl;
+    RunFile << "                                                              " << std::endl;
+}
@@ -0,0 +1,325 @@
+//!
+//! \file TLMResultRecorder.h
+//!
+//! Defines the TLMResultRecorder class that writes the co-simulation
+//! results from the time data routed by the TLM manager.
+//!
+
+#ifndef TLMResultRecorder_h_
+#define TLMResultRecorder_h_
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <fstream>
+
+#include "Communication/TLMCommUtil.h"
+#include "Communication/TLMCalcData.h"
+#include "CompositeModels/CompositeModel.h"
+#include "Logging/TLMResultWriter.h"
+#include "Logging/TLMTelemetry.h"
+#include "Communication/TLMThreadSynch.h"
+
+#ifndef NO_RTIME
+#include "timing.h"
+#else
+#include "SurrogateTimer.h"
+#endif //NO_RTIME
+
+//! \class TLMResultRecorder
+//! TLMResultRecorder samples the time data messages that the manager
+//! receives from the components and writes one result row for every
+//! logging instant StartTime + k*LogStepSize to <baseName>.csv,
+//! <baseName>.csv.gz for compressed text or <baseName>.mat for the
+//! binary format, see TLMResultWriter.
+//! The simulation progress is written to <baseName>.run.
+//! The rows hold the same data as those of tlmmonitor: for each instant
+//! the data an interface sent two TLM delays (one for signals) earlier,
+//! which is what the linked interface sees when it logs, without damping.
+//! The force is computed from that wave and velocity, F = -C + Z*v, and
+//! the row is stamped with the time of the data of the first interface.
+//! A row is written as soon as all recorded interfaces have sent data
+//! up to that time. The values are interpolated linearly
+//! between the samples sent by each interface. If an interface lags
+//! behind while another one has sent MaxChannelSamples samples, rows are
+//! written with the last data of the lagging interface.
+//! The rows are only stored in memory by the thread that feeds the
+//! recorder. Two row buffers are used: while one is filled the other
+//! is written to the files by a separate writer thread, so that the
+//! file I/O does not delay the manager.
+//! Optionally the rows are also published as live telemetry in shared
+//! memory, see TLMTelemetryPublisher, or kept in memory for the caller,
+//! see SetMemoryResults.
+//! The recorder is not thread safe, it is fed by the manager reader thread.
+class TLMResultRecorder {
+public:
+    //! Constructor.
+    //! \param model The composite model, interfaces with a connection are recorded.
+    //! \param baseName Base name of the result files.
+    //! \param logStepSize Time between the logging instants.
+    //! \param format Result file format, "csv", "csv.gz" or "mat".
+    TLMResultRecorder(omtlm_CompositeModel& model, const std::string& baseName, double logStepSize,
+                      const std::string& format = "csv");
+
+    //! Destructor, closes the result files.
+    ~TLMResultRecorder();
+
+    //! Publish the rows as telemetry in the shared memory segment "segmentName".
+    //! Must be called before Open.
+    //! \param interfaces Names (component.interface) of the published
+    //!                   interfaces, all interfaces if empty.
+    void SetTelemetry(const std::string& segmentName, const std::vector<std::string>& interfaces);
+
+    //! Keep the results of the given interfaces in memory, in addition
+    //! to the result file. Must be called before Open.
+    //! \param interfaces Names (component.interface) of the kept
+    //!                   interfaces, all interfaces if empty.
+    void SetMemoryResults(const std::vector<std::string>& interfaces);
+
+    //! Move the results kept in memory to the caller, call after Close.
+    //! \param names Set to the variable names, the first two are time and wallTime.
+    //! \param values Set to one contiguous array per variable, one value per row.
+    void GetMemoryResults(std::vector<std::string>& names, std::vector<std::vector<double> >& values);
+
+    //! Open the result and run status files and write the header.
+    void Open();
+
+    //! Record the time data of a message received from a component,
+    //! that is, before it is marshaled to the linked interface.
+    //! Writes all result rows that are complete after this message.
+    void RecordTimeData(const TLMMessage& mess);
+
+    //! Write the remaining rows up to the end time, extrapolating
+    //! the data if needed, and close the result files.
+    void Close();
+
+    //! Get the number of result rows recorded so far,
+    //! the last ones might not be written to the file yet.
+    int GetNumRows() const { return NextStep; }
+
+private:
+    //! Kind of a recorded interface, resolved once from the dimensions,
+    //! causality and domain of the interface.
+    enum ChannelKind {
+        Channel3D,
+        ChannelHydraulic,
+        ChannelMechanical,
+        ChannelRotational,
+        ChannelElectric,
+        ChannelSignal
+    };
+
+    //! The recorded samples of one interface.
+    struct Channel {
+        //! Interface ID.
+        int InterfaceID;
+
+        //! Kind of interface, determines the result variables.
+        ChannelKind Kind;
+
+        //! Full interface name, i.e., component.interface.
+        std::string Name;
+
+        //! Impedances of the connection, used to compute the force.
+        double Zf, Zfr;
+
+        //! Time the recorded data lags behind the logging instant.
+        double Lag;
+
+        //! Samples of output signal interfaces.
+        std::deque<TLMTimeDataSignal> DataSignal;
+
+        //! Samples of bidirectional 1D interfaces.
+        std::deque<TLMTimeData1D> Data1D;
+
+        //! Samples of 3D interfaces.
+        std::deque<TLMTimeData3D> Data3D;
+
+        //! The data logged at the current logging instant.
+        TLMTimeDataSignal SampleSignal;
+        TLMTimeData1D Sample1D;
+        TLMTimeData3D Sample3D;
+
+        Channel();
+
+        //! Time of the last sample or a time before the start if nothing was received.
+        double GetLastTime() const;
+
+        //! Number of samples kept.
+        size_t GetNumSamples() const;
+    };
+
+    //! Check if all channels have the data of the logging instant "time".
+    bool IsStepReady(double time) const;
+
+    //! Evaluate all channels at the given time and store one row.
+    void WriteStep(double time);
+
+    //! Remove the samples that are not needed for times after "time".
+    //! We leave one sample before "time" for the interpolation.
+    void CleanChannels(double time);
+
+    //! Get the time of logging step number "step".
+    double GetStepTime(int step) const;
+
+    //! Build the variable names of the header.
+    void PrintHeader();
+
+    //! Store the current samples of all channels as one row in the fill buffer.
+    void PrintData(double time);
+
+    //! Select the time, wallTime and the variables of the given interfaces.
+    //! \param interfaces Interface names, all variables are selected if empty.
+    //! \param columns Set to the row indices of the selected variables.
+    void SelectVariables(const std::vector<std::string>& interfaces, std::vector<int>& columns) const;
+
+    //! Create the telemetry segment for the selected variables.
+    void OpenTelemetry();
+
+    //! Write the simulation progress to the run file.
+    //! \param SimTime Simulation time of the last written row.
+    //! \param curStep Logging step number of the last written row.
+    //! \param wallTime Wall clock time of the last written row.
+    void PrintRunStatus(double SimTime, int curStep, double wallTime);
+
+    //! Hand the fill buffer over to the writer thread. Waits only if
+    //! the writer thread has not finished the previous buffer yet.
+    void SubmitBuffer();
+
+    //! Write the rows of a buffer and update the run status.
+    void WriteBuffer(const std::vector<double>& buffer, int numRows);
+
+    //! Submit the remaining rows and stop the writer thread.
+    void StopWriterThread();
+
+    //! Writer thread main loop.
+    void WriterThreadRun();
+
+    //! Writer thread entry point, "arg" is the recorder.
+    static void* thread_WriterThreadRun(void* arg);
+
+    //! The composite model.
+    omtlm_CompositeModel& TheModel;
+
+    //! Base name of the result files.
+    std::string BaseName;
+
+    //! Result file format.
+    std::string Format;
+
+    //! Time between the logging instants.
+    double LogStepSize;
+
+    //! First and last logging instants.
+    double StartTime, EndTime;
+
+    //! Number of the last logging step, i.e., NumSteps+1 rows are written.
+    int NumSteps;
+
+    //! The next logging step to be written.
+    int NextStep;
+
+    //! Number of rows written before all channels had data up to the
+    //! logging instant, since a channel had too many samples.
+    int NumForcedSteps;
+
+    //! Recorded channels in the order of the result variables.
+    std::vector<Channel> Channels;
+
+    //! Index in Channels for each interface ID, -1 if not recorded.
+    std::vector<int> ChannelIndex;
+
+    //! Result data file writer.
+    TLMResultWriter* Writer;
+
+    //! Variable names, the first two are time and wallTime.
+    std::vector<std::string> VariableNames;
+
+    //! Number of values per row.
+    int NumVariables;
+
+    //! Number of rows per buffer.
+    int RowsPerBuffer;
+
+    //! Buffer filled by the recorder, RowsPerBuffer rows one after the other.
+    std::vector<double> FillBuffer;
+
+    //! Number of rows in FillBuffer.
+    int FillRows;
+
+    //! Buffer written by the writer thread.
+    std::vector<double> FlushBuffer;
+
+    //! Number of rows in FlushBuffer.
+    int FlushRows;
+
+    //! True while FlushBuffer is owned by the writer thread.
+    bool FlushPending;
+
+    //! True if the writer thread should exit when FlushBuffer is written.
+    bool StopWriter;
+
+    //! Number of rows written to the result file.
+    int RowsWritten;
+
+    //! Number of times the recorder had to wait for the writer thread.
+    int NumBufferWaits;
+
+    //! Protects the buffer hand over.
+    SimpleLock BufferLock;
+
+    //! Signaled when a buffer is submitted or the writer should stop.
+    SimpleCond FlushReadyCond;
+
+    //! Signaled when the writer thread has written a buffer.
+    SimpleCond FlushDoneCond;
+
+#ifdef USE_THREADS
+    //! The writer thread.
+    pthread_t WriterThread;
+#endif
+
+    //! True while the writer thread is running.
+    bool WriterRunning;
+
+    //! Wall clock time when the last buffer was submitted.
+    double LastSubmitTime;
+
+    //! Telemetry segment name, no telemetry if empty.
+    std::string TelemetryName;
+
+    //! Interfaces published as telemetry, all if empty.
+    std::vector<std::string> TelemetryInterfaces;
+
+    //! Telemetry publisher.
+    TLMTelemetryPublisher Telemetry;
+
+    //! Row indices of the published variables.
+    std::vector<int> TelemetryColumns;
+
+    //! Values of the published variables of the current row.
+    std::vector<double> TelemetryRow;
+
+    //! True if results are kept in memory.
+    bool MemoryResults;
+
+    //! Interfaces kept in memory, all if empty.
+    std::vector<std::string> MemoryInterfaces;
+
+    //! Row indices of the variables kept in memory.
+    std::vector<int> MemoryColumns;
+
+    //! The values kept in memory, one array per variable in MemoryColumns.
+    std::vector<std::vector<double> > MemoryValues;
+
+    //! Run status file.
+    std::ofstream RunFile;
+
+    //! Wall clock timer, restarted for each row.
+    tTM_Info TimerInfo;
+
+    //! True between Open and Close.
+    bool IsOpen;
+};
+
+#endif
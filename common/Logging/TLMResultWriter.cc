@@ -0,0 +1,186 @@
+/**
+ * File: TLMResultWriter.cc
+ *
+ * Implementation of the result file writers
+ */
+#include "Logging/TLMResultWriter.h"
+#include "Communication/TLMCommUtil.h"
+#include <algorithm>
+#include <cstring>
+
+TLMResultWriter* TLMResultWriter::CreateWriter(const std::string& format) {
+    if(format == "csv") {
+        return new TLMCSVResultWriter();
+    }
+    else if(format == "csv.gz") {
+        return new TLMCSVResultWriter(true);
+    }
+    else if(format == "mat") {
+        return new TLMMatResultWriter();
+    }
+    return NULL;
+}
+
+bool TLMCSVResultWriter::Open(const std::string& fileName, const std::vector<std::string>& names) {
+    // The result writer runs in its own thread, i.e., compress in this thread.
+    if(Compressed) {
+        CompressedFile.open(fileName, false);
+        Out = &CompressedFile;
+    }
+    else {
+        DataFile.open(fileName.c_str());
+        Out = &DataFile;
+    }
+    if(!Out->good()) return false;
+
+    NumVariables = names.size();
+    for(size_t i = 0; i < names.size(); i++) {
+        if(i > 0) *Out << ",";
+        *Out << "\"" << names[i] << "\"";
+    }
+    *Out << std::endl;
+
+    return true;
+}
+
+void TLMCSVResultWriter::WriteRows(const double* values, int numRows) {
+    if(Out == NULL) return;
+    for(int row = 0; row < numRows; row++) {
+        for(size_t i = 0; i < NumVariables; i++) {
+            if(i > 0) *Out << ",";
+            *Out << *values++;
+        }
+        *Out << "\n";
+    }
+    Out->flush();
+}
+
+void TLMCSVResultWriter::Close() {
+    if(DataFile.is_open()) {
+        DataFile.close();
+    }
+    if(CompressedFile.is_open()) {
+        CompressedFile.close();
+    }
+    Out = NULL;
+}
+
+void TLMMatResultWriter::WriteMatrixHeader(const char* name, int type, int rows, int cols) {
+    int header[5];
+    // The M digit of the type tells the byte order of the data.
+    header[0] = type + (TLMMessageHeader::IsBigEndianSystem ? 1000 : 0);
+    header[1] = rows;
+    header[2] = cols;
+    header[3] = 0; // no imaginary part
+    header[4] = int(strlen(name)) + 1;
+    fwrite(header, sizeof(int), 5, DataFile);
+    fwrite(name, 1, header[4], DataFile);
+}
+
+void TLMMatResultWriter::WriteTextMatrix(const char* name, const std::vector<std::string>& strings) {
+    size_t maxLen = 1;
+    for(size_t i = 0; i < strings.size(); i++) {
+        if(strings[i].size() > maxLen) maxLen = strings[i].size();
+    }
+
+    // Stored column-wise, one (zero padded) string per column.
+    WriteMatrixHeader(name, 51, int(maxLen), int(strings.size()));
+    std::vector<char> buf(maxLen);
+    for(size_t i = 0; i < strings.size(); i++) {
+        std::fill(buf.begin(), buf.end(), 0);
+        memcpy(&buf[0], strings[i].data(), strings[i].size());
+        fwrite(&buf[0], 1, maxLen, DataFile);
+    }
+}
+
+bool TLMMatResultWriter::Open(const std::string& fileName, const std::vector<std::string>& names) {
+    DataFile = fopen(fileName.c_str(), "wb");
+    if(DataFile == NULL) return false;
+
+    NumVariables = int(names.size());
+    NumRows = 0;
+
+    std::vector<std::string> aclass;
+    aclass.push_back("Atrajectory");
+    aclass.push_back("1.1");
+    aclass.push_back("");
+    aclass.push_back("binTrans");
+
+    // Aclass is stored row-wise, i.e., as the transpose of a text matrix.
+    WriteMatrixHeader("Aclass", 51, int(aclass.size()), 11);
+    for(int col = 0; col < 11; col++) {
+        for(size_t row = 0; row < aclass.size(); row++) {
+            char c = (size_t(col) < aclass[row].size()) ? aclass[row][col] : ' ';
+            fwrite(&c, 1, 1, DataFile);
+        }
+    }
+
+    // The units are part of the names, split them into the description.
+    std::vector<std::string> varNames, descriptions;
+    for(size_t i = 0; i < names.size(); i++) {
+        std::string::size_type pos = names[i].rfind(" [");
+        if(pos != std::string::npos && names[i][names[i].size()-1] == ']') {
+            varNames.push_back(names[i].substr(0, pos));
+            descriptions.push_back(names[i].substr(pos+1));
+        }
+        else {
+            varNames.push_back(names[i]);
+            descriptions.push_back("");
+        }
+    }
+    WriteTextMatrix("name", varNames);
+    WriteTextMatrix("description", descriptions);
+
+    // Time is the abscissa, all other variables are stored in data_2.
+    WriteMatrixHeader("dataInfo", 20, 4, NumVariables);
+    for(int i = 0; i < NumVariables; i++) {
+        int info[4] = { (i == 0) ? 0 : 2, i+1, 0, -1 };
+        fwrite(info, sizeof(int), 4, DataFile);
+    }
+
+    // data_1 holds the time interval of the rows only, there are no parameters.
+    WriteMatrixHeader("data_1", 0, 1, 2);
+    Interval[0] = Interval[1] = 0.0;
+    IntervalPos = ftell(DataFile);
+    fwrite(Interval, sizeof(double), 2, DataFile);
+
+    // data_2 holds one column per row, the column count is updated with the rows.
+    int header[5] = { TLMMessageHeader::IsBigEndianSystem ? 1000 : 0, NumVariables, 0, 0, 7 };
+    fwrite(header, sizeof(int), 2, DataFile);
+    NumRowsPos = ftell(DataFile);
+    fwrite(&header[2], sizeof(int), 3, DataFile);
+    fwrite("data_2", 1, 7, DataFile);
+
+    return !ferror(DataFile);
+}
+
+void TLMMatResultWriter::WriteRows(const double* values, int numRows) {
+    if(DataFile == NULL || numRows <= 0) return;
+    // The rows are the columns of data_2, i.e., they are written as one block.
+    fwrite(values, sizeof(double), size_t(NumVariables)*numRows, DataFile);
+
+    // Time is the first value of a row.
+    if(NumRows == 0) Interval[0] = values[0];
+    Interval[1] = values[size_t(numRows-1)*NumVariables];
+    NumRows += numRows;
+
+    UpdateHeader();
+}
+
+void TLMMatResultWriter::UpdateHeader() {
+    fseek(DataFile, IntervalPos, SEEK_SET);
+    fwrite(Interval, sizeof(double), 2, DataFile);
+    fseek(DataFile, NumRowsPos, SEEK_SET);
+    fwrite(&NumRows, sizeof(int), 1, DataFile);
+    fseek(DataFile, 0, SEEK_END);
+    fflush(DataFile);
+}
+
+void TLMMatResultWriter::Close() {
+    if(DataFile == NULL) return;
+
+    UpdateHeader();
+
+    fclose(DataFile);
+    DataFile = NULL;
+}
@@ -0,0 +1,132 @@
+//!
+//! \file TLMResultWriter.h
+//!
+//! Defines the result file writers used by TLMResultRecorder.
+//!
+
+#ifndef TLMResultWriter_h_
+#define TLMResultWriter_h_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+
+#include "Logging/TLMCompressedStream.h"
+
+//! \class TLMResultWriter
+//! TLMResultWriter is the interface of the result file formats.
+//! A result file holds one column per variable and one row per logging
+//! instant. The first two variables are "time" and "wallTime".
+class TLMResultWriter {
+public:
+    virtual ~TLMResultWriter() {}
+
+    //! Create a writer for the given format, "csv", "csv.gz" or "mat".
+    //! Returns NULL for unknown formats.
+    static TLMResultWriter* CreateWriter(const std::string& format);
+
+    //! Result file extension, e.g., ".csv".
+    virtual std::string GetExtension() const = 0;
+
+    //! Open the result file and write the header.
+    //! \param fileName Result file name including extension.
+    //! \param names Variable names, the units are given in brackets after the name.
+    //! \return True if the file could be opened.
+    virtual bool Open(const std::string& fileName, const std::vector<std::string>& names) = 0;
+
+    //! Write "numRows" rows stored one after the other in "values",
+    //! the values of a row are ordered as the names given to Open.
+    virtual void WriteRows(const double* values, int numRows) = 0;
+
+    //! Complete and close the result file.
+    virtual void Close() = 0;
+};
+
+//! \class TLMCSVResultWriter
+//! Writes the results as comma separated text with a quoted header line.
+//! The text is optionally block compressed, see TLMCompressedStreamBuf.
+class TLMCSVResultWriter : public TLMResultWriter {
+public:
+    //! Constructor.
+    //! \param compressed Write a compressed file.
+    explicit TLMCSVResultWriter(bool compressed = false)
+        : Compressed(compressed), DataFile(), CompressedFile(), Out(NULL), NumVariables(0) {}
+
+    std::string GetExtension() const { return Compressed ? ".csv.gz" : ".csv"; }
+
+    bool Open(const std::string& fileName, const std::vector<std::string>& names);
+
+    void WriteRows(const double* values, int numRows);
+
+    void Close();
+
+private:
+    //! True if the file is compressed.
+    bool Compressed;
+
+    //! Result data file.
+    std::ofstream DataFile;
+
+    //! Compressed result data file.
+    TLMCompressedOStream CompressedFile;
+
+    //! The stream written to, DataFile or CompressedFile.
+    std::ostream* Out;
+
+    //! Number of variables, i.e., values per row.
+    size_t NumVariables;
+};
+
+//! \class TLMMatResultWriter
+//! Writes the results in binary MATLAB v4 format using the trajectory
+//! layout of Dymola and OpenModelica result files ("binTrans"), that is,
+//! the matrices Aclass, name, description, dataInfo, data_1 and data_2.
+//! data_2 holds one column per row of results so that the rows can be
+//! appended. The number of rows and the time interval in data_1 are
+//! updated after every write, so that an aborted run leaves a valid file.
+class TLMMatResultWriter : public TLMResultWriter {
+public:
+    TLMMatResultWriter() : DataFile(NULL), NumVariables(0), NumRows(0), IntervalPos(0), NumRowsPos(0) {}
+
+    ~TLMMatResultWriter() { Close(); }
+
+    std::string GetExtension() const { return ".mat"; }
+
+    bool Open(const std::string& fileName, const std::vector<std::string>& names);
+
+    void WriteRows(const double* values, int numRows);
+
+    void Close();
+
+private:
+    //! Write a MAT v4 matrix header.
+    //! \param type MOPT type code, 0 for double, 20 for int32 and 51 for text.
+    void WriteMatrixHeader(const char* name, int type, int rows, int cols);
+
+    //! Write a text matrix with one string per column.
+    void WriteTextMatrix(const char* name, const std::vector<std::string>& strings);
+
+    //! Update the time interval and the number of rows in the file.
+    void UpdateHeader();
+
+    //! Result data file.
+    FILE* DataFile;
+
+    //! Number of variables (rows of data_2).
+    int NumVariables;
+
+    //! Number of result rows written (columns of data_2).
+    int NumRows;
+
+    //! First and last time written, i.e., the contents of data_1.
+    double Interval[2];
+
+    //! File position of the values of data_1.
+    long IntervalPos;
+
+    //! File position of the column count of data_2.
+    long NumRowsPos;
+};
+
+#endif
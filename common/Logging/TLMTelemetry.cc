@@ -0,0 +1,395 @@
+/**
+ * File: TLMTelemetry.cc
+ *
+ * Implementation of the shared memory telemetry
+ */
+#include "Logging/TLMTelemetry.h"
+#include <cstring>
+#include <new>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#endif
+
+namespace {
+    //! "TLMT"
+    const uint32_t TLMTelemetryMagic = 0x544c4d54;
+
+    const uint32_t TLMTelemetryVersion = 1;
+
+    //! Bytes per variable name.
+    const uint32_t TLMTelemetryNameSize = 128;
+
+    //! Size of a slot with "numVariables" values.
+    size_t GetSlotSize(uint32_t numVariables) {
+        return offsetof(TLMTelemetrySlot, Values) + numVariables*sizeof(double);
+    }
+
+    int GetCurrentPid() {
+#ifdef _WIN32
+        return int(GetCurrentProcessId());
+#else
+        return int(getpid());
+#endif
+    }
+
+    bool IsProcessRunning(int pid) {
+#ifdef _WIN32
+        HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, DWORD(pid));
+        if(process == NULL) return false;
+        bool running = (WaitForSingleObject(process, 0) == WAIT_TIMEOUT);
+        CloseHandle(process);
+        return running;
+#else
+        return kill(pid, 0) == 0 || errno == EPERM;
+#endif
+    }
+}
+
+TLMTelemetrySegment::TLMTelemetrySegment()
+    : Name(), Data(NULL), Size(0), Owner(false)
+#ifdef _WIN32
+    , Handle(NULL)
+#endif
+{
+}
+
+TLMTelemetrySegment::~TLMTelemetrySegment() {
+    Close();
+}
+
+#ifdef _WIN32
+
+bool TLMTelemetrySegment::Create(const std::string& name, size_t size) {
+    Close();
+    Name = "Local\\" + name;
+
+    Handle = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                DWORD((unsigned long long)size >> 32), DWORD(size & 0xffffffff), Name.c_str());
+    if(Handle == NULL) return false;
+    if(GetLastError() == ERROR_ALREADY_EXISTS) {
+        Close();
+        return false;
+    }
+
+    Data = static_cast<char*>(MapViewOfFile(Handle, FILE_MAP_ALL_ACCESS, 0, 0, size));
+    if(Data == NULL) {
+        Close();
+        return false;
+    }
+    memset(Data, 0, size);
+    Size = size;
+    Owner = true;
+    return true;
+}
+
+bool TLMTelemetrySegment::Open(const std::string& name) {
+    Close();
+    Name = "Local\\" + name;
+
+    Handle = OpenFileMappingA(FILE_MAP_READ, FALSE, Name.c_str());
+    if(Handle == NULL) return false;
+
+    Data = static_cast<char*>(MapViewOfFile(Handle, FILE_MAP_READ, 0, 0, 0));
+    if(Data == NULL) {
+        Close();
+        return false;
+    }
+
+    MEMORY_BASIC_INFORMATION info;
+    VirtualQuery(Data, &info, sizeof(info));
+    Size = info.RegionSize;
+    return true;
+}
+
+void TLMTelemetrySegment::Close() {
+    if(Data != NULL) UnmapViewOfFile(Data);
+    if(Handle != NULL) CloseHandle(Handle);
+    Data = NULL;
+    Handle = NULL;
+    Size = 0;
+    Owner = false;
+}
+
+void TLMTelemetrySegment::Remove(const std::string& name) {
+    // A file mapping is removed with the last handle to it.
+    (void)name;
+}
+
+#else
+
+bool TLMTelemetrySegment::Create(const std::string& name, size_t size) {
+    Close();
+    Name = (name.size() > 0 && name[0] == '/') ? name : "/" + name;
+
+    int fd = shm_open(Name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if(fd < 0) return false;
+
+    if(ftruncate(fd, size) != 0) {
+        close(fd);
+        shm_unlink(Name.c_str());
+        return false;
+    }
+
+    void* data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED) {
+        shm_unlink(Name.c_str());
+        return false;
+    }
+
+    Data = static_cast<char*>(data);
+    Size = size;
+    Owner = true;
+    return true;
+}
+
+bool TLMTelemetrySegment::Open(const std::string& name) {
+    Close();
+    Name = (name.size() > 0 && name[0] == '/') ? name : "/" + name;
+
+    int fd = shm_open(Name.c_str(), O_RDONLY, 0);
+    if(fd < 0) return false;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED) return false;
+
+    Data = static_cast<char*>(data);
+    Size = st.st_size;
+    return true;
+}
+
+void TLMTelemetrySegment::Close() {
+    if(Data != NULL) {
+        munmap(Data, Size);
+        if(Owner) shm_unlink(Name.c_str());
+    }
+    Data = NULL;
+    Size = 0;
+    Owner = false;
+}
+
+void TLMTelemetrySegment::Remove(const std::string& name) {
+    std::string sysName = (name.size() > 0 && name[0] == '/') ? name : "/" + name;
+    shm_unlink(sysName.c_str());
+}
+
+#endif
+
+TLMTelemetryPublisher::TLMTelemetryPublisher()
+    : Segment(), Header(NULL), SlotSize(0)
+{
+}
+
+bool TLMTelemetryPublisher::Open(const std::string& name, const std::vector<std::string>& names,
+                                 double startTime, double endTime, int ringSize) {
+    Close();
+    if(ringSize < 1) ringSize = 1;
+
+    uint32_t numVariables = uint32_t(names.size());
+    SlotSize = GetSlotSize(numVariables);
+
+    // The slots are aligned to 8 bytes after the names.
+    size_t slotOffset = sizeof(TLMTelemetryHeader) + size_t(numVariables)*TLMTelemetryNameSize;
+    slotOffset = (slotOffset + 7) & ~size_t(7);
+    size_t size = slotOffset + size_t(ringSize)*SlotSize;
+
+    if(!Segment.Create(name, size)) {
+        if(GetRunningPublisher(name) != 0) return false;
+
+        // Replace the segment left by a run that was killed.
+        TLMTelemetrySegment::Remove(name);
+        if(!Segment.Create(name, size)) return false;
+    }
+
+    char* data = Segment.GetData();
+    Header = new(data) TLMTelemetryHeader;
+    Header->Version = TLMTelemetryVersion;
+    Header->NumVariables = numVariables;
+    Header->RingSize = uint32_t(ringSize);
+    Header->NameSize = TLMTelemetryNameSize;
+    Header->SlotOffset = uint32_t(slotOffset);
+    Header->StartTime = startTime;
+    Header->EndTime = endTime;
+    Header->StatusSeq.store(0, std::memory_order_relaxed);
+    Header->Status = TelemetryStarting;
+    Header->PublisherPid = GetCurrentPid();
+    Header->Step = 0;
+    Header->NumSteps = 0;
+    Header->SimTime = startTime;
+    Header->WallTime = 0.0;
+    Header->NumRows.store(0, std::memory_order_relaxed);
+
+    // Names are truncated if needed, they are always zero terminated.
+    char* nameData = data + sizeof(TLMTelemetryHeader);
+    for(uint32_t i = 0; i < numVariables; i++) {
+        strncpy(nameData + i*TLMTelemetryNameSize, names[i].c_str(), TLMTelemetryNameSize-1);
+    }
+
+    for(int i = 0; i < ringSize; i++) {
+        new(data + slotOffset + i*SlotSize) TLMTelemetrySlot;
+        reinterpret_cast<TLMTelemetrySlot*>(data + slotOffset + i*SlotSize)->Seq.store(0, std::memory_order_relaxed);
+    }
+
+    // Readers check the magic number last.
+    std::atomic_thread_fence(std::memory_order_release);
+    Header->Magic = TLMTelemetryMagic;
+
+    return true;
+}
+
+int TLMTelemetryPublisher::GetRunningPublisher(const std::string& name) {
+    TLMTelemetrySegment segment;
+    if(!segment.Open(name) || segment.GetSize() < sizeof(TLMTelemetryHeader)) return 0;
+
+    int pid = reinterpret_cast<const TLMTelemetryHeader*>(segment.GetData())->PublisherPid;
+    if(pid <= 0 || !IsProcessRunning(pid)) return 0;
+    return pid;
+}
+
+void TLMTelemetryPublisher::PublishRow(const double* values, int step, int numSteps) {
+    if(Header == NULL) return;
+
+    uint64_t row = Header->NumRows.load(std::memory_order_relaxed);
+    TLMTelemetrySlot* slot = reinterpret_cast<TLMTelemetrySlot*>(
+        Segment.GetData() + Header->SlotOffset + (row % Header->RingSize)*SlotSize);
+
+    // Write the row, the odd sequence number tells the readers that it is incomplete.
+    slot->Seq.store(2*row+1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(slot->Values, values, Header->NumVariables*sizeof(double));
+    slot->Seq.store(2*row+2, std::memory_order_release);
+    Header->NumRows.store(row+1, std::memory_order_release);
+
+    // Update the status the same way, a reader that sees it also sees the row.
+    uint64_t seq = Header->StatusSeq.load(std::memory_order_relaxed);
+    Header->StatusSeq.store(seq+1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    Header->Status = (step >= numSteps) ? TelemetryDone : TelemetryRunning;
+    Header->Step = step;
+    Header->NumSteps = numSteps;
+    Header->SimTime = values[0];
+    Header->WallTime = values[1];
+    Header->StatusSeq.store(seq+2, std::memory_order_release);
+}
+
+void TLMTelemetryPublisher::SetDone() {
+    if(Header == NULL) return;
+
+    uint64_t seq = Header->StatusSeq.load(std::memory_order_relaxed);
+    Header->StatusSeq.store(seq+1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    Header->Status = TelemetryDone;
+    Header->StatusSeq.store(seq+2, std::memory_order_release);
+}
+
+void TLMTelemetryPublisher::Close() {
+    Segment.Close();
+    Header = NULL;
+}
+
+TLMTelemetryReader::TLMTelemetryReader()
+    : Segment(), Header(NULL), SlotSize(0), VariableNames()
+{
+}
+
+bool TLMTelemetryReader::Open(const std::string& name) {
+    Close();
+    if(!Segment.Open(name)) return false;
+
+    const TLMTelemetryHeader* header = reinterpret_cast<const TLMTelemetryHeader*>(Segment.GetData());
+    if(Segment.GetSize() < sizeof(TLMTelemetryHeader) || header->Magic != TLMTelemetryMagic
+       || header->Version != TLMTelemetryVersion) {
+        Segment.Close();
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    SlotSize = GetSlotSize(header->NumVariables);
+    if(Segment.GetSize() < header->SlotOffset + header->RingSize*SlotSize) {
+        Segment.Close();
+        return false;
+    }
+
+    const char* nameData = Segment.GetData() + sizeof(TLMTelemetryHeader);
+    for(uint32_t i = 0; i < header->NumVariables; i++) {
+        VariableNames.push_back(std::string(nameData + i*header->NameSize));
+    }
+
+    Header = header;
+    return true;
+}
+
+void TLMTelemetryReader::Close() {
+    Segment.Close();
+    Header = NULL;
+    VariableNames.clear();
+}
+
+void TLMTelemetryReader::ReadStatus(TLMTelemetryStatusData& status) const {
+    if(Header == NULL) return;
+
+    uint64_t seq1, seq2;
+    do {
+        seq1 = Header->StatusSeq.load(std::memory_order_acquire);
+        status.Status = Header->Status;
+        status.Step = Header->Step;
+        status.NumSteps = Header->NumSteps;
+        status.SimTime = Header->SimTime;
+        status.WallTime = Header->WallTime;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        seq2 = Header->StatusSeq.load(std::memory_order_relaxed);
+    } while((seq1 & 1) != 0 || seq1 != seq2);
+
+    status.StartTime = Header->StartTime;
+    status.EndTime = Header->EndTime;
+    status.NumRows = Header->NumRows.load(std::memory_order_acquire);
+}
+
+uint64_t TLMTelemetryReader::GetNumRows() const {
+    if(Header == NULL) return 0;
+    return Header->NumRows.load(std::memory_order_acquire);
+}
+
+bool TLMTelemetryReader::ReadRow(uint64_t row, std::vector<double>& values) const {
+    if(Header == NULL) return false;
+
+    const TLMTelemetrySlot* slot = reinterpret_cast<const TLMTelemetrySlot*>(
+        Segment.GetData() + Header->SlotOffset + (row % Header->RingSize)*SlotSize);
+
+    values.resize(Header->NumVariables);
+
+    uint64_t seq1 = slot->Seq.load(std::memory_order_acquire);
+    if(seq1 != 2*row+2) return false;
+
+    memcpy(&values[0], slot->Values, Header->NumVariables*sizeof(double));
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t seq2 = slot->Seq.load(std::memory_order_relaxed);
+    return seq1 == seq2;
+}
+
+bool TLMTelemetryReader::ReadLatest(std::vector<double>& values, uint64_t& row) const {
+    // Retry if the publisher overwrote the row while it was copied.
+    for(;;) {
+        uint64_t numRows = GetNumRows();
+        if(numRows == 0) return false;
+
+        row = numRows-1;
+        if(ReadRow(row, values)) return true;
+    }
+}
@@ -0,0 +1,236 @@
+//!
+//! \file TLMTelemetry.h
+//!
+//! Defines the shared memory telemetry segment that publishes the
+//! progress and the latest results of a running co-simulation, and the
+//! reader used by dashboards and the tlmtelemetry tool.
+//!
+
+#ifndef TLMTelemetry_h_
+#define TLMTelemetry_h_
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <stdint.h>
+
+//! Layout of the start of the telemetry segment.
+//! The header is followed by NumVariables names of NameSize characters
+//! and RingSize slots, see TLMTelemetrySlot.
+struct TLMTelemetryHeader {
+    //! TLMTelemetryMagic when the segment is initialized.
+    uint32_t Magic;
+
+    //! Layout version, TLMTelemetryVersion.
+    uint32_t Version;
+
+    //! Number of values per row, the first two are time and wallTime.
+    uint32_t NumVariables;
+
+    //! Number of rows kept in the ring.
+    uint32_t RingSize;
+
+    //! Size of each variable name including the terminating zero.
+    uint32_t NameSize;
+
+    //! Byte offset of the first slot.
+    uint32_t SlotOffset;
+
+    //! Simulation start and end time.
+    double StartTime, EndTime;
+
+    //! Sequence counter of the status below, odd while it is updated.
+    std::atomic<uint64_t> StatusSeq;
+
+    //! Simulation status, see TLMTelemetryStatus.
+    int32_t Status;
+
+    //! Process ID of the publisher.
+    int32_t PublisherPid;
+
+    //! Logging step of the last row and the last logging step.
+    int64_t Step, NumSteps;
+
+    //! Simulation time and wall clock time of the last row.
+    double SimTime, WallTime;
+
+    //! Number of rows published so far.
+    std::atomic<uint64_t> NumRows;
+};
+
+//! One row of the ring. Row "r" is stored in slot r % RingSize.
+//! Seq is 2*r+1 while the row is written and 2*r+2 when it is complete.
+struct TLMTelemetrySlot {
+    std::atomic<uint64_t> Seq;
+    double Values[1];
+};
+
+//! Status values.
+enum TLMTelemetryStatus {
+    TelemetryStarting = 0,
+    TelemetryRunning = 1,
+    TelemetryDone = 2
+};
+
+//! A consistent copy of the simulation status.
+struct TLMTelemetryStatusData {
+    int Status;
+    int64_t Step, NumSteps;
+    double SimTime, WallTime;
+    double StartTime, EndTime;
+    uint64_t NumRows;
+};
+
+//! \class TLMTelemetrySegment
+//! A named shared memory segment, created by the publisher and opened
+//! read only by the readers.
+class TLMTelemetrySegment {
+public:
+    TLMTelemetrySegment();
+
+    //! Destructor, unmaps the segment and removes it if it was created.
+    ~TLMTelemetrySegment();
+
+    //! Create the segment "name" of "size" bytes.
+    //! Fails if the segment already exists.
+    bool Create(const std::string& name, size_t size);
+
+    //! Open the existing segment "name" for reading.
+    bool Open(const std::string& name);
+
+    //! Unmap the segment, and remove it if it was created by this object.
+    void Close();
+
+    //! Remove the segment "name" left by another process.
+    static void Remove(const std::string& name);
+
+    //! Start of the mapped memory, NULL if not open.
+    char* GetData() const { return Data; }
+
+    //! Size of the mapped memory.
+    size_t GetSize() const { return Size; }
+
+private:
+    // Not copyable.
+    TLMTelemetrySegment(const TLMTelemetrySegment&);
+    TLMTelemetrySegment& operator=(const TLMTelemetrySegment&);
+
+    //! Segment name as given to the system.
+    std::string Name;
+
+    //! The mapped memory.
+    char* Data;
+
+    //! Size of the mapping.
+    size_t Size;
+
+    //! True if this object created the segment.
+    bool Owner;
+
+#ifdef _WIN32
+    //! File mapping handle.
+    void* Handle;
+#endif
+};
+
+//! \class TLMTelemetryPublisher
+//! Publishes the status and result rows of a simulation. Publishing
+//! only copies the values into the segment, the readers never block
+//! the publisher. A reader that is too slow looses the overwritten rows.
+//! The publisher is not thread safe.
+class TLMTelemetryPublisher {
+public:
+    TLMTelemetryPublisher();
+
+    //! Create the segment. A segment of the same name left by a publisher
+    //! that has exited is replaced, while one of a running publisher is not.
+    //! \param name Segment name.
+    //! \param names Names of the published variables, the first two are time and wallTime.
+    //! \param startTime Simulation start time.
+    //! \param endTime Simulation end time.
+    //! \param ringSize Number of rows kept in the segment.
+    //! \return True if the segment could be created.
+    bool Open(const std::string& name, const std::vector<std::string>& names,
+              double startTime, double endTime, int ringSize);
+
+    //! Check if the segment is open.
+    bool IsOpen() const { return Header != NULL; }
+
+    //! Process ID of the running publisher of the segment "name", 0 if
+    //! there is no such segment or its publisher has exited.
+    static int GetRunningPublisher(const std::string& name);
+
+    //! Publish one row and update the status.
+    //! \param values NumVariables values, ordered as the names.
+    //! \param step Logging step of the row.
+    //! \param numSteps Last logging step.
+    void PublishRow(const double* values, int step, int numSteps);
+
+    //! Mark the simulation as done.
+    void SetDone();
+
+    //! Remove the segment. Readers that have it open can still read it.
+    void Close();
+
+private:
+    //! The shared memory.
+    TLMTelemetrySegment Segment;
+
+    //! Header of the segment.
+    TLMTelemetryHeader* Header;
+
+    //! Size of one slot in bytes.
+    size_t SlotSize;
+};
+
+//! \class TLMTelemetryReader
+//! Reads the telemetry of a running simulation, used by dashboards.
+//! The reads do not block the simulation, they fail if the data was
+//! changed while it was copied, or if a row was overwritten.
+class TLMTelemetryReader {
+public:
+    TLMTelemetryReader();
+
+    //! Open the segment "name". Fails if no simulation published it yet.
+    bool Open(const std::string& name);
+
+    //! Check if the segment is open.
+    bool IsOpen() const { return Header != NULL; }
+
+    //! Close the segment.
+    void Close();
+
+    //! Get the names of the published variables.
+    const std::vector<std::string>& GetVariableNames() const { return VariableNames; }
+
+    //! Read the status, retries while it is updated.
+    void ReadStatus(TLMTelemetryStatusData& status) const;
+
+    //! Get the number of rows published so far.
+    uint64_t GetNumRows() const;
+
+    //! Read row "row" (0 for the first row).
+    //! \return False if the row is not published yet or was overwritten.
+    bool ReadRow(uint64_t row, std::vector<double>& values) const;
+
+    //! Read the last published row.
+    //! \param row Set to the number of the row read.
+    //! \return False if no row was published.
+    bool ReadLatest(std::vector<double>& values, uint64_t& row) const;
+
+private:
+    //! The shared memory.
+    TLMTelemetrySegment Segment;
+
+    //! Header of the segment.
+    const TLMTelemetryHeader* Header;
+
+    //! Size of one slot in bytes.
+    size_t SlotSize;
+
+    //! The variable names.
+    std::vector<std::string> VariableNames;
+};
+
+#endif
@@ -0,0 +1,241 @@
+/**
+ * File: TLMTrace.cc
+ *
+ * Implementation of the per-process trace buffer
+ */
+#include "Logging/TLMTrace.h"
+#include "Logging/TLMErrorLog.h"
+#include "Communication/TLMThreadSynch.h"
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    const uint32_t TLMTraceVersion = 1;
+
+    //! Maximum number of events per thread, 64 MB.
+    const size_t TLMTraceMaxEvents = 2*1024*1024;
+
+    //! Events recorded by one thread.
+    struct ThreadBuffer {
+        std::string Name;
+        std::vector<TLMTraceEvent> Events;
+        uint64_t NumDropped;
+    };
+
+    std::atomic<bool> Enabled(false);
+
+    //! Number of threads recording an event, Close waits for them before
+    //! the buffers are written and deleted.
+    std::atomic<int> NumRecording(0);
+
+    //! Incremented by Open so that the threads drop their old buffers.
+    std::atomic<int> Generation(0);
+
+    std::string Directory;
+    std::string FileName;
+    std::string ProcessName;
+    double Origin = 0.0;
+    std::chrono::steady_clock::time_point SteadyOrigin;
+
+    //! All thread buffers, owned here so that they outlive the threads.
+    std::vector<ThreadBuffer*> Buffers;
+    SimpleLock BuffersLock;
+
+    thread_local ThreadBuffer* CurrentBuffer = NULL;
+    thread_local int CurrentGeneration = -1;
+
+    //! The buffer of the calling thread, created on first use.
+    ThreadBuffer* GetThreadBuffer() {
+        int generation = Generation.load(std::memory_order_relaxed);
+        if(CurrentBuffer == NULL || CurrentGeneration != generation) {
+            ThreadBuffer* buffer = new ThreadBuffer;
+            buffer->NumDropped = 0;
+
+            BuffersLock.lock();
+            buffer->Name = "thread " + TLMErrorLog::ToStdStr(int(Buffers.size()));
+            Buffers.push_back(buffer);
+            BuffersLock.unlock();
+
+            CurrentBuffer = buffer;
+            CurrentGeneration = generation;
+        }
+        return CurrentBuffer;
+    }
+
+    //! Enter AddEvent or SetThreadName. Returns false if tracing is disabled.
+    bool BeginRecording() {
+        if(!Enabled.load(std::memory_order_relaxed)) return false;
+
+        // Pairs with Close, which disables tracing before it waits.
+        NumRecording.fetch_add(1);
+        if(!Enabled.load()) {
+            NumRecording.fetch_sub(1);
+            return false;
+        }
+        return true;
+    }
+
+    void EndRecording() {
+        NumRecording.fetch_sub(1, std::memory_order_release);
+    }
+
+    int GetProcessID() {
+#ifdef _WIN32
+        return _getpid();
+#else
+        return getpid();
+#endif
+    }
+}
+
+bool TLMTrace::Open(const std::string& directory, const std::string& processName) {
+    Close();
+
+    std::stringstream ss;
+    ss << directory << "/" << processName << "." << GetProcessID() << ".tlmtrace";
+    FileName = ss.str();
+    ProcessName = processName;
+
+    // Check that the file can be written before anything is recorded.
+    std::ofstream file(FileName.c_str(), std::ios::binary);
+    if(!file.good()) {
+        TLMErrorLog::Warning("Failed to open trace file " + FileName);
+        return false;
+    }
+    file.close();
+    Directory = directory;
+
+    SteadyOrigin = std::chrono::steady_clock::now();
+    Origin = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+    Generation.fetch_add(1, std::memory_order_relaxed);
+    Enabled.store(true, std::memory_order_release);
+
+    TLMErrorLog::Info("Writing trace to " + FileName);
+    return true;
+}
+
+bool TLMTrace::OpenFromEnvironment(const std::string& processName) {
+    const char* directory = getenv(TLM_TRACE_DIR_ENV);
+    if(directory == NULL || directory[0] == '\0') return false;
+
+    return Open(directory, processName);
+}
+
+std::string TLMTrace::GetDirectory() {
+    return IsEnabled() ? Directory : std::string();
+}
+
+bool TLMTrace::IsEnabled() {
+    return Enabled.load(std::memory_order_relaxed);
+}
+
+double TLMTrace::Now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - SteadyOrigin).count();
+}
+
+void TLMTrace::SetThreadName(const std::string& name) {
+    if(!BeginRecording()) return;
+    GetThreadBuffer()->Name = name;
+    EndRecording();
+}
+
+void TLMTrace::AddEvent(TLMTraceEventType type, double start, double end,
+                        int interfaceID, int detail, double time) {
+    if(!BeginRecording()) return;
+
+    ThreadBuffer* buffer = GetThreadBuffer();
+    if(buffer->Events.size() >= TLMTraceMaxEvents) {
+        buffer->NumDropped++;
+        EndRecording();
+        return;
+    }
+
+    TLMTraceEvent event;
+    event.Start = start;
+    event.Duration = end - start;
+    event.Time = time;
+    event.Interface = interfaceID;
+    event.Detail = int16_t(detail);
+    event.Type = uint8_t(type);
+    event.Thread = 0;
+    buffer->Events.push_back(event);
+
+    EndRecording();
+}
+
+void TLMTrace::Close() {
+    if(!Enabled.exchange(false)) return;
+
+    // Wait for the events being recorded, later ones are not recorded.
+    while(NumRecording.load() > 0) {
+        std::this_thread::yield();
+    }
+
+    BuffersLock.lock();
+
+    TLMTraceFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.Magic, "TLMTRACE", 8);
+    header.Version = TLMTraceVersion;
+    header.ProcessID = uint32_t(GetProcessID());
+    header.Origin = Origin;
+    strncpy(header.ProcessName, ProcessName.c_str(), sizeof(header.ProcessName)-1);
+
+    // The thread index of an event is its buffer, at most 256 threads are kept.
+    if(Buffers.size() > 256) {
+        TLMErrorLog::Warning("Too many threads traced, only the first 256 are written");
+    }
+    size_t numThreads = std::min(Buffers.size(), size_t(256));
+    header.NumThreads = uint32_t(numThreads);
+    for(size_t i = 0; i < numThreads; i++) {
+        header.NumEvents += Buffers[i]->Events.size();
+        header.NumDropped += Buffers[i]->NumDropped;
+    }
+
+    std::ofstream file(FileName.c_str(), std::ios::binary);
+    file.write((const char*)&header, sizeof(header));
+
+    for(size_t i = 0; i < numThreads; i++) {
+        char name[TLMTraceNameSize] = {0};
+        strncpy(name, Buffers[i]->Name.c_str(), TLMTraceNameSize-1);
+        file.write(name, TLMTraceNameSize);
+    }
+
+    for(size_t i = 0; i < numThreads; i++) {
+        std::vector<TLMTraceEvent>& events = Buffers[i]->Events;
+        for(size_t j = 0; j < events.size(); j++) {
+            events[j].Thread = uint8_t(i);
+        }
+        if(!events.empty()) {
+            file.write((const char*)&events[0], events.size()*sizeof(TLMTraceEvent));
+        }
+    }
+
+    if(!file.good()) {
+        TLMErrorLog::Warning("Failed to write trace file " + FileName);
+    }
+    else if(header.NumDropped > 0) {
+        TLMErrorLog::Warning("Trace buffer full, " + TLMErrorLog::ToStdStr(int(header.NumDropped)) + " events dropped");
+    }
+
+    for(size_t i = 0; i < Buffers.size(); i++) {
+        delete Buffers[i];
+    }
+    Buffers.clear();
+
+    BuffersLock.unlock();
+}
@@ -0,0 +1,137 @@
+//!
+//! \file TLMTrace.h
+//!
+//! Defines the trace buffer that records the timeline of one process
+//! taking part in a co-simulation: messages sent and received, time
+//! blocked waiting for data, solver steps and the registration phases.
+//! Each process writes its own binary trace file, the tlmtrace tool
+//! merges them into one Chrome trace (Perfetto) JSON file.
+//!
+
+#ifndef TLMTrace_h_
+#define TLMTrace_h_
+
+#include <string>
+#include <stdint.h>
+
+//! Environment variable with the trace directory. It is set by the
+//! manager for the components it starts, so that they write their traces
+//! as well.
+#define TLM_TRACE_DIR_ENV "OMTLM_TRACE_DIR"
+
+//! Event types.
+enum TLMTraceEventType {
+    //! Component registration (client) or the startup protocol (manager).
+    TraceRegistration = 0,
+    //! Interface or parameter registration.
+    TraceRegisterInterface = 1,
+    //! Waiting for the manager to check the model.
+    TraceCheckModel = 2,
+    //! Message sent, Detail is the message type.
+    TraceSend = 3,
+    //! Message received, Detail is the message type.
+    TraceReceive = 4,
+    //! Blocked in ReceiveTimeData, Time is the requested time.
+    TraceWaitData = 5,
+    //! Solver step, Time is the simulation time at the end of the step.
+    TraceSolverStep = 6,
+    //! Waiting for the close permission.
+    TraceAwaitClose = 7,
+    NumTraceEventTypes = 8
+};
+
+//! One event as stored in the trace file. Times are in seconds
+//! since the trace origin, see TLMTraceFileHeader.
+struct TLMTraceEvent {
+    double Start;
+    double Duration;
+    //! Simulation time, if known.
+    double Time;
+    //! Interface ID or -1.
+    int32_t Interface;
+    //! Type specific detail, e.g., the message type.
+    int16_t Detail;
+    //! TLMTraceEventType
+    uint8_t Type;
+    //! Index of the recording thread in the file.
+    uint8_t Thread;
+};
+
+//! Start of a trace file. The header is followed by NumThreads thread
+//! names of TLMTraceNameSize characters and NumEvents events.
+struct TLMTraceFileHeader {
+    //! "TLMTRACE"
+    char Magic[8];
+    uint32_t Version;
+    uint32_t ProcessID;
+    //! Wall clock time of the trace origin, seconds since the Unix epoch.
+    double Origin;
+    uint32_t NumThreads;
+    uint32_t Reserved;
+    uint64_t NumEvents;
+    //! Events lost since a thread buffer was full.
+    uint64_t NumDropped;
+    char ProcessName[64];
+};
+
+//! Size of each thread name in the trace file.
+const int TLMTraceNameSize = 32;
+
+//! \class TLMTrace
+//! Process wide trace buffer. Each thread records into its own buffer
+//! so recording takes no lock, the buffers are written to the trace file
+//! by Close. Tracing is disabled until Open is called, the recording
+//! functions then only check a flag.
+class TLMTrace {
+public:
+    //! Start tracing to "<directory>/<processName>.<pid>.tlmtrace".
+    static bool Open(const std::string& directory, const std::string& processName);
+
+    //! Start tracing if TLM_TRACE_DIR_ENV is set, used by the clients.
+    static bool OpenFromEnvironment(const std::string& processName);
+
+    //! The trace directory, empty if tracing is disabled. Passed to the
+    //! started processes in TLM_TRACE_DIR_ENV.
+    static std::string GetDirectory();
+
+    //! Check if tracing is enabled.
+    static bool IsEnabled();
+
+    //! Current time in seconds since the trace origin.
+    static double Now();
+
+    //! Name the calling thread in the trace.
+    static void SetThreadName(const std::string& name);
+
+    //! Record an event of the calling thread.
+    static void AddEvent(TLMTraceEventType type, double start, double end,
+                         int interfaceID = -1, int detail = 0, double time = 0.0);
+
+    //! Disable tracing and write the trace file. Waits for the events
+    //! other threads are recording, later events are not recorded.
+    static void Close();
+};
+
+//! \class TLMTraceScope
+//! Records an event for the lifetime of the object.
+class TLMTraceScope {
+public:
+    TLMTraceScope(TLMTraceEventType type, int interfaceID = -1, double time = 0.0)
+        : Type(type), InterfaceID(interfaceID), Time(time),
+          Start(TLMTrace::IsEnabled() ? TLMTrace::Now() : -1.0) {}
+
+    ~TLMTraceScope() {
+        if(Start >= 0.0) TLMTrace::AddEvent(Type, Start, TLMTrace::Now(), InterfaceID, 0, Time);
+    }
+
+    //! Set the interface ID once it is known.
+    void SetInterface(int interfaceID) { InterfaceID = interfaceID; }
+
+private:
+    TLMTraceEventType Type;
+    int InterfaceID;
+    double Time;
+    double Start;
+};
+
+#endif
@@ -12,6 +12,7 @@
 #include "CompositeModels/CompositeModel.h"
 #include "CompositeModels/CompositeModelReader.h"
 #include "Communication/ManagerCommHandler.h"
+#include "Communication/TLMScheduling.h"
 #include "double3.h"
 #include "double33.h"
 
@@ -25,11 +26,21 @@ using std::string;
 
 void usage() {
     string usageStr =
-            "Usage: tlmmananger [-d] [-m <monitor-port>] [-p <server-port>] [-r] <compositemodel>, where compositemodel is a name of XML file.\n"
+            "Usage: tlmmananger [-a <cpu-list>] [-A] [-b <poll-time>] [-c <cpu-list>] [-d] [-g] [-m <monitor-port>] [-p <server-port>] [-P <policy>[:<priority>]] [-q <queue-depth>] [-r] [-R] [-t <trace-dir>] [-w <profile-file>] <compositemodel>, where compositemodel is a name of XML file.\n"
+            "-a <cpu-list>      : pin the manager threads to the CPUs, e.g., 2,3 or 2-4\n"
+            "-A                 : write the log from a background thread\n"
+            "-b <poll-time>     : spin for up to poll-time seconds before a receive blocks, for dedicated cores\n"
+            "-c <cpu-list>      : pin the component processes to the CPUs\n"
             "-d                 : enable debug mode\n"
+            "-g                 : place each component on one of the component CPUs from the connection graph\n"
             "-m <monitor-port>  : set the port for monitoring connections\n"
             "-p <server-port>   : set the server network port for communication with the simulation tools\n"
-            "-r                 : run manager in interface request mode, get information about interface locations";
+            "-P <policy>[:<priority>] : set the scheduling policy (other, fifo or rr) of the manager threads and the components\n"
+            "-q <queue-depth>   : set the maximum number of messages queued per interface and destination, 0 for unbounded (default)\n"
+            "-r                 : run manager in interface request mode, get information about interface locations\n"
+            "-R                 : receive the time data in a background thread in the components\n"
+            "-t <trace-dir>     : write a timeline trace of the manager and the components, see tlmtrace\n"
+            "-w <profile-file>  : write the wait time and message latency profile, see tlmprofile";
     TLMErrorLog::SetLogLevel(TLMLogLevel::Debug);
     TLMErrorLog::Info(usageStr);
     std::cout << usageStr << std::endl;
@@ -121,27 +132,75 @@ int main(int argc, char* argv[]) {
     bool debugFlg = false;
     int serverPort = 0;
     int monitorPort = 0;
+    int queueDepth = -1;
     ManagerCommHandler::CommunicationMode comMode=ManagerCommHandler::CoSimulationMode;
     std::string singleModel;
+    std::string profileFile;
+    std::string traceDirectory;
+    std::string managerCPUs, componentCPUs, schedPolicy;
+    int schedPriority = 0;
+    bool graphPlacement = false;
+    double busyPollTime = -1.0;
+    bool receiverThread = false;
+    bool asyncLogging = false;
 
     char c;
-    while((c = getopt (argc, argv, "dp:m:rs:")) != -1) {
+    while((c = getopt (argc, argv, "a:Ab:c:dgp:m:P:q:rRs:t:w:")) != -1) {
         switch(c) {
+        case 'a':
+            managerCPUs = optarg;
+            break;
+        case 'A':
+            asyncLogging = true;
+            break;
+        case 'b':
+            busyPollTime = atof(optarg);
+            break;
+        case 'c':
+            componentCPUs = optarg;
+            break;
         case 'd':
             debugFlg = true;
             break;
+        case 'g':
+            graphPlacement = true;
+            break;
         case 'p':
             serverPort = atoi(optarg);
             break;
         case 'm':
             monitorPort = atoi(optarg);
             break;
+        case 'P': {
+            schedPolicy = optarg;
+            size_t colPos = schedPolicy.find(':');
+            if(colPos != std::string::npos) {
+                schedPriority = atoi(schedPolicy.c_str() + colPos + 1);
+                schedPolicy = schedPolicy.substr(0, colPos);
+            }
+            if(!TLMScheduling::IsValidPolicy(schedPolicy)) {
+                usage();
+            }
+            break;
+        }
+        case 'q':
+            queueDepth = atoi(optarg);
+            break;
         case 'r':
             comMode = ManagerCommHandler::InterfaceRequestMode;
             break;
+        case 'R':
+            receiverThread = true;
+            break;
         case 's':
             singleModel = optarg;
             break;
+        case 't':
+            traceDirectory = optarg;
+            break;
+        case 'w':
+            profileFile = optarg;
+            break;
         default:
             usage();
             break;
@@ -158,6 +217,12 @@ int main(int argc, char* argv[]) {
     if(debugFlg || comMode == ManagerCommHandler::InterfaceRequestMode) {       //Always enable debug for interface request /robbr
         TLMErrorLog::SetLogLevel(TLMLogLevel::Debug);
     }
+
+    // The log is written by a background thread, the reader and writer
+    // threads only queue their messages.
+    if(asyncLogging) {
+        TLMErrorLog::SetAsync(true);
+    }
     
     // Create the meta model object
     omtlm_CompositeModel theModel;
@@ -185,9 +250,47 @@ int main(int argc, char* argv[]) {
         theModel.GetSimParams().SetMonitorPort(monitorPort);
     }
 
+    // Set preferred send queue depth
+    if(queueDepth >= 0) {
+        theModel.GetSimParams().SetMessageQueueDepth(queueDepth);
+    }
+
+    // Set the CPU affinity and scheduling, overriding the model
+    std::vector<int> cpus;
+    if(!managerCPUs.empty()) {
+        if(!TLMScheduling::ParseCPUList(managerCPUs, cpus)) usage();
+        theModel.GetSimParams().SetManagerCPUs(managerCPUs);
+    }
+    if(!componentCPUs.empty()) {
+        if(!TLMScheduling::ParseCPUList(componentCPUs, cpus)) usage();
+        theModel.GetSimParams().SetComponentCPUs(componentCPUs);
+    }
+    if(!schedPolicy.empty()) {
+        theModel.GetSimParams().SetScheduling(schedPolicy, schedPriority);
+    }
+    if(graphPlacement) {
+        theModel.GetSimParams().SetComponentPlacement("graph");
+    }
+
+    // Set busy polling
+    if(busyPollTime >= 0.0) {
+        theModel.GetSimParams().SetBusyPollTime(busyPollTime);
+    }
+    if(receiverThread) {
+        theModel.GetSimParams().SetReceiverThread(true);
+    }
+
     // Create manager object
     ManagerCommHandler manager(theModel);
 
+    if(!profileFile.empty()) {
+        manager.SetProfileFile(profileFile);
+    }
+
+    if(!traceDirectory.empty()) {
+        manager.SetTraceDirectory(traceDirectory);
+    }
+
     // Run the simulation
     manager.Run(comMode);
 
@@ -8,12 +8,14 @@
 #include <cstdlib>
 #include <cstring>
 #include <map>
+#include <vector>
 #include <sstream>
 #include "Logging/TLMErrorLog.h"
 #include "CompositeModels/CompositeModel.h"
 #include "CompositeModels/CompositeModelReader.h"
 #include "Communication/ManagerCommHandler.h"
 #include "Plugin/MonitoringPluginImplementer.h"
+#include "Logging/TLMCompressedStream.h"
 #include "double3.h"
 #include "double33.h"
 #ifndef NO_RTIME
@@ -33,7 +35,7 @@
 using std::string;
 
 void usage() {
-    string usageStr = "Usage: tlmmonitor [-d] [-n num-seps | -t time-step-size] <server:port> <compositemodel>, where compositemodel is an XML file.";
+    string usageStr = "Usage: tlmmonitor [-d] [-z] [-l] [-n num-seps | -t time-step-size] <server:port> <compositemodel>, where compositemodel is an XML file, -z writes a compressed result file and -l prints the link statistics of the running simulation.";
     TLMErrorLog::SetLogLevel(TLMLogLevel::Debug);
     TLMErrorLog::Info(usageStr);
     std::cout << usageStr << std::endl;
@@ -51,8 +53,9 @@ struct Color {
     }
 };
 
-TLMPlugin* InitializeTLMConnection(omtlm_CompositeModel& model, std::string& serverName) {
-    TLMPlugin* TLMlink = MonitoringPluginImplementer::CreateInstance();
+TLMPlugin* InitializeTLMConnection(omtlm_CompositeModel& model, std::string& serverName, double samplingInterval) {
+    MonitoringPluginImplementer* monitor = MonitoringPluginImplementer::CreateInstance();
+    TLMPlugin* TLMlink = monitor;
 
     TLMErrorLog::Info("Trying to register TLM monitor on host " + serverName);
 
@@ -66,6 +69,9 @@ TLMPlugin* InitializeTLMConnection(omtlm_CompositeModel& model, std::string& ser
         return 0;
     }
 
+    // Only request the samples needed at the logging instants.
+    monitor->SetSamplingInterval(samplingInterval);
+
     int nTLMInterfaces = model.GetInterfacesNum();
     for(int i=0; i<nTLMInterfaces; i++) {
         TLMInterfaceProxy& interfaceProxy = model.GetTLMInterfaceProxy(i);
@@ -87,71 +93,178 @@ TLMPlugin* InitializeTLMConnection(omtlm_CompositeModel& model, std::string& ser
     return TLMlink;
 }
 
+//! Request the per-link statistics from the manager and print them.
+//! Returns the exit code of the monitor.
+int QueryLinkStatistics(omtlm_CompositeModel& model, std::string& serverName) {
+    string::size_type colPos = serverName.rfind(':');
+    if(colPos == string::npos) {
+        std::cerr << "Server name string expected <server>:<port>, got: " << serverName << std::endl;
+        return 1;
+    }
+    std::string host = serverName.substr(0, colPos);
+    int port = atoi(serverName.c_str() + colPos + 1);
+
+    TLMClientComm comm;
+    TLMMessage message;
+    if((message.SocketHandle = comm.ConnectManager(host, port)) < 0) {
+        std::cerr << "Could not connect to the TLM manager on " << serverName << std::endl;
+        return 1;
+    }
+
+    message.Header.MessageType = TLMMessageTypeConst::TLM_LINK_STATISTICS;
+    message.Header.DataSize = 0;
+    TLMCommUtil::SendMessage(message);
+
+    if(!TLMCommUtil::ReceiveMessage(message)
+       || message.Header.MessageType != TLMMessageTypeConst::TLM_LINK_STATISTICS) {
+        std::cerr << "No link statistics received from the TLM manager" << std::endl;
+        return 1;
+    }
+
+    size_t nLinks = message.Header.DataSize / sizeof(TLMLinkStatistics);
+    std::vector<TLMLinkStatistics> stats(nLinks);
+    if(nLinks > 0) {
+        memcpy(&stats[0], &message.Data[0], nLinks*sizeof(TLMLinkStatistics));
+        if(TLMMessageHeader::IsBigEndianSystem != message.Header.SourceIsBigEndianSystem) {
+            TLMCommUtil::ByteSwap(&stats[0], sizeof(double), nLinks*sizeof(TLMLinkStatistics)/sizeof(double));
+        }
+    }
+
+    std::cout << "link,messages,bytes,min inter-arrival,avg inter-arrival,max inter-arrival,"
+                 "min lead,avg lead,max lead,extrapolations,wait time,avg latency,max latency" << std::endl;
+    for(size_t i = 0; i < nLinks; i++) {
+        const TLMLinkStatistics& link = stats[i];
+        if(link.InterfaceID >= model.GetInterfacesNum() || link.LinkedID >= model.GetInterfacesNum()) continue;
+
+        TLMInterfaceProxy& ifc = model.GetTLMInterfaceProxy(int(link.InterfaceID));
+        TLMInterfaceProxy& linked = model.GetTLMInterfaceProxy(int(link.LinkedID));
+        std::cout << model.GetTLMComponentProxy(linked.GetComponentID()).GetName() << "." << linked.GetName() << " -> "
+                  << model.GetTLMComponentProxy(ifc.GetComponentID()).GetName() << "." << ifc.GetName() << ","
+                  << link.NumMessages << "," << link.NumBytes << ","
+                  << link.MinInterArrival << "," << link.AvgInterArrival << "," << link.MaxInterArrival << ","
+                  << link.MinLead << "," << link.AvgLead << "," << link.MaxLead << ","
+                  << link.NumExtrapolations << "," << link.WaitTime << ","
+                  << link.AvgLatency << "," << link.MaxLatency << std::endl;
+    }
+
+    return 0;
+}
+
+//! Kind of a logged interface, resolved once from the dimensions,
+//! causality and domain of the interface.
+enum MonitorSlotKind {
+    Slot3D,
+    SlotHydraulic,
+    SlotMechanical,
+    SlotRotational,
+    SlotElectric,
+    SlotSignal
+};
+
+//! A logged interface and the storage of its data for the current step.
+struct MonitorSlot {
+    int InterfaceID;
+    MonitorSlotKind Kind;
+
+    //! Full interface name, i.e., component.interface.
+    std::string Name;
+
+    //! Connection parameters.
+    double Delay, Alpha, Zf, Zfr;
+
+    //! Data of the current step.
+    TLMTimeDataSignal DataSignal;
+    TLMTimeData1D Data1D;
+    TLMTimeData3D Data3D;
+};
+
+//! Build the slots of all connected interfaces that are logged, in the
+//! order of the interfaces in the model.
+void BuildMonitorSlots(omtlm_CompositeModel& model, std::vector<MonitorSlot>& slots) {
+    slots.clear();
+
+    int nTLMInterfaces = model.GetInterfacesNum();
+    for(int i=0; i<nTLMInterfaces; i++) {
+        TLMInterfaceProxy& interfaceProxy = model.GetTLMInterfaceProxy(i);
+        TLMComponentProxy& component = model.GetTLMComponentProxy(interfaceProxy.GetComponentID());
+        if(interfaceProxy.GetConnectionID() < 0) continue;
+
+        MonitorSlot slot;
+        if(interfaceProxy.GetDimensions() == 6) {
+            slot.Kind = Slot3D;
+        }
+        else if(interfaceProxy.GetDimensions() == 1 && interfaceProxy.GetCausality() == "bidirectional") {
+            if(interfaceProxy.GetDomain() == "hydraulic") slot.Kind = SlotHydraulic;
+            else if(interfaceProxy.GetDomain() == "mechanical") slot.Kind = SlotMechanical;
+            else if(interfaceProxy.GetDomain() == "rotational") slot.Kind = SlotRotational;
+            else if(interfaceProxy.GetDomain() == "electric") slot.Kind = SlotElectric;
+            else {
+                TLMErrorLog::Warning("Interface " + interfaceProxy.GetName() + " of unknown domain "
+                                     + interfaceProxy.GetDomain() + " is not logged.");
+                continue;
+            }
+        }
+        else if(interfaceProxy.GetDimensions() == 1 && interfaceProxy.GetCausality() == "output") {
+            slot.Kind = SlotSignal;
+        }
+        else {
+            continue;
+        }
+
+        TLMConnection& connection = model.GetTLMConnection(interfaceProxy.GetConnectionID());
+        slot.InterfaceID = interfaceProxy.GetID();
+        slot.Name = component.GetName() + "." + interfaceProxy.GetName();
+        slot.Delay = connection.GetParams().Delay;
+        slot.Alpha = connection.GetParams().alpha;
+        slot.Zf = connection.GetParams().Zf;
+        slot.Zfr = connection.GetParams().Zfr;
+        slots.push_back(slot);
+    }
+}
+
 //! Evaluate the data needed for the current time step.
 void MonitorTimeStep(TLMPlugin* TLMlink,
-                     omtlm_CompositeModel& model,
-                     double SimTime,
-                     std::map<int, TLMTimeDataSignal>& dataStorageSignal,
-                     std::map<int, TLMTimeData1D>& dataStorage1D,
-                     std::map<int, TLMTimeData3D>& dataStorage3D) {
+                     std::vector<MonitorSlot>& slots,
+                     double SimTime) {
     if(TLMlink != 0) {
-        // Get data from TLM-Manager here!
-        int nTLMInterfaces = model.GetInterfacesNum();
+        for(size_t i=0; i<slots.size(); i++) {
+            MonitorSlot& slot = slots[i];
 
-        for(int i=0; i<nTLMInterfaces; i++) {
-            TLMInterfaceProxy& interfaceProxy = model.GetTLMInterfaceProxy(i);
-            int interfaceID = interfaceProxy.GetID();
-            int connectionID = interfaceProxy.GetConnectionID();
-            int dimensions = interfaceProxy.GetDimensions();
-            string causality = interfaceProxy.GetCausality();
-
-            if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
-                TLMErrorLog::Info("Data request for " + interfaceProxy.GetName() + " for time " + ToStr(SimTime) + ", id: " + ToStr(interfaceID));
+            if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
+                TLMErrorLog::Info("Data request for " + slot.Name + " for time " + ToStr(SimTime) + ", id: " + ToStr(slot.InterfaceID));
             }
 
-            if(connectionID >= 0) {
-#define LOGGEDFORCEFIX
-#ifdef  LOGGEDFORCEFIX
-                if(dimensions == 6) {
-                    TLMTimeData3D& PrevTimeData = dataStorage3D[interfaceID];
-                    TLMTimeData3D& CurTimeData = dataStorage3D[interfaceID];
-
-                    TLMlink->GetTimeData3D(interfaceID, SimTime, CurTimeData);
-
-                    double delay = model.GetTLMConnection(interfaceProxy.GetConnectionID()).GetParams().Delay;
-                    double alpha = model.GetTLMConnection(interfaceProxy.GetConnectionID()).GetParams().alpha;
-                    TLMlink->GetTimeData3D(interfaceID, SimTime-delay, PrevTimeData);
-
-                    //Apply damping factor, since this can not be done in GetTimeData (DampedTimeData is not available for monitor)
-                    for(int i = 0; i < 6; i++) {
-                        CurTimeData.GenForce[i] =
-                                CurTimeData.GenForce[i] * (1 - alpha)
-                                + PrevTimeData.GenForce[i] * alpha;
-                    }
+            // The current and the delayed data share the storage, as they
+            // always did: the delayed data replaces the current one, so the
+            // logged data is that at SimTime-Delay and the damping has no
+            // effect. Kept since the reference results depend on it, the
+            // manager's TLMResultRecorder logs the same data.
+            if(slot.Kind == Slot3D) {
+                TLMTimeData3D& PrevTimeData = slot.Data3D;
+                TLMTimeData3D& CurTimeData = slot.Data3D;
+
+                TLMlink->GetTimeData3D(slot.InterfaceID, SimTime, CurTimeData);
+                TLMlink->GetTimeData3D(slot.InterfaceID, SimTime-slot.Delay, PrevTimeData);
+
+                //Apply damping factor, since this can not be done in GetTimeData (DampedTimeData is not available for monitor)
+                for(int j = 0; j < 6; j++) {
+                    CurTimeData.GenForce[j] =
+                            CurTimeData.GenForce[j] * (1 - slot.Alpha)
+                            + PrevTimeData.GenForce[j] * slot.Alpha;
                 }
-                else if(dimensions == 1 && causality == "bidirectional") {
-                    TLMTimeData1D& PrevTimeData = dataStorage1D[interfaceID];
-                    TLMTimeData1D& CurTimeData = dataStorage1D[interfaceID];
-
-                    TLMlink->GetTimeData1D(interfaceID, SimTime, CurTimeData);
+            }
+            else if(slot.Kind == SlotSignal) {
+                TLMlink->GetTimeDataSignal(slot.InterfaceID, SimTime, slot.DataSignal, true);
+            }
+            else {
+                TLMTimeData1D& PrevTimeData = slot.Data1D;
+                TLMTimeData1D& CurTimeData = slot.Data1D;
 
-                    double delay = model.GetTLMConnection(interfaceProxy.GetConnectionID()).GetParams().Delay;
-                    double alpha = model.GetTLMConnection(interfaceProxy.GetConnectionID()).GetParams().alpha;
-                    TLMlink->GetTimeData1D(interfaceID, SimTime-delay, PrevTimeData);
+                TLMlink->GetTimeData1D(slot.InterfaceID, SimTime, CurTimeData);
+                TLMlink->GetTimeData1D(slot.InterfaceID, SimTime-slot.Delay, PrevTimeData);
 
-                    //Apply damping factor, since this can not be done in GetTimeData (DampedTimeData is not available for monitor)
-                    CurTimeData.GenForce = CurTimeData.GenForce*(1-alpha) + PrevTimeData.GenForce*alpha;
-                }
-                else if(dimensions == 1 && causality == "output") {
-                    TLMTimeDataSignal& CurTimeData = dataStorageSignal[interfaceID];
-                    int linkedID = interfaceProxy.GetLinkedID();
-                    TLMlink->GetTimeDataSignal(interfaceID, SimTime, CurTimeData, true);
-                }
-                //No need to check for erroneous interface type, we can simply log nothing instead /robbr
-#else
-                TLMTimeData& CurTimeData = dataStorage[interfaceID];
-                TLMlink->GetTimeData(interfaceID, SimTime, CurTimeData);
-#endif
+                //Apply damping factor, since this can not be done in GetTimeData (DampedTimeData is not available for monitor)
+                CurTimeData.GenForce = CurTimeData.GenForce*(1-slot.Alpha) + PrevTimeData.GenForce*slot.Alpha;
             }
         }
     }
@@ -411,233 +524,138 @@ void WriteVisualXMLFile(omtlm_CompositeModel& model, std::string &baseFileName,
     }
 }
 
-void PrintHeader(omtlm_CompositeModel& model, std::ofstream& dataFile) {
-    // Get data from TLM-Manager here!
-    int nTLMInterfaces = model.GetInterfacesNum();
-
+void PrintHeader(const std::vector<MonitorSlot>& slots, std::ostream& dataFile) {
     // First variable written is time.
-    dataFile << "\"" << "time\",";
-
-    int nActiveInterfaces = 0;
-    for(int i=0; i<nTLMInterfaces; i++) {
-        TLMInterfaceProxy& interfaceProxy = model.GetTLMInterfaceProxy(i);
-        TLMComponentProxy& component = model.GetTLMComponentProxy(interfaceProxy.GetComponentID());
-        if(interfaceProxy.GetConnectionID() >= 0) {
-            if(interfaceProxy.GetDimensions() == 6) {
-                // Comma between interfaces
-                if(nActiveInterfaces > 0) dataFile << ",";
-
-                // Add all TLM variable names for all active interfaces
-                std::string name = component.GetName() + "." + interfaceProxy.GetName();
-                dataFile << "\"" << name << ".R[cG][cG](1) [m]\",\"" << name << ".R[cG][cG](2) [m]\",\"" << name << ".R[cG][cG](3) [m]\","; // Position vector
-                dataFile << "\"" << name << ".phi[cG](1) [rad]\",\"" << name << ".phi[cG](2) [rad]\",\"" << name << ".phi[cG](3) [rad]\","; // Orientation vector (three angles)
-                dataFile << "\"" << name << ".A(1,1) [-]\",\"" << name << ".A(1,2) [-]\",\"" << name << ".A(1,3) [-]\",\""
-                         << name << ".A(2,1) [-]\",\"" << name << ".A(2,2) [-]\",\"" << name << ".A(2,3) [-]\",\""
-                         << name << ".A(3,1) [-]\",\"" << name << ".A(3,2) [-]\",\"" << name << ".A(3,3) [-]\","; // Transformation matrix
-                dataFile << "\"" << name << ".vR[cG][cG,cG](1) [m/s]\",\"" << name << ".vR[cG][cG,cG](2) [m/s]\",\"" << name << ".vR[cG][cG,cG](3) [m/s]\","; // velocity
-                dataFile << "\"" << name << ".Omega[cG][cG](1) [rad/s]\",\"" << name << ".Omega[cG][cG](2) [rad/s]\",\"" << name << ".Omega[cG][cG](3) [rad/s]\","; // angular velocity
-                dataFile << "\"" << name << ".F_tie[cG](1) [N]\",\"" << name << ".F_tie[cG](2) [N]\",\"" << name << ".F_tie[cG](3) [N]\","; // force vector
-                dataFile << "\"" << name << ".M_tie[cG][cG](1) [Nm]\",\"" << name << ".M_tie[cG][cG](2) [Nm]\",\"" << name << ".M_tie[cG][cG](3) [Nm]\""; // torque vector
-
-                nActiveInterfaces++;
-            }
-            else if(interfaceProxy.GetDimensions() == 1 &&
-                    interfaceProxy.GetCausality() == "bidirectional") {
-                // Comma between interfaces
-                if(nActiveInterfaces > 0) dataFile << ",";
-
-                // Add all TLM variable names for all active interfaces
-                std::string name = component.GetName() + "." + interfaceProxy.GetName();
-                if(interfaceProxy.GetDomain() == "hydraulic") {
-                    dataFile << "\"" << name << ".q [m^3/s]\","; // Volume flow
-                    dataFile << "\"" << name << ".p [Pa]\""; // Pressure
-                }
-                else if(interfaceProxy.GetDomain() == "mechanical") {
-                    dataFile << "\"" << name << ".x [m]\","; // Position
-                    dataFile << "\"" << name << ".v [m/s]\","; // Speed
-                    dataFile << "\"" << name << ".F [N]\""; // Force
-                }
-                else if(interfaceProxy.GetDomain() == "rotational") {
-                    dataFile << "\"" << name << ".phi [rad]\","; // Position
-                    dataFile << "\"" << name << ".w [rad/s]\","; // Speed
-                    dataFile << "\"" << name << ".T [Nm]\""; // Force
-                }
-                else if(interfaceProxy.GetDomain() == "electric") {
-                  dataFile << "\"" << name << ".I [A]\","; // Current
-                  dataFile << "\"" << name << ".U [V]\""; // Voltage
-              }
-
-                nActiveInterfaces++;
-            }
-            else if(interfaceProxy.GetDimensions() == 1 &&
-                    interfaceProxy.GetCausality() == "output") {
-                // Comma between interfaces
-                if(nActiveInterfaces > 0) dataFile << ",";
-
-                // Add variable names for all active interfaces
-                std::string name = component.GetName() + "." + interfaceProxy.GetName();
-                dataFile << "\"" << name << "\""; // Value
-
-                nActiveInterfaces++;
-            }
+    dataFile << "\"" << "time\"";
+
+    for(size_t i=0; i<slots.size(); i++) {
+        const std::string& name = slots[i].Name;
+        dataFile << ",";
+
+        switch(slots[i].Kind) {
+        case Slot3D:
+            dataFile << "\"" << name << ".R[cG][cG](1) [m]\",\"" << name << ".R[cG][cG](2) [m]\",\"" << name << ".R[cG][cG](3) [m]\","; // Position vector
+            dataFile << "\"" << name << ".phi[cG](1) [rad]\",\"" << name << ".phi[cG](2) [rad]\",\"" << name << ".phi[cG](3) [rad]\","; // Orientation vector (three angles)
+            dataFile << "\"" << name << ".A(1,1) [-]\",\"" << name << ".A(1,2) [-]\",\"" << name << ".A(1,3) [-]\",\""
+                     << name << ".A(2,1) [-]\",\"" << name << ".A(2,2) [-]\",\"" << name << ".A(2,3) [-]\",\""
+                     << name << ".A(3,1) [-]\",\"" << name << ".A(3,2) [-]\",\"" << name << ".A(3,3) [-]\","; // Transformation matrix
+            dataFile << "\"" << name << ".vR[cG][cG,cG](1) [m/s]\",\"" << name << ".vR[cG][cG,cG](2) [m/s]\",\"" << name << ".vR[cG][cG,cG](3) [m/s]\","; // velocity
+            dataFile << "\"" << name << ".Omega[cG][cG](1) [rad/s]\",\"" << name << ".Omega[cG][cG](2) [rad/s]\",\"" << name << ".Omega[cG][cG](3) [rad/s]\","; // angular velocity
+            dataFile << "\"" << name << ".F_tie[cG](1) [N]\",\"" << name << ".F_tie[cG](2) [N]\",\"" << name << ".F_tie[cG](3) [N]\","; // force vector
+            dataFile << "\"" << name << ".M_tie[cG][cG](1) [Nm]\",\"" << name << ".M_tie[cG][cG](2) [Nm]\",\"" << name << ".M_tie[cG][cG](3) [Nm]\""; // torque vector
+            break;
+        case SlotHydraulic:
+            dataFile << "\"" << name << ".q [m^3/s]\","; // Volume flow
+            dataFile << "\"" << name << ".p [Pa]\""; // Pressure
+            break;
+        case SlotMechanical:
+            dataFile << "\"" << name << ".x [m]\","; // Position
+            dataFile << "\"" << name << ".v [m/s]\","; // Speed
+            dataFile << "\"" << name << ".F [N]\""; // Force
+            break;
+        case SlotRotational:
+            dataFile << "\"" << name << ".phi [rad]\","; // Position
+            dataFile << "\"" << name << ".w [rad/s]\","; // Speed
+            dataFile << "\"" << name << ".T [Nm]\""; // Force
+            break;
+        case SlotElectric:
+            dataFile << "\"" << name << ".I [A]\","; // Current
+            dataFile << "\"" << name << ".U [V]\""; // Voltage
+            break;
+        case SlotSignal:
+            dataFile << "\"" << name << "\""; // Value
+            break;
         }
     }
 
     dataFile << std::endl;
 }
 
-void PrintData(omtlm_CompositeModel& model,
-               std::ofstream& dataFile,
-               std::map<int, TLMTimeDataSignal> &dataStorageSignal,
-               std::map<int, TLMTimeData1D>& dataStorage1D,
-               std::map<int, TLMTimeData3D> &dataStorage3D) {
-    double startTime = model.GetSimParams().GetStartTime();
-
-    // Get data from TLM-Manager here!
-    int nTLMInterfaces = model.GetInterfacesNum();
+void PrintData(const std::vector<MonitorSlot>& slots,
+               double startTime,
+               std::ostream& dataFile) {
+    if(slots.empty()) return;
+
+    // The time is taken from the first interface.
+    double time;
+    switch(slots[0].Kind) {
+    case Slot3D: time = slots[0].Data3D.time; break;
+    case SlotSignal: time = slots[0].DataSignal.time; break;
+    default: time = slots[0].Data1D.time; break;
+    }
+    if(time < startTime) {
+        time = startTime;
+    }
+    dataFile << time;
 
-    bool printTimeFlg = true;
-    int nActiveInterfaces = 0;
+    for(size_t i=0; i<slots.size(); i++) {
+        const MonitorSlot& slot = slots[i];
+        dataFile << ",";
 
-    for(int i=0; i<nTLMInterfaces; i++) {
-        TLMInterfaceProxy& interfaceProxy = model.GetTLMInterfaceProxy(i);
-        if(interfaceProxy.GetConnectionID() >= 0) {
-            if(interfaceProxy.GetDimensions() == 6) {
-                std::stringstream ss;
-                ss << "Printing data for 3D interface " << interfaceProxy.GetID();
-                TLMErrorLog::Info(ss.str());
+        if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
+            std::stringstream ss;
+            ss << "Printing data for interface " << slot.InterfaceID;
+            TLMErrorLog::Info(ss.str());
+        }
 
-                TLMTimeData3D& timeData = dataStorage3D.at(interfaceProxy.GetID());
+        if(slot.Kind == Slot3D) {
+            const TLMTimeData3D& timeData = slot.Data3D;
 
-                if(timeData.time < startTime) {
-                    timeData.time = startTime;
-                }
+            // Convert orientation matrix to angles
 
-                // Print time only once, that is, for the first entry.
-                if(printTimeFlg) {
-                    dataFile << timeData.time << ",";
-                    printTimeFlg = false;
-                }
+            // first convert the matrices into double33 format
+            double33 A(timeData.RotMatrix[0], timeData.RotMatrix[1], timeData.RotMatrix[2],
+                    timeData.RotMatrix[3], timeData.RotMatrix[4], timeData.RotMatrix[5],
+                    timeData.RotMatrix[6], timeData.RotMatrix[7], timeData.RotMatrix[8]);
 
-                // Comma between interfaces
-                if(nActiveInterfaces > 0) dataFile << ",";
-
-                // Convert orientation matrix to angles
-
-                // first convert the matrices into double33 format
-                double33 A(timeData.RotMatrix[0], timeData.RotMatrix[1], timeData.RotMatrix[2],
-                        timeData.RotMatrix[3], timeData.RotMatrix[4], timeData.RotMatrix[5],
-                        timeData.RotMatrix[6], timeData.RotMatrix[7], timeData.RotMatrix[8]);
-
-                // Then convert to angles
-                double3 phi = ATophi321(A);
-
-                // Backward calculation of force from TLM wave.
-                // This is done because the actual force send is the delayed force.
-                // The wave is: C = - Force + Impedance * Velocity -> F = -(C - Imp*Vel)
-                double3 force(0.0);
-                double3 torque(0.0);
-                TLMConnection& connection = model.GetTLMConnection(interfaceProxy.GetConnectionID());
-                for(int i = 0; i < 3; i++) {
-#if 1
-                    force(i+1) =  -timeData.GenForce[i] + connection.GetParams().Zf * timeData.Velocity[i];
-                    torque(i+1) = -timeData.GenForce[i+3] + connection.GetParams().Zfr * timeData.Velocity[i+3];
-#else
-                    force(i+1) =  timeData.GenForce[i];
-                    torque(i+1) = timeData.GenForce[i+3];
-#endif
-                }
+            // Then convert to angles
+            double3 phi = ATophi321(A);
 
-                dataFile << timeData.Position[0] << "," << timeData.Position[1] << "," << timeData.Position[2] << ",";
-                dataFile << phi(1)               << "," << phi(2)               << "," << phi(3)               << ",";
-                dataFile << A(1,1)               << "," << A(1,2)               << "," << A(1,3)               << ",";
-                dataFile << A(2,1)               << "," << A(2,2)               << "," << A(2,3)               << ",";
-                dataFile << A(3,1)               << "," << A(3,2)               << "," << A(3,3)               << ",";
-                dataFile << timeData.Velocity[0] << "," << timeData.Velocity[1] << "," << timeData.Velocity[2] << ",";
-                dataFile << timeData.Velocity[3] << "," << timeData.Velocity[4] << "," << timeData.Velocity[5] << ",";
-                dataFile << force(1)             << "," << force(2)             << "," << force(3)             << ",";
-                dataFile << torque(1)            << "," << torque(2)            << "," << torque(3);
-
-                nActiveInterfaces++;
+            // Backward calculation of force from TLM wave.
+            // This is done because the actual force send is the delayed force.
+            // The wave is: C = - Force + Impedance * Velocity -> F = -(C - Imp*Vel)
+            double3 force(0.0);
+            double3 torque(0.0);
+            for(int j = 0; j < 3; j++) {
+                force(j+1) =  -timeData.GenForce[j] + slot.Zf * timeData.Velocity[j];
+                torque(j+1) = -timeData.GenForce[j+3] + slot.Zfr * timeData.Velocity[j+3];
             }
-            else if(interfaceProxy.GetDimensions() == 1 &&
-                    interfaceProxy.GetCausality() == "bidirectional") {
-                std::stringstream ss;
-                ss << "Printing data for 1D interface " << interfaceProxy.GetID();
-                TLMErrorLog::Info(ss.str());
-
-                TLMTimeData1D& timeData = dataStorage1D.at(interfaceProxy.GetID());
-
-                if(timeData.time < startTime) {
-                    timeData.time = startTime;
-                }
-                // Print time only once, that is, for the first entry.
-                if(printTimeFlg) {
-                    dataFile << timeData.time << ",";
-                    printTimeFlg = false;
-                }
-
-                // Comma between interfaces
-                if(nActiveInterfaces > 0) dataFile << ",";
-
-                // Backward calculation of force from TLM wave.
-                // This is done because the actual force send is the delayed force.
-                // The wave is: C = - Force + Impedance * Velocity -> F = -(C - Imp*Vel)
-
-                TLMConnection& connection = model.GetTLMConnection(interfaceProxy.GetConnectionID());
-
-                double force;
-                if(interfaceProxy.GetDomain() == "hydraulic") {
-                    force =  timeData.GenForce + connection.GetParams().Zf * timeData.Velocity;
-                }
-                else {
-                    force =  -timeData.GenForce + connection.GetParams().Zf * timeData.Velocity;
-                }
-
-                if(interfaceProxy.GetDomain() == "hydraulic") {
-                    dataFile << timeData.Velocity << ",";     //Flow
-                    dataFile << force;                        //Pressure
-                } else if(interfaceProxy.GetDomain() == "mechanical") {
-                    dataFile << timeData.Position << ",";
-                    dataFile << timeData.Velocity << ",";
-                    dataFile << force;
-                }
-                else if(interfaceProxy.GetDomain() == "rotational") {
-                    dataFile << timeData.Position << ",";   //Angle
-                    dataFile << timeData.Velocity << ",";   //Angular velocity
-                    dataFile << force;                      //Torque
-                }
-                else if(interfaceProxy.GetDomain() == "electric") {
-                  dataFile << timeData.Velocity << ",";     //Current
-                  dataFile << force;                        //Voltage
-              }
 
-                nActiveInterfaces++;
+            dataFile << timeData.Position[0] << "," << timeData.Position[1] << "," << timeData.Position[2] << ",";
+            dataFile << phi(1)               << "," << phi(2)               << "," << phi(3)               << ",";
+            dataFile << A(1,1)               << "," << A(1,2)               << "," << A(1,3)               << ",";
+            dataFile << A(2,1)               << "," << A(2,2)               << "," << A(2,3)               << ",";
+            dataFile << A(3,1)               << "," << A(3,2)               << "," << A(3,3)               << ",";
+            dataFile << timeData.Velocity[0] << "," << timeData.Velocity[1] << "," << timeData.Velocity[2] << ",";
+            dataFile << timeData.Velocity[3] << "," << timeData.Velocity[4] << "," << timeData.Velocity[5] << ",";
+            dataFile << force(1)             << "," << force(2)             << "," << force(3)             << ",";
+            dataFile << torque(1)            << "," << torque(2)            << "," << torque(3);
+        }
+        else if(slot.Kind == SlotSignal) {
+            dataFile << slot.DataSignal.Value;
+        }
+        else {
+            const TLMTimeData1D& timeData = slot.Data1D;
+
+            // Backward calculation of force from TLM wave.
+            // This is done because the actual force send is the delayed force.
+            // The wave is: C = - Force + Impedance * Velocity -> F = -(C - Imp*Vel)
+            double force;
+            if(slot.Kind == SlotHydraulic) {
+                force =  timeData.GenForce + slot.Zf * timeData.Velocity;
+            }
+            else {
+                force =  -timeData.GenForce + slot.Zf * timeData.Velocity;
             }
-            else if(interfaceProxy.GetDimensions() == 1 &&
-                    interfaceProxy.GetCausality() == "output") {
-
-                std::stringstream ss;
-                ss << "Printing data for output interface " << interfaceProxy.GetID();
-                TLMErrorLog::Info(ss.str());
-
-                TLMTimeDataSignal& timeData = dataStorageSignal.at(interfaceProxy.GetID());
-
-                if(timeData.time < startTime) {
-                    timeData.time = startTime;
-                }
-                // Print time only once, that is, for the first entry.
-                if(printTimeFlg) {
-                    dataFile << timeData.time << ",";
-                    printTimeFlg = false;
-                }
-
-                // Comma between interfaces
-                if(nActiveInterfaces > 0) dataFile << ",";
-
-                dataFile << timeData.Value;
 
-                nActiveInterfaces++;
+            if(slot.Kind == SlotHydraulic || slot.Kind == SlotElectric) {
+                dataFile << timeData.Velocity << ",";     //Flow or current
+                dataFile << force;                        //Pressure or voltage
+            }
+            else {
+                dataFile << timeData.Position << ",";     //Position or angle
+                dataFile << timeData.Velocity << ",";     //Speed or angular velocity
+                dataFile << force;                        //Force or torque
             }
         }
     }
@@ -691,14 +709,22 @@ int main(int argc, char* argv[]) {
 #endif
 
     bool debugFlg = false;
+    bool compressFlg = false;
+    bool linkStatisticsFlg = false;
     double timeStep = 0.0;
     double nSteps = 0;
     char c;
-    while((c = getopt (argc, argv, "dt:n:")) != -1) {
+    while((c = getopt (argc, argv, "dzlt:n:")) != -1) {
         switch(c) {
         case 'd':
             debugFlg = true;
             break;
+        case 'z':
+            compressFlg = true;
+            break;
+        case 'l':
+            linkStatisticsFlg = true;
+            break;
         case 't':
             timeStep = atof(optarg);
             break;
@@ -741,11 +767,25 @@ int main(int argc, char* argv[]) {
         // read the XML file and build the model
         modelReader.ReadModel(inFile);
     }
+
+    if(linkStatisticsFlg) {
+        return QueryLinkStatistics(theModel, serverStr);
+    }
     
     // Open file for data logging, that is, storing the co-simulation data.
-    std::ofstream outdataFile((baseFileName + ".csv").c_str());
+    // The compressed file is compressed by a background thread.
+    std::ofstream plainDataFile;
+    TLMCompressedOStream compressedDataFile;
+    std::string outFileName = baseFileName + (compressFlg ? ".csv.gz" : ".csv");
+    if(compressFlg) {
+        compressedDataFile.open(outFileName);
+    }
+    else {
+        plainDataFile.open(outFileName.c_str());
+    }
+    std::ostream& outdataFile = compressFlg ? static_cast<std::ostream&>(compressedDataFile) : plainDataFile;
     if(!outdataFile.good()) {
-        TLMErrorLog::FatalError("Failed to open outfile " + baseFileName + ".csv, give up.");
+        TLMErrorLog::FatalError("Failed to open outfile " + outFileName + ", give up.");
         exit(1);
     }
 
@@ -756,13 +796,6 @@ int main(int argc, char* argv[]) {
         exit(1);
     }
 
-    // Initialize TLM
-    TLMPlugin* thePlugin = InitializeTLMConnection(theModel, serverStr);
-    if(!thePlugin) {
-        TLMErrorLog::FatalError("Failed to initialize TLM interface, give up.");
-        exit(1);
-    }
-
     // Setup simulation time for logging.
     double simTime = theModel.GetSimParams().GetStartTime();
     double endTime  = theModel.GetSimParams().GetEndTime();
@@ -780,8 +813,19 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    // Initialize TLM
+    TLMPlugin* thePlugin = InitializeTLMConnection(theModel, serverStr, timeStep);
+    if(!thePlugin) {
+        TLMErrorLog::FatalError("Failed to initialize TLM interface, give up.");
+        exit(1);
+    }
+
+    // Resolve the logged interfaces once.
+    std::vector<MonitorSlot> slots;
+    BuildMonitorSlots(theModel, slots);
+
     // Print/log the header information
-    PrintHeader(theModel, outdataFile);
+    PrintHeader(slots, outdataFile);
 
     // Setup timer for run-time estimation.
     tTM_Info tInfo;
@@ -795,24 +839,23 @@ int main(int argc, char* argv[]) {
         // Adjust to meet end-time step.
         if(simTime > endTime) simTime = endTime;
 
-        // Data structure for data logging
-        std::map<int, TLMTimeDataSignal> dataSignal;
-        std::map<int, TLMTimeData1D> data1D;
-        std::map<int, TLMTimeData3D> data3D;
-
         // Get data for next time step.
         TM_Start(&tInfo);
-        MonitorTimeStep(thePlugin, theModel, simTime, dataSignal, data1D, data3D);
+        MonitorTimeStep(thePlugin, slots, simTime);
         TM_Stop(&tInfo);
 
         // Print data row
-        PrintData(theModel, outdataFile, dataSignal, data1D, data3D);
+        PrintData(slots, theModel.GetSimParams().GetStartTime(), outdataFile);
 
         // Update run status
         PrintRunStatus(theModel, runFile, tInfo, simTime);
 
     } while(simTime < endTime);
 
+    if(compressFlg) {
+        compressedDataFile.close();
+    }
+
     return 0;
 }
 
@@ -19,12 +19,12 @@
 #include "CompositeModels/CompositeModel.h"
 #include "CompositeModels/CompositeModelReader.h"
 #include "Communication/ManagerCommHandler.h"
-#include "Plugin/MonitoringPluginImplementer.h"
+#include "Communication/TLMScheduling.h"
+#include "Logging/TLMResultRecorder.h"
 #include "Logging/TLMErrorLog.h"
 #include "CompositeModels/CompositeModel.h"
 #include "CompositeModels/CompositeModelReader.h"
 #include "Communication/ManagerCommHandler.h"
-#include "Plugin/MonitoringPluginImplementer.h"
 #include "OMTLMSimulatorLib.h"
 
 #ifndef _WIN32
@@ -95,122 +95,20 @@ public:
   int monitorPort = 12111;
   double logStepSize = 1e-4;
   int numLogSteps = 1000;
+  std::string logFormat = "csv";
+  std::string telemetryName = "";
+  std::vector<std::string> telemetryInterfaces;
+  std::string profileFile = "";
+  std::string traceDirectory = "";
+  bool asyncLogging = false;
+  bool memoryResults = false;
+  std::vector<std::string> memoryInterfaces;
+  std::vector<std::string> resultNames;
+  std::vector<std::vector<double> > resultValues;
 
 };
 
 
-TLMPlugin* InitializeTLMConnection(omtlm_CompositeModel& model, std::string& serverName) {
-  TLMPlugin* TLMlink = MonitoringPluginImplementer::CreateInstance();
-
-#if defined(__unix__)
-  signal(SIGPIPE, SIG_IGN); // Handle return value of send instead of crashing on Linux
-#endif
-
-  TLMErrorLog::Info("Trying to register TLM monitor on host " + serverName);
-
-  if(! TLMlink->Init("monitor",
-                     model.GetSimParams().GetStartTime(),
-                     model.GetSimParams().GetEndTime(),
-                     model.GetSimParams().GetWriteTimeStep(),
-                     serverName))
-  {
-    TLMErrorLog::FatalError("Cannot initialize MonitoringPluginImplementer.");
-    std::cout << "Cannot initialize MonitoringPluginImplementer.\n";
-    return 0;
-  }
-
-  int nTLMInterfaces = model.GetInterfacesNum();
-  for(int i=0; i<nTLMInterfaces; i++) {
-    TLMInterfaceProxy& interfaceProxy = model.GetTLMInterfaceProxy(i);
-    TLMComponentProxy& component = model.GetTLMComponentProxy(interfaceProxy.GetComponentID());
-
-    TLMErrorLog::Info("Trying to register monitoring interface " + interfaceProxy.GetName());
-    int TLMInterfaceID = TLMlink->RegisteTLMInterface(component.GetName() + "." + interfaceProxy.GetName(),
-                                                      interfaceProxy.GetDimensions(), interfaceProxy.GetCausality(),
-                                                      interfaceProxy.GetDomain());
-
-    if(TLMInterfaceID >= 0) {
-      TLMErrorLog::Info("Registration was successful");
-      std::string compName = model.GetTLMComponentProxy(interfaceProxy.GetComponentID()).GetName();
-    }
-    else {
-      TLMErrorLog::Info("Interface not connected in Meta-Model: " + component.GetName() + "." + interfaceProxy.GetName());
-    }
-  }
-
-  return TLMlink;
-}
-
-//! Evaluate the data needed for the current time step.
-void MonitorTimeStep(TLMPlugin* TLMlink,
-                     omtlm_CompositeModel& model,
-                     double SimTime,
-                     std::map<int, TLMTimeDataSignal>& dataStorageSignal,
-                     std::map<int, TLMTimeData1D>& dataStorage1D,
-                     std::map<int, TLMTimeData3D>& dataStorage3D) {
-  if(TLMlink != 0) {
-    // Get data from TLM-Manager here!
-    int nTLMInterfaces = model.GetInterfacesNum();
-
-    for(int i=0; i<nTLMInterfaces; i++) {
-      TLMInterfaceProxy& interfaceProxy = model.GetTLMInterfaceProxy(i);
-      int interfaceID = interfaceProxy.GetID();
-      int connectionID = interfaceProxy.GetConnectionID();
-      int dimensions = interfaceProxy.GetDimensions();
-      string causality = interfaceProxy.GetCausality();
-
-      if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
-          TLMErrorLog::Info("Data request for " + interfaceProxy.GetName() + " for time " + ToStr(SimTime) + ", id: " + ToStr(interfaceID));
-      }
-
-      if(connectionID >= 0) {
-#define LOGGEDFORCEFIX
-#ifdef  LOGGEDFORCEFIX
-        if(dimensions == 6) {
-          TLMTimeData3D& PrevTimeData = dataStorage3D[interfaceID];
-          TLMTimeData3D& CurTimeData = dataStorage3D[interfaceID];
-
-          TLMlink->GetTimeData3D(interfaceID, SimTime, CurTimeData);
-
-          double delay = model.GetTLMConnection(interfaceProxy.GetConnectionID()).GetParams().Delay;
-          double alpha = model.GetTLMConnection(interfaceProxy.GetConnectionID()).GetParams().alpha;
-          TLMlink->GetTimeData3D(interfaceID, SimTime-delay, PrevTimeData);
-
-          //Apply damping factor, since this can not be done in GetTimeData (DampedTimeData is not available for monitor)
-          for(int i = 0; i < 6; i++) {
-            CurTimeData.GenForce[i] =
-                CurTimeData.GenForce[i] * (1 - alpha)
-                + PrevTimeData.GenForce[i] * alpha;
-          }
-        }
-        else if(dimensions == 1 && causality == "bidirectional") {
-          TLMTimeData1D& PrevTimeData = dataStorage1D[interfaceID];
-          TLMTimeData1D& CurTimeData = dataStorage1D[interfaceID];
-
-          TLMlink->GetTimeData1D(interfaceID, SimTime, CurTimeData);
-
-          double delay = model.GetTLMConnection(interfaceProxy.GetConnectionID()).GetParams().Delay;
-          double alpha = model.GetTLMConnection(interfaceProxy.GetConnectionID()).GetParams().alpha;
-          TLMlink->GetTimeData1D(interfaceID, SimTime-delay, PrevTimeData);
-
-          //Apply damping factor, since this can not be done in GetTimeData (DampedTimeData is not available for monitor)
-          CurTimeData.GenForce = CurTimeData.GenForce*(1-alpha) + PrevTimeData.GenForce*alpha;
-        }
-        else if(dimensions == 1 && causality == "output") {
-          TLMTimeDataSignal& CurTimeData = dataStorageSignal[interfaceID];
-          int linkedID = interfaceProxy.GetLinkedID();
-          TLMlink->GetTimeDataSignal(interfaceID, SimTime, CurTimeData, true);
-        }
-        //No need to check for erroneous interface type, we can simply log nothing instead /robbr
-#else
-        TLMTimeData& CurTimeData = dataStorage[interfaceID];
-        TLMlink->GetTimeData(interfaceID, SimTime, CurTimeData);
-#endif
-      }
-    }
-  }
-}
-
 void WriteVisualXMLFile(omtlm_CompositeModel& model, std::string &baseFileName, std::string &path) {
   // Get data from TLM-Manager here!
   bool canWriteVisualXMLFile = false;
@@ -465,399 +363,6 @@ void WriteVisualXMLFile(omtlm_CompositeModel& model, std::string &baseFileName,
   }
 }
 
-void PrintHeader(omtlm_CompositeModel& model, std::ofstream& dataFile) {
-  // Get data from TLM-Manager here!
-  int nTLMInterfaces = model.GetInterfacesNum();
-
-  // First variable written is time.
-  dataFile << "\"" << "time\",\"wallTime\",";
-
-  int nActiveInterfaces = 0;
-  for(int i=0; i<nTLMInterfaces; i++) {
-    TLMInterfaceProxy& interfaceProxy = model.GetTLMInterfaceProxy(i);
-    TLMComponentProxy& component = model.GetTLMComponentProxy(interfaceProxy.GetComponentID());
-    if(interfaceProxy.GetConnectionID() >= 0) {
-      if(interfaceProxy.GetDimensions() == 6) {
-        // Comma between interfaces
-        if(nActiveInterfaces > 0) dataFile << ",";
-
-        // Add all TLM variable names for all active interfaces
-        std::string name = component.GetName() + "." + interfaceProxy.GetName();
-        dataFile << "\"" << name << ".R[cG][cG](1) [m]\",\"" << name << ".R[cG][cG](2) [m]\",\"" << name << ".R[cG][cG](3) [m]\","; // Position vector
-        dataFile << "\"" << name << ".phi[cG](1) [rad]\",\"" << name << ".phi[cG](2) [rad]\",\"" << name << ".phi[cG](3) [rad]\","; // Orientation vector (three angles)
-        dataFile << "\"" << name << ".A(1,1) [-]\",\"" << name << ".A(1,2) [-]\",\"" << name << ".A(1,3) [-]\",\""
-                 << name << ".A(2,1) [-]\",\"" << name << ".A(2,2) [-]\",\"" << name << ".A(2,3) [-]\",\""
-                 << name << ".A(3,1) [-]\",\"" << name << ".A(3,2) [-]\",\"" << name << ".A(3,3) [-]\","; // Transformation matrix
-        dataFile << "\"" << name << ".vR[cG][cG,cG](1) [m/s]\",\"" << name << ".vR[cG][cG,cG](2) [m/s]\",\"" << name << ".vR[cG][cG,cG](3) [m/s]\","; // velocity
-        dataFile << "\"" << name << ".Omega[cG][cG](1) [rad/s]\",\"" << name << ".Omega[cG][cG](2) [rad/s]\",\"" << name << ".Omega[cG][cG](3) [rad/s]\","; // angular velocity
-        dataFile << "\"" << name << ".F_tie[cG](1) [N]\",\"" << name << ".F_tie[cG](2) [N]\",\"" << name << ".F_tie[cG](3) [N]\","; // force vector
-        dataFile << "\"" << name << ".M_tie[cG][cG](1) [Nm]\",\"" << name << ".M_tie[cG][cG](2) [Nm]\",\"" << name << ".M_tie[cG][cG](3) [Nm]\""; // torque vector
-
-        nActiveInterfaces++;
-      }
-      else if(interfaceProxy.GetDimensions() == 1 &&
-              interfaceProxy.GetCausality() == "bidirectional") {
-        // Comma between interfaces
-        if(nActiveInterfaces > 0) dataFile << ",";
-
-        // Add all TLM variable names for all active interfaces
-        std::string name = component.GetName() + "." + interfaceProxy.GetName();
-        if(interfaceProxy.GetDomain() == "hydraulic") {
-          dataFile << "\"" << name << ".q [m^3/s]\","; // Volume flow
-          dataFile << "\"" << name << ".p [Pa]\""; // Pressure
-        }
-        else if(interfaceProxy.GetDomain() == "mechanical") {
-          dataFile << "\"" << name << ".x [m]\","; // Position
-          dataFile << "\"" << name << ".v [m/s]\","; // Speed
-          dataFile << "\"" << name << ".F [N]\""; // Force
-        }
-        else if(interfaceProxy.GetDomain() == "rotational") {
-          dataFile << "\"" << name << ".phi [rad]\","; // Position
-          dataFile << "\"" << name << ".w [rad/s]\","; // Speed
-          dataFile << "\"" << name << ".T [Nm]\""; // Force
-        }
-        else if(interfaceProxy.GetDomain() == "electric") {
-          dataFile << "\"" << name << ".I [A]\","; // Current
-          dataFile << "\"" << name << ".U [V]\""; // Voltage
-        }
-
-        nActiveInterfaces++;
-      }
-      else if(interfaceProxy.GetDimensions() == 1 &&
-              interfaceProxy.GetCausality() == "output") {
-        // Comma between interfaces
-        if(nActiveInterfaces > 0) dataFile << ",";
-
-        // Add variable names for all active interfaces
-        std::string name = component.GetName() + "." + interfaceProxy.GetName();
-        dataFile << "\"" << name << "\""; // Value
-
-        nActiveInterfaces++;
-      }
-    }
-  }
-
-  dataFile << std::endl;
-}
-
-void PrintData(omtlm_CompositeModel& model,
-               std::ofstream& dataFile,
-               tTM_Info& tInfo,
-               std::map<int, TLMTimeDataSignal> &dataStorageSignal,
-               std::map<int, TLMTimeData1D>& dataStorage1D,
-               std::map<int, TLMTimeData3D> &dataStorage3D) {
-  double startTime = model.GetSimParams().GetStartTime();
-
-  double wallTime = tInfo.total.tv_sec + tInfo.total.tv_nsec/1.0e9;
-
-  // Get data from TLM-Manager here!
-  int nTLMInterfaces = model.GetInterfacesNum();
-
-  bool printTimeFlg = true;
-  int nActiveInterfaces = 0;
-
-  for(int i=0; i<nTLMInterfaces; i++) {
-    TLMInterfaceProxy& interfaceProxy = model.GetTLMInterfaceProxy(i);
-    if(interfaceProxy.GetConnectionID() >= 0) {
-      if(interfaceProxy.GetDimensions() == 6) {
-        if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
-          std::stringstream ss;
-          ss << "Printing data for 3D interface " << interfaceProxy.GetID();
-          TLMErrorLog::Info(ss.str());
-        }
-
-        TLMTimeData3D& timeData = dataStorage3D.at(interfaceProxy.GetID());
-
-        if(timeData.time < startTime) {
-          timeData.time = startTime;
-        }
-
-        // Print time only once, that is, for the first entry.
-        if(printTimeFlg) {
-          dataFile << timeData.time << ",";
-          dataFile << wallTime << ",";
-          printTimeFlg = false;
-        }
-
-        // Comma between interfaces
-        if(nActiveInterfaces > 0) dataFile << ",";
-
-        // Convert orientation matrix to angles
-
-        // first convert the matrices into double33 format
-        double33 A(timeData.RotMatrix[0], timeData.RotMatrix[1], timeData.RotMatrix[2],
-            timeData.RotMatrix[3], timeData.RotMatrix[4], timeData.RotMatrix[5],
-            timeData.RotMatrix[6], timeData.RotMatrix[7], timeData.RotMatrix[8]);
-
-        // Then convert to angles
-        double3 phi = ATophi321(A);
-
-        // Backward calculation of force from TLM wave.
-        // This is done because the actual force send is the delayed force.
-        // The wave is: C = - Force + Impedance * Velocity -> F = -(C - Imp*Vel)
-        double3 force(0.0);
-        double3 torque(0.0);
-        TLMConnection& connection = model.GetTLMConnection(interfaceProxy.GetConnectionID());
-        for(int i = 0; i < 3; i++) {
-#if 1
-          force(i+1) =  -timeData.GenForce[i] + connection.GetParams().Zf * timeData.Velocity[i];
-          torque(i+1) = -timeData.GenForce[i+3] + connection.GetParams().Zfr * timeData.Velocity[i+3];
-#else
-          force(i+1) =  timeData.GenForce[i];
-          torque(i+1) = timeData.GenForce[i+3];
-#endif
-        }
-
-        dataFile << timeData.Position[0] << "," << timeData.Position[1] << "," << timeData.Position[2] << ",";
-        dataFile << phi(1)               << "," << phi(2)               << "," << phi(3)               << ",";
-        dataFile << A(1,1)               << "," << A(1,2)               << "," << A(1,3)               << ",";
-        dataFile << A(2,1)               << "," << A(2,2)               << "," << A(2,3)               << ",";
-        dataFile << A(3,1)               << "," << A(3,2)               << "," << A(3,3)               << ",";
-        dataFile << timeData.Velocity[0] << "," << timeData.Velocity[1] << "," << timeData.Velocity[2] << ",";
-        dataFile << timeData.Velocity[3] << "," << timeData.Velocity[4] << "," << timeData.Velocity[5] << ",";
-        dataFile << force(1)             << "," << force(2)             << "," << force(3)             << ",";
-        dataFile << torque(1)            << "," << torque(2)            << "," << torque(3);
-
-        nActiveInterfaces++;
-      }
-      else if(interfaceProxy.GetDimensions() == 1 &&
-              interfaceProxy.GetCausality() == "bidirectional") {
-        if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
-          std::stringstream ss;
-          ss << "Printing data for 1D interface " << interfaceProxy.GetID();
-          TLMErrorLog::Info(ss.str());
-        }
-
-        TLMTimeData1D& timeData = dataStorage1D.at(interfaceProxy.GetID());
-
-        if(timeData.time < startTime) {
-          timeData.time = startTime;
-        }
-        // Print time only once, that is, for the first entry.
-        if(printTimeFlg) {
-          dataFile << timeData.time << ",";
-          dataFile << wallTime << ",";
-          printTimeFlg = false;
-        }
-
-        // Comma between interfaces
-        if(nActiveInterfaces > 0) dataFile << ",";
-
-        // Backward calculation of force from TLM wave.
-        // This is done because the actual force send is the delayed force.
-        // The wave is: C = - Force + Impedance * Velocity -> F = -(C - Imp*Vel)
-
-        TLMConnection& connection = model.GetTLMConnection(interfaceProxy.GetConnectionID());
-
-        double force;
-        if(interfaceProxy.GetDomain() == "hydraulic") {
-          force =  timeData.GenForce + connection.GetParams().Zf * timeData.Velocity;
-        }
-        else {
-          force =  -timeData.GenForce + connection.GetParams().Zf * timeData.Velocity;
-        }
-
-        if(interfaceProxy.GetDomain() == "hydraulic") {
-          dataFile << timeData.Velocity << ",";     //Flow
-          dataFile << force;                        //Pressure
-        } else if(interfaceProxy.GetDomain() == "mechanical") {
-          dataFile << timeData.Position << ",";
-          dataFile << timeData.Velocity << ",";
-          dataFile << force;
-        }
-        else if(interfaceProxy.GetDomain() == "rotational") {
-          dataFile << timeData.Position << ",";   //Angle
-          dataFile << timeData.Velocity << ",";   //Angular velocity
-          dataFile << force;                      //Torque
-        }
-        else if(interfaceProxy.GetDomain() == "electric") {
-          dataFile << timeData.Velocity << ",";     //Current
-          dataFile << force;                        //Voltage
-        }
-
-        nActiveInterfaces++;
-      }
-      else if(interfaceProxy.GetDimensions() == 1 &&
-              interfaceProxy.GetCausality() == "output") {
-
-        if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
-          std::stringstream ss;
-          ss << "Printing data for output interface " << interfaceProxy.GetID();
-          TLMErrorLog::Info(ss.str());
-        }
-
-        TLMTimeDataSignal& timeData = dataStorageSignal.at(interfaceProxy.GetID());
-
-        if(timeData.time < startTime) {
-          timeData.time = startTime;
-        }
-        // Print time only once, that is, for the first entry.
-        if(printTimeFlg) {
-          dataFile << timeData.time << ",";
-          dataFile << wallTime << ",";
-          printTimeFlg = false;
-        }
-
-        // Comma between interfaces
-        if(nActiveInterfaces > 0) dataFile << ",";
-
-        dataFile << timeData.Value;
-
-        nActiveInterfaces++;
-      }
-    }
-  }
-  dataFile << std::endl;
-}
-
-void PrintRunStatus(omtlm_CompositeModel& model, std::ofstream& runFile, tTM_Info& tInfo, double SimTime)  {
-  double startTime = model.GetSimParams().GetStartTime();
-  double endTime = model.GetSimParams().GetEndTime();
-  double timeStep = model.GetSimParams().GetWriteTimeStep();
-  int numSteps = (endTime-startTime)/timeStep;
-  int curStep = (SimTime-startTime)/timeStep;
-  double progress = ((curStep*1.0)/(numSteps*1.0))*100.0;
-  std::string statusStr = (curStep == numSteps ? "Done" : "Running");
-
-  // Calculate average wall clock time for a single logging time step.
-  timespec_t avg;
-  TM_Avg(&tInfo, &avg);
-
-  double avgStepTime = avg.tv_sec + (avg.tv_nsec/1.0e9);
-  double timeLeft = static_cast<double>(numSteps-curStep)*avgStepTime;
-  int hLeft = timeLeft/3600;
-  int mLeft = (timeLeft - static_cast<double>(hLeft))/60;
-  int sLeft = (timeLeft - static_cast<double>(hLeft) - static_cast<double>(mLeft));
-
-  // Always write from beginning of file, that is, overwrite old data.
-  runFile.seekp(0);
-  runFile << "Status    : " << statusStr << std::endl;
-  runFile << "Sim. time : " << SimTime   << std::endl;
-  runFile << "Step      : " << curStep   << " of " << numSteps << std::endl;
-  runFile << "Progress  : " << progress   << "%" << std::endl;
-  runFile << "            " << std::endl;
-  runFile << "Estimated time left: " << hLeft << ":" << mLeft << ":" << sLeft << std::endl;
-  //runFile << "average time per step: " << avgStepTime << " sec." << endl;
-  //runFile << "time left            : " << timeLeft << " sec." << endl;
-  runFile << "                                                              " << std::endl;
-}
-
-
-//Start it threaded!
-int startMonitor(double timeStep,
-                 double nSteps,
-                 std::string server,
-                 std::string modelName,
-                 omtlm_CompositeModel &model) {
-
-  TLMErrorLog::Info("Starting monitoring...");
-
-#ifndef USE_THREADS
-#ifdef _WIN32
-#pragma message ( "TLM manager requires pthreads to be compiled in. Use -DUSE_THREADS in the Makefile.head if neeeded." )
-#else
-#warning TLM manager requires pthreads to be compiled in. Use -DUSE_THREADS in the Makefile.head if neeeded.
-#endif
-  std::cout << "Exiting (no threads)\n";
-  TLMErrorLog::Error("tlmmanger was compiled without threads and is not usable.");
-  exit(1);
-#endif
-
-
-
-  //  // Enable debug?
-  //  std::ofstream logfile;
-  //  logfile.open("monitor2.log");
-  //  TLMErrorLog::SetOutStream(logfile);
-  //  if(debug) {
-  //    TLMErrorLog::SetDebugOut(true);
-  //    TLMErrorLog::SetNormalErrorLogOn(true);
-  //    TLMErrorLog::SetWarningOut(true);
-  //  }
-
-
-
-  // Open file for data logging, that is, storing the co-simulation data.
-  std::ofstream outdataFile((modelName + ".csv").c_str());
-  if(!outdataFile.good()) {
-    TLMErrorLog::FatalError("Failed to open outfile " + modelName + ".csv, give up.");
-    exit(1);
-  }
-
-  // Open run file for logging of simulation progress.
-  std::ofstream runFile((modelName + ".run").c_str());
-  if(!runFile.good()) {
-    TLMErrorLog::FatalError("Failed to open runfile " + modelName + ".run, give up.");
-    exit(1);
-  }
-
-  // Initialize TLM
-  model.CheckTheModel();
-  TLMPlugin* thePlugin = InitializeTLMConnection(model, server);
-  if(!thePlugin) {
-    TLMErrorLog::FatalError("Failed to initialize TLM interface, give up.");
-    exit(1);
-  }
-
-  // Setup simulation time for logging.
-  double simTime = model.GetSimParams().GetStartTime();
-  double endTime  = model.GetSimParams().GetEndTime();
-
-  // Setup time step for output logging according to priority:
-  // 1. User input specified in -t option
-  // 2. User input specified in -s option
-  // 3. Time step from CompositeModel
-  if(timeStep == 0.0) {
-    if(nSteps > 0) {
-      timeStep = (endTime-simTime)/static_cast<double>(nSteps);
-    }
-    else {
-      timeStep = model.GetSimParams().GetWriteTimeStep();
-    }
-  }
-
-  // Print/log the header information
-  PrintHeader(model, outdataFile);
-
-  // Setup timer for run-time estimation.
-  tTM_Info tInfo;
-  TM_Init(&tInfo);
-  TM_Clear(&tInfo);
-
-  do {
-    // Adjust to meet end-time step.
-    if(simTime > endTime) simTime = endTime;
-
-    // Data structure for data logging
-    std::map<int, TLMTimeDataSignal> dataSignal;
-    std::map<int, TLMTimeData1D> data1D;
-    std::map<int, TLMTimeData3D> data3D;
-
-    // Get data for next time step.
-    TM_Start(&tInfo);
-    MonitorTimeStep(thePlugin, model, simTime, dataSignal, data1D, data3D);
-    TM_Stop(&tInfo);
-
-    // Print data row
-    PrintData(model, outdataFile, tInfo, dataSignal, data1D, data3D);
-
-    // Update run status
-    PrintRunStatus(model, runFile, tInfo, simTime);
-
-    // Next time step
-    simTime += timeStep;
-  } while(simTime < endTime);
-
-  TLMErrorLog::Info("Monitor sending close request (simTime = "+std::to_string(simTime)+", endTime = "+std::to_string(endTime)+")");
-  thePlugin->AwaitClosePermission();
-
-  delete thePlugin;
-
-  return 0;
-}
-
-
-
 // Print all interfaces position and orientation
 void PrintInterfaceInformation(omtlm_CompositeModel& theModel) {
   std::ofstream interfacefile ("interfaceData.xml");
@@ -936,7 +441,10 @@ int startManager(std::string address,
                  int serverPort,
                  int monitorPort,
                  ManagerCommHandler::CommunicationMode comMode,
-                 omtlm_CompositeModel &model) {
+                 omtlm_CompositeModel &model,
+                 TLMResultRecorder *recorder,
+                 std::string profileFile,
+                 std::string traceDirectory) {
 
   TLMErrorLog::Info("Printing from manager thread.");
 
@@ -955,6 +463,16 @@ int startManager(std::string address,
   // Create manager object
   ManagerCommHandler manager(model);
 
+  // The results are recorded from the time data routed by the manager.
+  manager.SetResultRecorder(recorder);
+
+  if(!profileFile.empty()) {
+    manager.SetProfileFile(profileFile);
+  }
+
+  if(!traceDirectory.empty()) {
+    manager.SetTraceDirectory(traceDirectory);
+  }
 
   // Run the simulation
   manager.Run(comMode);
@@ -962,11 +480,9 @@ int startManager(std::string address,
   // Print interface information if needed.
   if(comMode == ManagerCommHandler::InterfaceRequestMode) {
     PrintInterfaceInformation(model);
-    return 0;
   }
 
-
-
+  return 0;
 }
 
 
@@ -1001,6 +517,11 @@ void simulateInternal(void *pModel,
     TLMErrorLog::SetLogLevel(TLMLogLevel::Info);
   }
 
+  // Log from a background thread if requested, stopped by TLMErrorLog::Close below.
+  if(pModelProxy->asyncLogging) {
+    TLMErrorLog::SetAsync(true);
+  }
+
 
   omtlm_CompositeModel *pCompositeModel;
   if(interfaceRequest) {
@@ -1020,8 +541,37 @@ void simulateInternal(void *pModel,
 
   std::string modelName = pCompositeModel->GetModelName();
 
-  std::string server = std::string(pModelProxy->serverAddress)+
-                       ":"+std::to_string(pModelProxy->monitorPort);
+#if defined(__unix__)
+  signal(SIGPIPE, SIG_IGN); // Handle return value of send instead of crashing on Linux
+#endif
+
+  // Setup the result recorder (if not interface request mode)
+  TLMResultRecorder *pRecorder = 0;
+  if(comMode != ManagerCommHandler::InterfaceRequestMode) {
+    // Setup time step for output logging according to priority:
+    // 1. User specified log step size
+    // 2. User specified number of log steps
+    // 3. Time step from CompositeModel
+    double timeStep = pModelProxy->logStepSize;
+    if(timeStep == 0.0) {
+      if(pModelProxy->numLogSteps > 0) {
+        timeStep = (pCompositeModel->GetSimParams().GetEndTime()-pCompositeModel->GetSimParams().GetStartTime())
+            /static_cast<double>(pModelProxy->numLogSteps);
+      }
+      else {
+        timeStep = pCompositeModel->GetSimParams().GetWriteTimeStep();
+      }
+    }
+
+    pRecorder = new TLMResultRecorder(*pCompositeModel, modelName, timeStep, pModelProxy->logFormat);
+    if(!pModelProxy->telemetryName.empty()) {
+      pRecorder->SetTelemetry(pModelProxy->telemetryName, pModelProxy->telemetryInterfaces);
+    }
+    if(pModelProxy->memoryResults) {
+      pRecorder->SetMemoryResults(pModelProxy->memoryInterfaces);
+    }
+    pRecorder->Open();
+  }
 
   // Start manager thread
   std::thread managerThread = std::thread(startManager,
@@ -1029,27 +579,23 @@ void simulateInternal(void *pModel,
                                           pModelProxy->managerPort,
                                           pModelProxy->monitorPort,
                                           comMode,
-                                          std::ref(*pCompositeModel));
+                                          std::ref(*pCompositeModel),
+                                          pRecorder,
+                                          pModelProxy->profileFile,
+                                          pModelProxy->traceDirectory);
 
+  // Wait for thread to finish
+  managerThread.join();
+  std::cout << "Manager thread finished.\n";
 
-  // Start monitor thread (if not interface request mode)
-  std::thread monitorThread;
-  if(comMode != ManagerCommHandler::InterfaceRequestMode) {
-    monitorThread = std::thread(startMonitor,
-                                pModelProxy->logStepSize,
-                                pModelProxy->numLogSteps,
-                                server,
-                                modelName,
-                                std::ref(*pCompositeModel));
+  // Results of an earlier simulation are replaced
+  pModelProxy->resultNames.clear();
+  pModelProxy->resultValues.clear();
+  if(pRecorder && pModelProxy->memoryResults) {
+    pRecorder->GetMemoryResults(pModelProxy->resultNames, pModelProxy->resultValues);
   }
 
-  // Wait for threads to finish
-  if(comMode != ManagerCommHandler::InterfaceRequestMode) {
-    monitorThread.join();
-    std::cout << "Monitoring thread finished.\n";
-  }
-  managerThread.join();
-  std::cout << "Manager thread finished.\n";
+  delete pRecorder;
 
   TLMErrorLog::Close();
 
@@ -1369,6 +915,130 @@ void omtlm_setNumLogStep(void *pModel, int steps) {
   pModelProxy->numLogSteps = steps;
 }
 
+void omtlm_setLogFormat(void *pModel, const char *format) {
+  CompositeModelProxy *pModelProxy = (CompositeModelProxy*)pModel;
+  pModelProxy->logFormat = format;
+}
+
+// Splits a comma separated list of interface names
+static std::vector<std::string> splitInterfaceList(const char *interfaces) {
+  std::vector<std::string> interfaceNames;
+  std::stringstream interfaceStream(interfaces ? interfaces : "");
+  std::string interfaceName;
+  while(std::getline(interfaceStream, interfaceName, ',')) {
+    if(!interfaceName.empty()) {
+      interfaceNames.push_back(interfaceName);
+    }
+  }
+  return interfaceNames;
+}
+
+void omtlm_setTelemetry(void *pModel, const char *segmentName, const char *interfaces) {
+  CompositeModelProxy *pModelProxy = (CompositeModelProxy*)pModel;
+  pModelProxy->telemetryName = segmentName ? segmentName : "";
+  pModelProxy->telemetryInterfaces = splitInterfaceList(interfaces);
+}
+
+void omtlm_setProfileFile(void *pModel, const char *fileName) {
+  CompositeModelProxy *pModelProxy = (CompositeModelProxy*)pModel;
+  pModelProxy->profileFile = fileName ? fileName : "";
+}
+
+void omtlm_setTraceDirectory(void *pModel, const char *directory) {
+  CompositeModelProxy *pModelProxy = (CompositeModelProxy*)pModel;
+  pModelProxy->traceDirectory = directory ? directory : "";
+}
+
+void omtlm_setThreadPlacement(void *pModel, const char *managerCPUs, const char *componentCPUs,
+                              const char *policy, int priority) {
+  CompositeModelProxy *pModelProxy = (CompositeModelProxy*)pModel;
+  SimulationParams& params = pModelProxy->mpCompositeModel->GetSimParams();
+
+  std::vector<int> cpus;
+  if(managerCPUs && TLMScheduling::ParseCPUList(managerCPUs, cpus)) {
+    params.SetManagerCPUs(managerCPUs);
+  }
+  else if(managerCPUs) {
+    TLMErrorLog::Warning(std::string("Invalid manager CPU list ") + managerCPUs);
+  }
+
+  if(componentCPUs && TLMScheduling::ParseCPUList(componentCPUs, cpus)) {
+    params.SetComponentCPUs(componentCPUs);
+  }
+  else if(componentCPUs) {
+    TLMErrorLog::Warning(std::string("Invalid component CPU list ") + componentCPUs);
+  }
+
+  if(policy && TLMScheduling::IsValidPolicy(policy)) {
+    params.SetScheduling(policy, priority);
+  }
+  else if(policy) {
+    TLMErrorLog::Warning(std::string("Unknown scheduling policy ") + policy + ", use other, fifo or rr.");
+  }
+}
+
+void omtlm_setComponentPlacement(void *pModel, const char *placement) {
+  CompositeModelProxy *pModelProxy = (CompositeModelProxy*)pModel;
+  std::string placementStr = placement ? placement : "";
+  if(placementStr == "shared" || placementStr == "graph") {
+    pModelProxy->mpCompositeModel->GetSimParams().SetComponentPlacement(placementStr);
+  }
+  else {
+    TLMErrorLog::Warning("Unknown component placement " + placementStr + ", use shared or graph.");
+  }
+}
+
+void omtlm_setBusyPollTime(void *pModel, double pollTime) {
+  CompositeModelProxy *pModelProxy = (CompositeModelProxy*)pModel;
+  pModelProxy->mpCompositeModel->GetSimParams().SetBusyPollTime(pollTime > 0.0 ? pollTime : 0.0);
+}
+
+void omtlm_setReceiverThread(void *pModel, int enable) {
+  CompositeModelProxy *pModelProxy = (CompositeModelProxy*)pModel;
+  pModelProxy->mpCompositeModel->GetSimParams().SetReceiverThread(enable != 0);
+}
+
+void omtlm_setAsyncLogging(void *pModel, int enable) {
+  CompositeModelProxy *pModelProxy = (CompositeModelProxy*)pModel;
+  pModelProxy->asyncLogging = (enable != 0);
+}
+
+void omtlm_setResultsInMemory(void *pModel, const char *interfaces) {
+  CompositeModelProxy *pModelProxy = (CompositeModelProxy*)pModel;
+  pModelProxy->memoryResults = (interfaces != NULL);
+  pModelProxy->memoryInterfaces = splitInterfaceList(interfaces);
+}
+
+int omtlm_getNumResultVariables(void *pModel) {
+  CompositeModelProxy *pModelProxy = (CompositeModelProxy*)pModel;
+  return int(pModelProxy->resultNames.size());
+}
+
+const char* omtlm_getResultVariableName(void *pModel, int variable) {
+  CompositeModelProxy *pModelProxy = (CompositeModelProxy*)pModel;
+  if(variable < 0 || variable >= int(pModelProxy->resultNames.size())) {
+    return NULL;
+  }
+  return pModelProxy->resultNames[variable].c_str();
+}
+
+int omtlm_getNumResultSamples(void *pModel) {
+  CompositeModelProxy *pModelProxy = (CompositeModelProxy*)pModel;
+  if(pModelProxy->resultValues.empty()) {
+    return 0;
+  }
+  return int(pModelProxy->resultValues[0].size());
+}
+
+const double* omtlm_getResultValues(void *pModel, int variable) {
+  CompositeModelProxy *pModelProxy = (CompositeModelProxy*)pModel;
+  if(variable < 0 || variable >= int(pModelProxy->resultValues.size())
+     || pModelProxy->resultValues[variable].empty()) {
+    return NULL;
+  }
+  return &pModelProxy->resultValues[variable][0];
+}
+
 void omtlm_printModelStructure(void *pModel)
 {
   CompositeModelProxy *pModelProxy = (CompositeModelProxy*)pModel;
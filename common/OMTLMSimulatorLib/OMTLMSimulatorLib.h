@@ -184,6 +184,169 @@ DLLEXPORT void omtlm_setLogStepSize(void *pModel, double stepSize);
  */
 DLLEXPORT void omtlm_setNumLogStep(void *pModel, int steps);
 
+/**
+ * \brief Sets the result file format.
+ *
+ * @param pModel Model as opaque pointer.
+ * @param format "csv" (default) for <model>.csv, "csv.gz" for the block compressed
+ *               <model>.csv.gz or "mat" for the binary <model>.mat.
+ */
+DLLEXPORT void omtlm_setLogFormat(void *pModel, const char *format);
+
+/**
+ * \brief Publishes live telemetry while the model is simulated.
+ *
+ * The simulation status and the latest result rows are published in the
+ * shared memory segment "segmentName", where they can be read without
+ * slowing down the simulation, e.g., with tlmtelemetry or TLMTelemetryReader.
+ *
+ * @param pModel Model as opaque pointer.
+ * @param segmentName Shared memory segment name, empty to disable telemetry.
+ * @param interfaces Comma separated list of published interfaces
+ *                   (component.interface), empty for all interfaces.
+ */
+DLLEXPORT void omtlm_setTelemetry(void *pModel, const char *segmentName, const char *interfaces);
+
+/**
+ * \brief Writes a wait time and message latency profile of the simulation.
+ *
+ * The profile holds the time each component waited for data on each
+ * interface and the time the manager took to forward the messages.
+ * The tlmprofile tool turns it into a critical path report.
+ *
+ * @param pModel Model as opaque pointer.
+ * @param fileName Profile file name, empty for no profile.
+ */
+DLLEXPORT void omtlm_setProfileFile(void *pModel, const char *fileName);
+
+/**
+ * \brief Writes a timeline trace of the manager and the components.
+ *
+ * The manager and each component it starts write a binary trace of the
+ * messages, the time waiting for data and the solver steps to the
+ * directory. The tlmtrace tool merges them into a Chrome trace JSON file
+ * that can be viewed in Perfetto or chrome://tracing.
+ *
+ * @param pModel Model as opaque pointer.
+ * @param directory Existing trace directory, empty for no trace.
+ */
+DLLEXPORT void omtlm_setTraceDirectory(void *pModel, const char *directory);
+
+/**
+ * \brief Sets the CPU affinity and scheduling policy of the simulation.
+ *
+ * The manager threads are pinned to one of the manager CPUs each, and
+ * the components it starts are pinned to the component CPUs. Failures,
+ * e.g., missing permissions for a real-time policy, only give a warning.
+ * A NULL argument keeps the setting of the composite model.
+ *
+ * @param pModel Model as opaque pointer.
+ * @param managerCPUs CPU list of the manager threads, e.g., "2,3" or "2-4", empty for no pinning.
+ * @param componentCPUs CPU list of the components, empty for no pinning.
+ * @param policy Scheduling policy "other", "fifo" or "rr", empty for the default policy.
+ * @param priority Scheduling priority used with the policy.
+ */
+DLLEXPORT void omtlm_setThreadPlacement(void *pModel, const char *managerCPUs, const char *componentCPUs,
+                                        const char *policy, int priority);
+
+/**
+ * \brief Sets the placement of the components on the component CPUs.
+ *
+ * With "graph" each component is pinned to one CPU, chosen so that
+ * components connected by links with short delays share a cache.
+ *
+ * @param pModel Model as opaque pointer.
+ * @param placement "shared" (default) for all components on all component CPUs, or "graph".
+ */
+DLLEXPORT void omtlm_setComponentPlacement(void *pModel, const char *placement);
+
+/**
+ * \brief Enables busy polling of the manager and the components.
+ *
+ * A receive spins on its socket for up to pollTime seconds before it
+ * blocks. This avoids the wake up latency of blocking calls for links
+ * with very short delays, but keeps one core busy per process.
+ *
+ * @param pModel Model as opaque pointer.
+ * @param pollTime Busy-poll time in seconds, 0 to always block.
+ */
+DLLEXPORT void omtlm_setBusyPollTime(void *pModel, double pollTime);
+
+/**
+ * \brief Enables the receiver thread of the components.
+ *
+ * The components receive their time data in a background thread, so
+ * that the receive overlaps with the solver. The solver only waits if
+ * the data it needs has not arrived yet.
+ *
+ * @param pModel Model as opaque pointer.
+ * @param enable Non-zero to enable the receiver thread.
+ */
+DLLEXPORT void omtlm_setReceiverThread(void *pModel, int enable);
+
+/**
+ * \brief Enables asynchronous logging in omtlm_simulate.
+ *
+ * The log messages are queued by the logging threads and written by a
+ * background thread. Off by default, since the host application may
+ * write to the same log stream.
+ *
+ * @param pModel Model as opaque pointer.
+ * @param enable Non-zero to enable asynchronous logging.
+ */
+DLLEXPORT void omtlm_setAsyncLogging(void *pModel, int enable);
+
+/**
+ * \brief Keeps the simulation results in memory.
+ *
+ * The result rows are also stored in memory while they are recorded,
+ * and can be retrieved with omtlm_getResultValues after omtlm_simulate
+ * returns, without reading the result file.
+ *
+ * @param pModel Model as opaque pointer.
+ * @param interfaces Comma separated list of kept interfaces (component.interface),
+ *                   empty for all interfaces or NULL to disable.
+ */
+DLLEXPORT void omtlm_setResultsInMemory(void *pModel, const char *interfaces);
+
+/**
+ * \brief Returns the number of result variables kept in memory.
+ *
+ * The first two variables are time and wallTime, followed by the
+ * variables of the interfaces given to omtlm_setResultsInMemory.
+ *
+ * @param pModel Model as opaque pointer.
+ */
+DLLEXPORT int omtlm_getNumResultVariables(void *pModel);
+
+/**
+ * \brief Returns the name of a result variable kept in memory.
+ *
+ * @param pModel Model as opaque pointer.
+ * @param variable Variable index, 0 to omtlm_getNumResultVariables-1.
+ * @return The name, e.g., "comp.ifc.x [m]", or NULL if the index is invalid.
+ */
+DLLEXPORT const char* omtlm_getResultVariableName(void *pModel, int variable);
+
+/**
+ * \brief Returns the number of result samples, that is, logging steps.
+ *
+ * @param pModel Model as opaque pointer.
+ */
+DLLEXPORT int omtlm_getNumResultSamples(void *pModel);
+
+/**
+ * \brief Returns the samples of a result variable kept in memory.
+ *
+ * The array is valid until the model is simulated again or unloaded.
+ *
+ * @param pModel Model as opaque pointer.
+ * @param variable Variable index, 0 to omtlm_getNumResultVariables-1.
+ * @return Contiguous array of omtlm_getNumResultSamples values,
+ *         or NULL if the index is invalid.
+ */
+DLLEXPORT const double* omtlm_getResultValues(void *pModel, int variable);
+
 /**
  * \brief Simulates the model.
  *
@@ -28,6 +28,19 @@ struct optionsType {
   std::string model = "";
   double logStepSize = 0;
   int numLogSteps = 1000;
+  std::string logFormat = "csv";
+  std::string telemetry = "";
+  std::string telemetryInterfaces = "";
+  std::string profile = "";
+  std::string trace = "";
+  std::string managerCPUs = "";
+  std::string componentCPUs = "";
+  std::string schedPolicy = "";
+  int schedPriority = 0;
+  std::string placement = "";
+  double busyPollTime = -1;
+  int receiverThread = -1;
+  int asyncLogging = -1;
 
   bool addressSet = false;
   bool managerSet = false;
@@ -85,6 +98,45 @@ struct optionsType {
         else if(name == "logsteps") {
           numLogSteps = stoi(value);
         }
+        else if(name == "logformat") {
+          logFormat = value;
+        }
+        else if(name == "telemetry") {
+          telemetry = value;
+        }
+        else if(name == "telemetryinterfaces") {
+          telemetryInterfaces = value;
+        }
+        else if(name == "profile") {
+          profile = value;
+        }
+        else if(name == "trace") {
+          trace = value;
+        }
+        else if(name == "managercpus") {
+          managerCPUs = value;
+        }
+        else if(name == "componentcpus") {
+          componentCPUs = value;
+        }
+        else if(name == "schedpolicy") {
+          schedPolicy = value;
+        }
+        else if(name == "schedpriority") {
+          schedPriority = stoi(value);
+        }
+        else if(name == "placement") {
+          placement = value;
+        }
+        else if(name == "busypoll") {
+          busyPollTime = stod(value);
+        }
+        else if(name == "receiverthread") {
+          receiverThread = stoi(value);
+        }
+        else if(name == "asynclog") {
+          asyncLogging = stoi(value);
+        }
         else if(name == "singlemodel") {
           singleModel = value;
         }
@@ -137,6 +189,19 @@ struct optionsType {
     std::cout << "   modelFile        = " << model << "\n";
     std::cout << "   timeStep         = " << logStepSize << "\n";
     std::cout << "   nLogSteps        = " << numLogSteps << "\n";
+    std::cout << "   logFormat        = " << logFormat << "\n";
+    std::cout << "   telemetry        = " << telemetry << "\n";
+    std::cout << "   telemetryIfaces  = " << telemetryInterfaces << "\n";
+    std::cout << "   profile          = " << profile << "\n";
+    std::cout << "   trace            = " << trace << "\n";
+    std::cout << "   managerCPUs      = " << managerCPUs << "\n";
+    std::cout << "   componentCPUs    = " << componentCPUs << "\n";
+    std::cout << "   schedPolicy      = " << schedPolicy << "\n";
+    std::cout << "   schedPriority    = " << schedPriority << "\n";
+    std::cout << "   placement        = " << placement << "\n";
+    std::cout << "   busyPollTime     = " << busyPollTime << "\n";
+    std::cout << "   receiverThread   = " << receiverThread << "\n";
+    std::cout << "   asyncLogging     = " << asyncLogging << "\n";
 
   }
 } options;
@@ -159,6 +224,27 @@ int main(int argc, char *argv[])
 
   void* pModel = omtlm_loadModel(options.model.c_str());
   omtlm_setLogLevel(pModel, options.logLevel);
+  omtlm_setLogFormat(pModel, options.logFormat.c_str());
+  omtlm_setTelemetry(pModel, options.telemetry.c_str(), options.telemetryInterfaces.c_str());
+  omtlm_setProfileFile(pModel, options.profile.c_str());
+  omtlm_setTraceDirectory(pModel, options.trace.c_str());
+  omtlm_setThreadPlacement(pModel,
+                           options.managerCPUs.empty() ? NULL : options.managerCPUs.c_str(),
+                           options.componentCPUs.empty() ? NULL : options.componentCPUs.c_str(),
+                           options.schedPolicy.empty() ? NULL : options.schedPolicy.c_str(),
+                           options.schedPriority);
+  if(!options.placement.empty()) {
+    omtlm_setComponentPlacement(pModel, options.placement.c_str());
+  }
+  if(options.busyPollTime >= 0) {
+    omtlm_setBusyPollTime(pModel, options.busyPollTime);
+  }
+  if(options.receiverThread >= 0) {
+    omtlm_setReceiverThread(pModel, options.receiverThread);
+  }
+  if(options.asyncLogging >= 0) {
+    omtlm_setAsyncLogging(pModel, options.asyncLogging);
+  }
 /*
   void *pModel = omtlm_newModel("FmiTest");
   omtlm_addSubModel(pModel, "adder","/home/robbr48/Documents/Git/OMTLMSimulator/CompositeModels/FmiTestLinux/cs_adder1fmu1/cs_adder1.fmu", "StartTLMFmiWrapper");
@@ -14,11 +14,17 @@ MonitoringPluginImplementer* MonitoringPluginImplementer::CreateInstance() {
     return new MonitoringPluginImplementer();
 }
 
+void MonitoringPluginImplementer::SetSamplingInterval(double interval) {
+    TLMMonitorRequest request;
+    request.SamplingInterval = interval;
+    ClientComm.SetMonitorRequest(request);
+}
+
 void MonitoringPluginImplementer::ReceiveTimeData(omtlm_TLMInterface* reqIfc, double time) {
     while(time > reqIfc->GetNextRecvTime()) { // while data is needed
 
         // Receive data untill there is info for this interface
-        if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
+        if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
             TLMErrorLog::Info("Interface " +
                               reqIfc->GetName() +
                               " needs data for time= " +
@@ -44,7 +50,7 @@ void MonitoringPluginImplementer::ReceiveTimeData(omtlm_TLMInterface* reqIfc, do
             ifc->UnpackTimeData(*Message);
 
             // Received data
-            if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
+            if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
               TLMErrorLog::Info(string("Interface ") + ifc->GetName() + " got data until time= "
                                + TLMErrorLog::ToStdStr(ifc->GetNextRecvTime()));
             }
@@ -53,7 +59,7 @@ void MonitoringPluginImplementer::ReceiveTimeData(omtlm_TLMInterface* reqIfc, do
 
         if(ifc == NULL) break; // receive error - breaking
 
-        if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
+        if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
             TLMErrorLog::Info(string("Got data until time=") + TLMErrorLog::ToStdStr(ifc->GetNextRecvTime()));
         }
     }
@@ -47,6 +47,13 @@ public:
                double timeEnd,
                double maxStep,
                std::string ServerName);
+
+    //! Set the interval at which the monitor requests data. Interfaces
+    //! registered afterwards ask the manager for a decimated feed
+    //! containing only the samples needed at these instants.
+    //! Zero (default) means that all time data is forwarded.
+    //! The interval is sent with the registrations, see TLMMonitorRequest.
+    void SetSamplingInterval(double interval);
 };
 
 #endif // MONITORINGPLUGINIMPLEMENTER_H
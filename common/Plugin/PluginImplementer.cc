@@ -3,6 +3,8 @@
 #include "Plugin/TLMPlugin.h"
 #include "Communication/TLMCommUtil.h"
 #include "Plugin/PluginImplementer.h"
+#include "Logging/TLMTrace.h"
+#include "Communication/TLMScheduling.h"
 #include <cassert>
 #include <iostream>
 #include <csignal>
@@ -26,13 +28,32 @@ TLMPlugin* TLMPlugin::CreateInstance() {
     return PluginImplementerInstance;
 }
 
+//! ThreadSafeLock locks a mutex for the scope of the object, like AutoLock,
+//! but only if the plugin is in thread-safe mode.
+class ThreadSafeLock {
+    SimpleLock& TheLock;
+    bool Locked;
+
+public:
+    ThreadSafeLock(SimpleLock& lock, bool threadSafe): TheLock(lock), Locked(threadSafe) {
+        if(Locked) TheLock.lock();
+    }
+
+    ~ThreadSafeLock() {
+        if(Locked) TheLock.unlock();
+    }
+};
 
 void PluginImplementer::InterfaceReadyForTakedown(std::string IfcName) {
+    ThreadSafeLock lock(DispatchLock, ThreadSafe);
     ++nIfcWaitingForTakedown;
 
     TLMErrorLog::Debug("Interface "+IfcName+" is ready for takedown.");
 
     if(nIfcWaitingForTakedown >= Interfaces.size()) {
+        // The close permission arrives on the socket, another solver thread
+        // must not be reading it.
+        while(Receiving) ReceiveDone.wait(DispatchLock);
         AwaitClosePermission();
         exit(0);
     }
@@ -40,13 +61,37 @@ void PluginImplementer::InterfaceReadyForTakedown(std::string IfcName) {
 
 void PluginImplementer::AwaitClosePermission()
 {
-    Message->Header.MessageType = TLMMessageTypeConst::TLM_CLOSE_REQUEST;
-    TLMCommUtil::SendMessage(*Message);
-    while(Message->Header.MessageType != TLMMessageTypeConst::TLM_CLOSE_PERMISSION) {
-        TLMErrorLog::Info("Awaiting close permission...");
-        TLMCommUtil::ReceiveMessage(*Message);
+    // The wait profile is sent with the close request, see ManagerCommHandler.
+    double runTime = (RunStartTime > 0.0) ? TLMCommUtil::GetWallClockTime() - RunStartTime : 0.0;
+    for(size_t i = 0; i < Interfaces.size(); i++) {
+        const TLMExtrapolationStats& stats = Interfaces[i]->GetExtrapolationStats();
+        WaitProfile[i].NumBackward = stats.NumBackward;
+        WaitProfile[i].NumForward = stats.NumForward;
+        WaitProfile[i].MaxBackwardError = stats.MaxBackwardError;
+        WaitProfile[i].MaxForwardError = stats.MaxForwardError;
+    }
+    TLMClientComm::PackCloseRequestMessage(runTime, WaitProfile, *Message);
+    {
+        TLMTraceScope trace(TraceAwaitClose);
+        ClientComm.SendMessage(*Message);
+        if(UseReceiverThread && ModelChecked) {
+            // The receiver thread returns when the close permission arrives.
+            TLMErrorLog::Info("Awaiting close permission...");
+#ifdef USE_THREADS
+            pthread_join(ReceiverThread, NULL);
+#endif
+            UseReceiverThread = false;
+        }
+        else {
+            while(Message->Header.MessageType != TLMMessageTypeConst::TLM_CLOSE_PERMISSION) {
+                TLMErrorLog::Info("Awaiting close permission...");
+                TLMCommUtil::ReceiveMessage(*Message);
+            }
+        }
     }
     TLMErrorLog::Info("Close permission received.");
+
+    TLMTrace::Close();
 }
 
 void PluginImplementer::SetInitialForce3D(int interfaceID, double f1, double f2, double f3, double t1, double t2, double t3)
@@ -120,12 +165,24 @@ void signalHandler_(int signum) {
 PluginImplementer::PluginImplementer():
     Connected(false),
     ModelChecked(false),
+    ThreadSafe(false),
+    DispatchLock(),
+    ReceiveDone(),
+    Receiving(false),
+    NumReceiveFailures(0),
+    UseReceiverThread(false),
+    BusyPollTime(0.0),
+    ReceiverRunning(false),
     Interfaces(),
     ClientComm(),
     MapID2Ind(),
     StartTime(0.0),
     EndTime(0.0),
-    MaxStep(0.0) {
+    MaxStep(0.0),
+    RunStartTime(0.0),
+    WaitProfile(),
+    TraceStepStart(-1.0),
+    TraceStepTime(0.0) {
     // Install out own signal handler.
     signal(SIGABRT, signalHandler_);
     signal(SIGFPE, signalHandler_);
@@ -137,6 +194,18 @@ PluginImplementer::PluginImplementer():
 
 
 PluginImplementer::~PluginImplementer() {
+    if(UseReceiverThread && ModelChecked) {
+        // The simulation ended without close permission, unblock the
+        // receiver thread before the interfaces are deleted.
+#ifdef _WIN32
+        shutdown(Message->SocketHandle, SD_BOTH);
+#else
+        shutdown(Message->SocketHandle, SHUT_RDWR);
+#endif
+#ifdef USE_THREADS
+        pthread_join(ReceiverThread, NULL);
+#endif
+    }
 
     for(vector<omtlm_TLMInterface*>::iterator it = Interfaces.begin();
         it != Interfaces.end(); ++it) {
@@ -144,6 +213,8 @@ PluginImplementer::~PluginImplementer() {
     }
 
     delete Message;
+
+    TLMTrace::Close();
 }
 
 void PluginImplementer::HandleSignal(int signum) {
@@ -156,6 +227,10 @@ void PluginImplementer::HandleSignal(int signum) {
 }
 
 void PluginImplementer::CheckModel() {
+    ThreadSafeLock lock(DispatchLock, ThreadSafe);
+
+    // Another solver thread may have checked the model while this one waited.
+    if(ThreadSafe && ModelChecked) return;
 
     if(!Connected) {
         TLMErrorLog::FatalError("Check model cannot be called before the TLM client is connected to manager");
@@ -163,8 +238,11 @@ void PluginImplementer::CheckModel() {
 
     Message->Header.MessageType =  TLMMessageTypeConst::TLM_CHECK_MODEL;
 
-    TLMCommUtil::SendMessage(*Message);
-    TLMCommUtil::ReceiveMessage(*Message);
+    {
+        TLMTraceScope trace(TraceCheckModel);
+        ClientComm.SendMessage(*Message);
+        TLMCommUtil::ReceiveMessage(*Message);
+    }
 
     if(! Message->Header.TLMInterfaceID) {
         TLMErrorLog::Info("Error detected on TLM manager while checking meta model");
@@ -172,6 +250,90 @@ void PluginImplementer::CheckModel() {
     }
 
     ModelChecked = true;
+    RunStartTime = TLMCommUtil::GetWallClockTime();
+
+    if(UseReceiverThread) {
+        StartReceiverThread();
+    }
+
+    // The first solver step starts now.
+    if(TLMTrace::IsEnabled()) {
+        TraceStepStart = TLMTrace::Now();
+        TraceStepTime = StartTime;
+    }
+}
+
+void PluginImplementer::SetThreadSafe(bool threadSafe) {
+    if(ModelChecked) {
+        TLMErrorLog::Warning("The thread-safe mode must be set before the simulation starts.");
+        return;
+    }
+
+    TLMErrorLog::Info(string("Thread-safe mode ") + (threadSafe ? "enabled" : "disabled"));
+
+    // The receiver thread needs the data locks in any case.
+    ThreadSafe = threadSafe || UseReceiverThread;
+    ClientComm.SetThreadSafe(threadSafe);
+}
+
+void PluginImplementer::StartReceiverThread() {
+#ifdef USE_THREADS
+    ReceiverRunning = true;
+    pthread_create(&ReceiverThread, NULL, thread_ReceiverThreadRun, (void*)this);
+#endif
+}
+
+void* PluginImplementer::thread_ReceiverThreadRun(void* arg) {
+    PluginImplementer* plugin = reinterpret_cast<PluginImplementer*>(arg);
+    plugin->ReceiverThreadRun();
+    return NULL;
+}
+
+void PluginImplementer::ReceiverThreadRun() {
+    TLMTrace::SetThreadName("receiver");
+
+    // The receiver has a buffer of its own, Message is used by the solver
+    // threads to send the close request.
+    TLMMessage mess;
+    mess.SocketHandle = Message->SocketHandle;
+
+    while(TLMCommUtil::ReceiveMessage(mess, BusyPollTime)) {
+        if(mess.Header.MessageType == TLMMessageTypeConst::TLM_CLOSE_PERMISSION) {
+            break;
+        }
+
+        omtlm_TLMInterface* ifc = Interfaces[GetInterfaceIndex(mess.Header.TLMInterfaceID)];
+        AutoLock lock(ifc->GetDataLock());
+        ifc->UnpackTimeData(mess);
+        ifc->GetDataReady().broadcast();
+
+        if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
+            TLMErrorLog::Info(string("Interface ") + ifc->GetName() + " got data until time= " +
+                             TLMErrorLog::ToStdStr(ifc->GetNextRecvTime()));
+        }
+    }
+
+    // Wake up the waiting solver threads, they extrapolate from now on.
+    ReceiverRunning = false;
+    for(size_t i = 0; i < Interfaces.size(); i++) {
+        AutoLock lock(Interfaces[i]->GetDataLock());
+        Interfaces[i]->GetDataReady().broadcast();
+    }
+}
+
+void PluginImplementer::RecordSolverStep(double time) {
+    if(!TLMTrace::IsEnabled()) return;
+
+    ThreadSafeLock lock(DispatchLock, ThreadSafe);
+    if(TraceStepStart < 0.0) return;
+
+    // The other interfaces set their data for the same step.
+    if(time <= TraceStepTime) return;
+
+    double now = TLMTrace::Now();
+    TLMTrace::AddEvent(TraceSolverStep, TraceStepStart, now, -1, 0, time);
+    TraceStepStart = now;
+    TraceStepTime = time;
 }
 
 
@@ -195,6 +357,34 @@ bool PluginImplementer::Init(std::string model,
 
     int port = atoi(ServerName.c_str() + colPos + 1);
 
+    // Components started by a tracing manager are traced as well.
+    if(TLMTrace::OpenFromEnvironment(model)) {
+        TLMTrace::SetThreadName("main");
+    }
+
+    // Components started by the manager run on the CPUs and with the
+    // scheduling policy given in the composite model.
+    TLMScheduling::ApplyFromEnvironment();
+
+    const char* busyPollTime = getenv(TLM_BUSY_POLL_ENV);
+    if(busyPollTime != NULL && atof(busyPollTime) > 0.0) {
+        TLMErrorLog::Info(string("Busy polling for ") + busyPollTime + " s before blocking");
+        BusyPollTime = atof(busyPollTime);
+    }
+
+    // The receiver thread is started when the model is checked.
+    const char* receiverThread = getenv(TLM_RECEIVER_THREAD_ENV);
+    if(receiverThread != NULL && atoi(receiverThread) != 0) {
+#ifdef USE_THREADS
+        TLMErrorLog::Info("Receiving time data in a background thread");
+        UseReceiverThread = true;
+        ThreadSafe = true;
+#else
+        TLMErrorLog::Warning("The receiver thread needs a build with threads, the solver receives the data.");
+#endif
+    }
+    TLMTraceScope trace(TraceRegistration);
+
     string host = ServerName.substr(0,colPos);
 
     Message = new TLMMessage();
@@ -231,6 +421,7 @@ bool PluginImplementer::Init(std::string model,
 int  PluginImplementer::RegisteTLMInterface(std::string name , int dimensions,
                                             std::string causality, std::string domain) {
     TLMErrorLog::Info(string("Register Interface ") + name);
+    TLMTraceScope trace(TraceRegisterInterface);
 
     //Convert causality and domain to lower-case for backwards compatibility
     std::locale loc;
@@ -261,6 +452,7 @@ int  PluginImplementer::RegisteTLMInterface(std::string name , int dimensions,
     int id = ifc->GetInterfaceID();
 
     TLMErrorLog::Info(string("Got interface ID: ") + TLMErrorLog::ToStdStr(id));
+    trace.SetInterface(id);
 
     // Check that this interface is connected
     if(id < 0) {
@@ -276,11 +468,22 @@ int  PluginImplementer::RegisteTLMInterface(std::string name , int dimensions,
 
     MapID2Ind[id] = idx;
 
+    TLMWaitProfile profile;
+    profile.InterfaceID = id;
+    profile.WaitTime = 0.0;
+    profile.NumWaits = 0.0;
+    profile.NumBackward = 0.0;
+    profile.NumForward = 0.0;
+    profile.MaxBackwardError = 0.0;
+    profile.MaxForwardError = 0.0;
+    WaitProfile.push_back(profile);
+
     return id;
 }
 
 
 int PluginImplementer::RegisterComponentParameter(std::string name, std::string defaultValue) {
+    TLMTraceScope trace(TraceRegisterInterface);
     ComponentParameter *par = new ComponentParameter(ClientComm, name, defaultValue);
 
     int id = par->GetParameterID();
@@ -306,29 +509,35 @@ int PluginImplementer::RegisterComponentParameter(std::string name, std::string
 // Input:
 //   interfaceID - ID of a TLM interface that triggered the request
 void PluginImplementer::ReceiveTimeData(omtlm_TLMInterface* reqIfc, double time) {
+    if(time <= reqIfc->GetNextRecvTime()) return; // data is available
+
+    // The time blocked here is the time this component waits for the others.
+    double waitStart = TLMCommUtil::GetWallClockTime();
+    TLMTraceScope trace(TraceWaitData, reqIfc->GetInterfaceID(), time);
+
+    if(ThreadSafe) {
+        DispatchTimeData(reqIfc, time);
+        AutoLock lock(DispatchLock);
+        RecordWait(reqIfc, waitStart);
+        return;
+    }
+
     while(time > reqIfc->GetNextRecvTime()) { // while data is needed
 
         // Receive data untill there is info for this interface
-        if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
+        if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
            TLMErrorLog::Info("Interface " + reqIfc->GetName() +
                             " needs data for time= " + TLMErrorLog::ToStdStr(time));
         }
 
-        double allowedMaxTime = reqIfc->GetLastSendTime() + reqIfc->GetConnParams().Delay;
-
-        if(allowedMaxTime < time && reqIfc->GetCausality() != "input") {            //Why not for signal interfaces?
-            TLMErrorLog::Warning("Interface " + reqIfc->GetName() +
-                             " is NOT ALLOWED to ask data after time= " + TLMErrorLog::ToStdStr(allowedMaxTime) +
-                             ". The error is: "+TLMErrorLog::ToStdStr(time - allowedMaxTime));
-            break;
-        }
+        if(!MayWaitForData(reqIfc, time)) break;
 
         omtlm_TLMInterface* ifc = NULL;
 
         do {
 
             // Receive a message
-            if(!TLMCommUtil::ReceiveMessage(*Message)) // on error leave this loop and use extrapolation
+            if(!TLMCommUtil::ReceiveMessage(*Message, BusyPollTime)) // on error leave this loop and use extrapolation
                 break;
 
             // Get the target ID
@@ -342,7 +551,7 @@ void PluginImplementer::ReceiveTimeData(omtlm_TLMInterface* reqIfc, double time)
             ifc->UnpackTimeData(*Message);
 
             // Received data
-            if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
+            if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
                 TLMErrorLog::Info(string("Interface ") + ifc->GetName() + " got data until time= " +
                                  TLMErrorLog::ToStdStr(ifc->GetNextRecvTime()));
             }
@@ -351,11 +560,91 @@ void PluginImplementer::ReceiveTimeData(omtlm_TLMInterface* reqIfc, double time)
 
         if(ifc == NULL) break; // receive error - breaking
 
-        if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
+        if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
             TLMErrorLog::Info(string("Got data until time=") +
                              TLMErrorLog::ToStdStr(ifc->GetNextRecvTime()));
         }
     }
+
+    RecordWait(reqIfc, waitStart);
+}
+
+
+// DispatchTimeData receives time data in thread-safe mode. The first thread
+// that needs data becomes the receiver, the other threads wait for it and
+// check after each message if their data has arrived. When it has the data
+// it needs the receiver leaves and a waiting thread takes over.
+bool PluginImplementer::DispatchTimeData(omtlm_TLMInterface* reqIfc, double time) {
+    if(UseReceiverThread) {
+        // The receiver thread signals the interface when it unpacked new data.
+        AutoLock ifcLock(reqIfc->GetDataLock());
+        if(!MayWaitForData(reqIfc, time)) return false;
+
+        while(time > reqIfc->GetNextRecvTime() && ReceiverRunning) {
+            reqIfc->GetDataReady().wait(reqIfc->GetDataLock());
+        }
+        return time <= reqIfc->GetNextRecvTime();
+    }
+
+    {
+        AutoLock ifcLock(reqIfc->GetDataLock());
+        if(!MayWaitForData(reqIfc, time)) return false;
+    }
+
+    AutoLock lock(DispatchLock);
+    const int numFailures = NumReceiveFailures;
+
+    while(time > reqIfc->GetNextRecvTime() && NumReceiveFailures == numFailures) {
+        if(Receiving) {
+            ReceiveDone.wait(DispatchLock);
+            continue;
+        }
+
+        // The receiver owns the message buffer, the interfaces are unpacked
+        // under their own lock, so that the other threads can work with
+        // their interfaces meanwhile.
+        Receiving = true;
+        DispatchLock.unlock();
+
+        bool received = TLMCommUtil::ReceiveMessage(*Message, BusyPollTime);
+        if(received) {
+            omtlm_TLMInterface* ifc = Interfaces[GetInterfaceIndex(Message->Header.TLMInterfaceID)];
+            AutoLock ifcLock(ifc->GetDataLock());
+            ifc->UnpackTimeData(*Message);
+
+            if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
+                TLMErrorLog::Info(string("Interface ") + ifc->GetName() + " got data until time= " +
+                                 TLMErrorLog::ToStdStr(ifc->GetNextRecvTime()));
+            }
+        }
+
+        DispatchLock.lock();
+        Receiving = false;
+        if(!received) NumReceiveFailures++;
+        ReceiveDone.broadcast();
+    }
+
+    return time <= reqIfc->GetNextRecvTime();
+}
+
+
+bool PluginImplementer::MayWaitForData(omtlm_TLMInterface* reqIfc, double time) {
+    double allowedMaxTime = reqIfc->GetLastSendTime() + reqIfc->GetConnParams().Delay;
+
+    if(allowedMaxTime < time && reqIfc->GetCausality() != "input") {            //Why not for signal interfaces?
+        TLM_LOG_WARNING("Interface " + reqIfc->GetName() +
+                        " is NOT ALLOWED to ask data after time= " + TLMErrorLog::ToStdStr(allowedMaxTime) +
+                        ". The error is: "+TLMErrorLog::ToStdStr(time - allowedMaxTime));
+        return false;
+    }
+    return true;
+}
+
+
+void PluginImplementer::RecordWait(omtlm_TLMInterface* reqIfc, double waitStart) {
+    TLMWaitProfile& profile = WaitProfile[GetInterfaceIndex(reqIfc->GetInterfaceID())];
+    profile.WaitTime += TLMCommUtil::GetWallClockTime() - waitStart;
+    profile.NumWaits += 1.0;
 }
 
 
@@ -381,7 +670,10 @@ void PluginImplementer::GetValueSignal(int interfaceID, double time, double *val
     ReceiveTimeData(ifc, time);
 
     // evaluate the reaction force from the TLM connection
-    ifc->GetValue(time, value);
+    {
+        ThreadSafeLock lock(ifc->GetDataLock(), ThreadSafe);
+        ifc->GetValue(time, value);
+    }
 
     if(ifc->waitForShutdown()) {
         InterfaceReadyForTakedown(ifc->GetName());
@@ -416,6 +708,7 @@ void PluginImplementer::GetForce1D(int interfaceID, double time, double speed, d
     ReceiveTimeData(ifc, time);
 
     // evaluate the reaction force from the TLM connection
+    ThreadSafeLock lock(ifc->GetDataLock(), ThreadSafe);
     ifc->GetForce(time, speed, force);
 }
 
@@ -451,6 +744,7 @@ void PluginImplementer::GetForce3D(int interfaceID,
     ReceiveTimeData(ifc, time);
 
     // evaluate the reaction force from the TLM connection
+    ThreadSafeLock lock(ifc->GetDataLock(), ThreadSafe);
     ifc->GetForce(time, position, orientation, speed, ang_speed, force);
 }
 
@@ -479,6 +773,7 @@ void PluginImplementer::GetWaveImpedance1D(int interfaceID, double time, double
     ReceiveTimeData(ifc, time);
 
     // evaluate the reaction force from the TLM connection
+    ThreadSafeLock lock(ifc->GetDataLock(), ThreadSafe);
     ifc->GetWave(time, wave);
     (*impedance) = ifc->GetConnParams().Zf;
 }
@@ -509,6 +804,7 @@ void PluginImplementer::GetWaveImpedance3D(int interfaceID, double time, double
     ReceiveTimeData(ifc, time);
 
     // evaluate the reaction force from the TLM connection
+    ThreadSafeLock lock(ifc->GetDataLock(), ThreadSafe);
     ifc->GetWave(time, wave);
     (*Zt) = ifc->GetConnParams().Zf;
     (*Zr) = ifc->GetConnParams().Zfr;
@@ -532,6 +828,8 @@ void PluginImplementer::SetMotion3D(int forceID,
     if(!ifc->waitForShutdown()) {
         // Store the data into the interface object
         TLMErrorLog::Info(string("calling SetTimeData()"));
+        RecordSolverStep(time);
+        ThreadSafeLock lock(ifc->GetDataLock(), ThreadSafe);
         ifc->SetTimeData(time, position, orientation,speed,ang_speed);
     }
     else {
@@ -567,6 +865,8 @@ void PluginImplementer::SetValueSignal(int valueID,
     if(!ifc->waitForShutdown()) {
         // Store the data into the interface object
         TLMErrorLog::Info(string("calling SetTimeData()"));
+        RecordSolverStep(time);
+        ThreadSafeLock lock(ifc->GetDataLock(), ThreadSafe);
         ifc->SetTimeData(time, value);
     }
     else {
@@ -600,9 +900,11 @@ void PluginImplementer::SetMotion1D(int forceID,
 
     if(!ifc->waitForShutdown()) {
         // Store the data into the interface object
-        if(TLMErrorLog::GetLogLevel() >= TLMLogLevel::Info) {
+        if(TLMErrorLog::IsLogged(TLMLogLevel::Info)) {
             TLMErrorLog::Info(string("calling SetTimeData()"));
         }
+        RecordSolverStep(time);
+        ThreadSafeLock lock(ifc->GetDataLock(), ThreadSafe);
         ifc->SetTimeData(time, position, speed);
     }
     else {
@@ -635,6 +937,19 @@ void PluginImplementer::GetConnectionParams(int interfaceID, TLMConnectionParams
     ParamsOut = ifc->GetConnParams();
 }
 
+// GetExtrapolationStats returns the extrapolation statistics of the
+// specified interface.
+void PluginImplementer::GetExtrapolationStats(int interfaceID, TLMExtrapolationStats& StatsOut) {
+
+    // Use the ID to get to the right interface object
+    int idx = GetInterfaceIndex(interfaceID);
+    omtlm_TLMInterface* ifc = Interfaces[idx];
+    assert(ifc -> GetInterfaceID() == interfaceID);
+
+    ThreadSafeLock lock(ifc->GetDataLock(), ThreadSafe);
+    StatsOut = ifc->GetExtrapolationStats();
+}
+
 void PluginImplementer::GetTimeDataSignal(int interfaceID, double time, TLMTimeDataSignal &DataOut, bool monitoring) {
     if(!ModelChecked) CheckModel();
 
@@ -650,6 +965,7 @@ void PluginImplementer::GetTimeDataSignal(int interfaceID, double time, TLMTimeD
         ReceiveTimeData(ifc, time);
         DataOut.time = time - ifc->GetConnParams().Delay;
 
+        ThreadSafeLock lock(ifc->GetDataLock(), ThreadSafe);
         ifc->GetTimeData(DataOut);
     }
     else {          //Monitoring = receive time data for output interface
@@ -661,6 +977,7 @@ void PluginImplementer::GetTimeDataSignal(int interfaceID, double time, TLMTimeD
         ReceiveTimeData(ifc, time);
         DataOut.time = time - ifc->GetConnParams().Delay;
 
+        ThreadSafeLock lock(ifc->GetDataLock(), ThreadSafe);
         ifc->GetTimeData(DataOut);
     }
 }
@@ -679,6 +996,7 @@ void PluginImplementer::GetTimeData1D(int interfaceID, double time, TLMTimeData1
 
     DataOut.time = time - ifc->GetConnParams().Delay;
 
+    ThreadSafeLock lock(ifc->GetDataLock(), ThreadSafe);
     ifc->GetTimeData(DataOut);
 }
 
@@ -699,6 +1017,7 @@ void PluginImplementer::GetTimeData3D(int interfaceID, double time, TLMTimeData3
 
     DataOut.time = time - ifc->GetConnParams().Delay;
 
+    ThreadSafeLock lock(ifc->GetDataLock(), ThreadSafe);
     ifc->GetTimeData(DataOut);
 
 }
@@ -7,7 +7,9 @@
 
 #include <vector>
 #include <map>
+#include <atomic>
 #include "Communication/TLMClientComm.h"
+#include "Communication/TLMThreadSynch.h"
 #include "Interfaces/TLMInterface.h"
 #include "Interfaces/TLMInterfaceSignalInput.h"
 #include "Interfaces/TLMInterfaceSignalOutput.h"
@@ -44,6 +46,9 @@ public:
     //! The successful return indicates that the simulation is ready to run.
     void CheckModel();
 
+    //! Enable the thread-safe mode, see TLMPlugin::SetThreadSafe.
+    void SetThreadSafe(bool threadSafe);
+
 protected:
     //! Connected flag tells if the connection to TLM manager is established.
     bool Connected;
@@ -52,7 +57,51 @@ protected:
     bool IsConnected() const { return Connected; }
 
     //! Checked flag tells if the manager confirmed start of a simulation
-    bool ModelChecked;
+    std::atomic<bool> ModelChecked;
+
+    //! Set if several solver threads may call the plugin, see SetThreadSafe.
+    bool ThreadSafe;
+
+    //! Guards the receive state below, the wait profile, the solver step
+    //! trace and the takedown counter in thread-safe mode.
+    SimpleLock DispatchLock;
+
+    //! Signalled by the receiving thread after each message it dispatched.
+    SimpleCond ReceiveDone;
+
+    //! Set while a thread reads from the socket into Message.
+    bool Receiving;
+
+    //! Number of failed receives. The threads waiting while a receive
+    //! fails extrapolate, as in single-threaded mode later calls try again.
+    int NumReceiveFailures;
+
+    //! Set if the time data is received by a background thread, which is
+    //! started when the model is checked.
+    bool UseReceiverThread;
+
+    //! Time in seconds the time data receives spin before they block,
+    //! see TLMCommUtil::ReceiveMessage. Set by the manager in TLM_BUSY_POLL_ENV.
+    double BusyPollTime;
+
+    //! True while the receiver thread is running. Read by the solver
+    //! threads under the data lock of their interface.
+    std::atomic<bool> ReceiverRunning;
+
+#ifdef USE_THREADS
+    //! The receiver thread.
+    pthread_t ReceiverThread;
+#endif
+
+    //! Start the receiver thread, which drains the socket into the
+    //! interfaces until the close permission arrives.
+    void StartReceiverThread();
+
+    //! Receiver thread main loop.
+    void ReceiverThreadRun();
+
+    //! Receiver thread entry point, "arg" is the plugin.
+    static void* thread_ReceiverThreadRun(void* arg);
 
     //! Registered interfaces
     std::vector<omtlm_TLMInterface*> Interfaces;
@@ -111,6 +160,21 @@ protected:
     //!   time - time needed
     virtual void ReceiveTimeData(omtlm_TLMInterface* reqIfc, double time);
 
+    //! DispatchTimeData is ReceiveTimeData in thread-safe mode. One thread
+    //! at a time reads the socket and unpacks the messages into their
+    //! interfaces, the others wait until their data has arrived. With the
+    //! receiver thread all solver threads just wait for their data. Returns
+    //! false if the data did not arrive and the interface has to extrapolate.
+    bool DispatchTimeData(omtlm_TLMInterface* reqIfc, double time);
+
+    //! Check if the interface may wait for data until "time", i.e., if the
+    //! coupled simulation can send it before it needs our data.
+    bool MayWaitForData(omtlm_TLMInterface* reqIfc, double time);
+
+    //! Add a wait in ReceiveTimeData that started at wall clock time
+    //! "waitStart" to the wait profile.
+    void RecordWait(omtlm_TLMInterface* reqIfc, double waitStart);
+
     //! Evaluate the reaction force from the TLM connection
     //! for a specified interface. Might need to receive messages from the
     //! TLM manager with TimeData.
@@ -180,6 +244,10 @@ protected:
     void GetTimeData1D(int interfaceID, double time, TLMTimeData1D& DataOut);
     void GetTimeData3D(int interfaceID, double time, TLMTimeData3D& DataOut);
 
+    //! GetExtrapolationStats returns the extrapolation statistics of the
+    //! specified interface.
+    void GetExtrapolationStats(int interfaceID, TLMExtrapolationStats& StatsOut);
+
     void GetParameterValue(int parameterID, std::string &Name, std::string &Value);
 protected:
 
@@ -192,6 +260,23 @@ protected:
     //! Maximum solver time step
     double MaxStep;
 
+    //! Wall clock time when the simulation started, i.e., the model was checked.
+    double RunStartTime;
+
+    //! Time spent blocked in ReceiveTimeData, one entry per registered
+    //! interface (same index as Interfaces). Sent to the manager with
+    //! the close request.
+    std::vector<TLMWaitProfile> WaitProfile;
+
+    //! Trace time when the current solver step started, negative until the model is checked.
+    double TraceStepStart;
+
+    //! Simulation time at the start of the current solver step.
+    double TraceStepTime;
+
+    //! Record the solver step that ends when the data for "time" is set.
+    void RecordSolverStep(double time);
+
     size_t nIfcWaitingForTakedown = 0;
 
 };
@@ -55,6 +55,13 @@ public:
 
     virtual void AwaitClosePermission() = 0;
 
+    //! Enable the thread-safe mode, for solvers that evaluate interfaces in
+    //! parallel. Different threads may then call the Get and Set methods at
+    //! the same time, also for the same interface. Call it after Init and
+    //! before the simulation starts. The default is single-threaded use.
+    //! Implementations without a thread-safe mode ignore the call.
+    virtual void SetThreadSafe(bool threadSafe) {}
+
     //! Register TLM interface sends a registration request to TLMManager
     //! and returns the ID for the interface. '-1' is returned if
     //! the interface is not connected in the CompositeModel.
@@ -170,6 +177,13 @@ public:
     virtual void GetTimeData1D(int interfaceID, double time, TLMTimeData1D& DataOut) = 0;
     virtual void GetTimeData3D(int interfaceID, double time, TLMTimeData3D& DataOut) = 0;
 
+    //! GetExtrapolationStats returns how often the interface had to
+    //! extrapolate the received data, and the largest time error.
+    //! Implementations that do not count return empty statistics.
+    virtual void GetExtrapolationStats(int interfaceID, TLMExtrapolationStats& StatsOut) {
+        StatsOut = TLMExtrapolationStats();
+    }
+
     //! The static GetForce function is a pure function that uses
     //! parameters as defined for the GetForce function above.
     //! Additional parameters are obtained with GetConnectionParams & GetTimeData
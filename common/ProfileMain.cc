@@ -0,0 +1,233 @@
+//
+// File: ProfileMain.cc
+//
+// Reads the profile written by the TLM manager (-w option) and reports where the
+// co-simulation spends its time: how long each component computes and waits, how
+// long the manager takes to forward the messages, and the critical path that ends
+// in the bottleneck component.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdlib>
+
+using std::string;
+
+//! Profile of one component.
+struct ComponentInfo {
+    string Name;
+    double RunTime;
+    double WaitTime;
+    double ComputeTime;
+
+    ComponentInfo() : Name(), RunTime(0.0), WaitTime(0.0), ComputeTime(0.0) {}
+};
+
+//! Profile of one connected interface, i.e., of the link towards it.
+struct InterfaceInfo {
+    string Name;
+    string LinkedName;
+    int Component;
+    int LinkedComponent;
+    double WaitTime;
+    int NumWaits;
+    int NumMessages;
+    double SumResidence, MaxResidence;
+    double SumLatency, MaxLatency;
+
+    InterfaceInfo()
+        : Name(), LinkedName(), Component(-1), LinkedComponent(-1), WaitTime(0.0), NumWaits(0), NumMessages(0),
+          SumResidence(0.0), MaxResidence(0.0), SumLatency(0.0), MaxLatency(0.0) {}
+};
+
+static void Usage() {
+    std::cout << "Usage: tlmprofile <profile-file>\n";
+    std::cout << "Prints a critical path report of a profile written by tlmmanager -w\n";
+    std::cout << "or the profile option of omtlmsimulator.\n";
+}
+
+//! Split a line at the commas.
+static std::vector<string> SplitLine(const string& line) {
+    std::vector<string> fields;
+    std::stringstream ss(line);
+    string field;
+    while(std::getline(ss, field, ',')) {
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+//! The component part of component.interface.
+static string ComponentName(const string& name) {
+    return name.substr(0, name.find('.'));
+}
+
+//! Mean in milliseconds.
+static double MeanMs(double sum, int n) {
+    return (n > 0) ? 1000.0*sum/n : 0.0;
+}
+
+int main(int argc, char* argv[]) {
+    if(argc != 2) {
+        Usage();
+        exit(1);
+    }
+
+    std::ifstream inFile(argv[1]);
+    if(!inFile.good()) {
+        std::cerr << "Failed to open " << argv[1] << "\n";
+        exit(1);
+    }
+
+    double simTime = 0.0;
+    std::vector<ComponentInfo> components;
+    std::vector<InterfaceInfo> interfaces;
+    std::map<string, int> componentIndex;
+
+    string line;
+    while(std::getline(inFile, line)) {
+        if(line.empty() || line[0] == '#') continue;
+        std::vector<string> fields = SplitLine(line);
+
+        if(fields[0] == "simulation" && fields.size() >= 2) {
+            simTime = atof(fields[1].c_str());
+        }
+        else if(fields[0] == "component" && fields.size() >= 3) {
+            ComponentInfo comp;
+            comp.Name = fields[1];
+            comp.RunTime = atof(fields[2].c_str());
+            componentIndex[comp.Name] = int(components.size());
+            components.push_back(comp);
+        }
+        else if(fields[0] == "interface" && fields.size() >= 10) {
+            InterfaceInfo ifc;
+            ifc.Name = fields[1];
+            ifc.LinkedName = fields[2];
+            ifc.WaitTime = atof(fields[3].c_str());
+            ifc.NumWaits = atoi(fields[4].c_str());
+            ifc.NumMessages = atoi(fields[5].c_str());
+            ifc.SumResidence = atof(fields[6].c_str());
+            ifc.MaxResidence = atof(fields[7].c_str());
+            ifc.SumLatency = atof(fields[8].c_str());
+            ifc.MaxLatency = atof(fields[9].c_str());
+            interfaces.push_back(ifc);
+        }
+    }
+
+    if(components.empty()) {
+        std::cerr << argv[1] << " is not a valid profile file\n";
+        exit(1);
+    }
+
+    // Resolve the components and sum up their wait times.
+    for(size_t i = 0; i < interfaces.size(); i++) {
+        InterfaceInfo& ifc = interfaces[i];
+        std::map<string, int>::const_iterator it = componentIndex.find(ComponentName(ifc.Name));
+        if(it != componentIndex.end()) {
+            ifc.Component = it->second;
+            components[ifc.Component].WaitTime += ifc.WaitTime;
+        }
+        it = componentIndex.find(ComponentName(ifc.LinkedName));
+        if(it != componentIndex.end()) ifc.LinkedComponent = it->second;
+    }
+
+    // The bottleneck is the component that computes the longest,
+    // the others spend that time waiting for it.
+    int bottleneck = 0;
+    for(size_t i = 0; i < components.size(); i++) {
+        ComponentInfo& comp = components[i];
+        comp.ComputeTime = std::max(0.0, comp.RunTime - comp.WaitTime);
+        if(comp.ComputeTime > components[bottleneck].ComputeTime) bottleneck = int(i);
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Simulation wall time: " << simTime << " s\n\n";
+
+    std::cout << "Components:\n";
+    std::cout << std::setw(24) << std::left << "  name" << std::right
+              << std::setw(12) << "run [s]" << std::setw(12) << "wait [s]"
+              << std::setw(14) << "compute [s]" << std::setw(12) << "compute %" << "\n";
+    for(size_t i = 0; i < components.size(); i++) {
+        const ComponentInfo& comp = components[i];
+        double fraction = (comp.RunTime > 0.0) ? 100.0*comp.ComputeTime/comp.RunTime : 0.0;
+        std::cout << "  " << std::setw(22) << std::left << comp.Name << std::right
+                  << std::setw(12) << comp.RunTime << std::setw(12) << comp.WaitTime
+                  << std::setw(14) << comp.ComputeTime << std::setw(12) << fraction << "\n";
+    }
+
+    std::cout << "\nLinks (wait of the receiving component, forwarding by the manager):\n";
+    std::cout << std::setw(40) << std::left << "  from -> to" << std::right
+              << std::setw(10) << "wait [s]" << std::setw(9) << "waits" << std::setw(10) << "messages"
+              << std::setw(13) << "queue [ms]" << std::setw(11) << "max [ms]"
+              << std::setw(15) << "latency [ms]" << std::setw(11) << "max [ms]" << "\n";
+    for(size_t i = 0; i < interfaces.size(); i++) {
+        const InterfaceInfo& ifc = interfaces[i];
+        std::cout << "  " << std::setw(38) << std::left << (ifc.LinkedName + " -> " + ifc.Name) << std::right
+                  << std::setw(10) << ifc.WaitTime << std::setw(9) << ifc.NumWaits << std::setw(10) << ifc.NumMessages
+                  << std::setw(13) << MeanMs(ifc.SumResidence, ifc.NumMessages)
+                  << std::setw(11) << 1000.0*ifc.MaxResidence
+                  << std::setw(15) << MeanMs(ifc.SumLatency, ifc.NumMessages)
+                  << std::setw(11) << 1000.0*ifc.MaxLatency << "\n";
+    }
+
+    // Critical path: start at the component that waits the longest and follow
+    // the link it waits the most on to the component producing the data.
+    int current = 0;
+    for(size_t i = 0; i < components.size(); i++) {
+        if(components[i].WaitTime > components[current].WaitTime) current = int(i);
+    }
+
+    std::cout << "\nCritical path:\n";
+    std::vector<bool> visited(components.size(), false);
+    while(current != bottleneck && !visited[current]) {
+        visited[current] = true;
+
+        int worst = -1;
+        for(size_t i = 0; i < interfaces.size(); i++) {
+            const InterfaceInfo& ifc = interfaces[i];
+            if(ifc.Component != current || ifc.LinkedComponent < 0 || ifc.WaitTime <= 0.0) continue;
+            if(worst < 0 || ifc.WaitTime > interfaces[worst].WaitTime) worst = int(i);
+        }
+        if(worst < 0) break;
+
+        const InterfaceInfo& ifc = interfaces[worst];
+        std::cout << "  " << components[current].Name << " waits " << ifc.WaitTime << " s for "
+                  << ifc.LinkedName << " -> " << ifc.Name << "\n";
+        current = ifc.LinkedComponent;
+    }
+    const ComponentInfo& slowest = components[bottleneck];
+    std::cout << "  " << slowest.Name << " computes " << slowest.ComputeTime << " s\n";
+
+    // The bottleneck link is the one on which the others wait the longest for the bottleneck.
+    int link = -1;
+    for(size_t i = 0; i < interfaces.size(); i++) {
+        const InterfaceInfo& ifc = interfaces[i];
+        if(ifc.LinkedComponent != bottleneck || ifc.WaitTime <= 0.0) continue;
+        if(link < 0 || ifc.WaitTime > interfaces[link].WaitTime) link = int(i);
+    }
+    if(link < 0) {
+        for(size_t i = 0; i < interfaces.size(); i++) {
+            if(interfaces[i].WaitTime <= 0.0) continue;
+            if(link < 0 || interfaces[i].WaitTime > interfaces[link].WaitTime) link = int(i);
+        }
+    }
+
+    std::cout << "\nBottleneck component: " << slowest.Name << "\n";
+    if(link >= 0) {
+        const InterfaceInfo& ifc = interfaces[link];
+        double forwarding = (ifc.WaitTime > 0.0) ? 100.0*ifc.SumLatency/ifc.WaitTime : 0.0;
+        std::cout << "Bottleneck link: " << ifc.LinkedName << " -> " << ifc.Name
+                  << ", waited " << ifc.WaitTime << " s, manager forwarding " << ifc.SumLatency
+                  << " s (" << std::min(forwarding, 100.0) << "% of the wait)\n";
+    }
+    else {
+        std::cout << "Bottleneck link: none, no component waited for data\n";
+    }
+
+    return 0;
+}
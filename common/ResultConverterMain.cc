@@ -0,0 +1,166 @@
+//
+// File: ResultConverterMain.cc
+//
+// Converts binary (MATLAB v4) result files written by the TLM manager to CSV.
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using std::string;
+
+//! One matrix of a MAT v4 file.
+struct MatMatrix {
+    std::string Name;
+    int Type;
+    int Rows;
+    int Cols;
+    std::vector<char> Data;
+
+    MatMatrix() : Name(), Type(0), Rows(0), Cols(0), Data() {}
+};
+
+//! Swap the bytes of "n" items of "size" bytes each.
+static void SwapBytes(void* data, int size, size_t n) {
+    char* p = static_cast<char*>(data);
+    for(size_t i = 0; i < n; i++, p += size) {
+        for(int j = 0; j < size/2; j++) {
+            std::swap(p[j], p[size-1-j]);
+        }
+    }
+}
+
+static bool IsBigEndianSystem() {
+    int one = 1;
+    return *reinterpret_cast<char*>(&one) == 0;
+}
+
+//! Read the next matrix, returns false at end of file.
+static bool ReadMatrix(FILE* file, MatMatrix& mat) {
+    int header[5];
+    if(fread(header, sizeof(int), 5, file) != 5) return false;
+
+    // The M digit of the type is 0 for little endian and 1 for big endian data.
+    bool swap = false;
+    if(header[0] < 0 || header[0] > 9999) {
+        SwapBytes(header, sizeof(int), 5);
+        swap = true;
+    }
+    bool bigEndianData = (header[0]/1000 == 1);
+    if(bigEndianData != IsBigEndianSystem()) swap = true;
+
+    mat.Type = header[0] % 1000;
+    mat.Rows = header[1];
+    mat.Cols = header[2];
+
+    std::vector<char> name(header[4]);
+    if(fread(&name[0], 1, header[4], file) != size_t(header[4])) return false;
+    mat.Name = std::string(&name[0]);
+
+    int elemSize = 0;
+    switch((mat.Type / 10) % 10) {
+    case 0: elemSize = 8; break; // double
+    case 1: elemSize = 4; break; // float
+    case 2: elemSize = 4; break; // int32
+    case 3: elemSize = 2; break; // int16
+    case 4: elemSize = 2; break; // uint16
+    case 5: elemSize = 1; break; // uint8
+    default:
+        std::cerr << "Unsupported MAT v4 type " << header[0] << " for " << mat.Name << "\n";
+        return false;
+    }
+
+    size_t n = size_t(mat.Rows) * size_t(mat.Cols);
+    mat.Data.resize(n * elemSize);
+    if(n > 0 && fread(&mat.Data[0], elemSize, n, file) != n) return false;
+    if(swap && elemSize > 1) SwapBytes(&mat.Data[0], elemSize, n);
+
+    return true;
+}
+
+//! Get string "col" of a text matrix stored one string per column.
+static std::string GetString(const MatMatrix& mat, int col) {
+    std::string ret(&mat.Data[size_t(col)*mat.Rows], mat.Rows);
+    ret.resize(strlen(ret.c_str()));
+    return ret;
+}
+
+static void Usage() {
+    std::cout << "Usage: tlmresultconverter <result.mat> [<result.csv>]\n";
+    std::cout << "Converts a binary result file to CSV, the default output file\n";
+    std::cout << "has the same name with the .csv extension.\n";
+}
+
+int main(int argc, char* argv[]) {
+    if(argc < 2 || argc > 3) {
+        Usage();
+        exit(1);
+    }
+
+    string inFileName(argv[1]);
+    string outFileName;
+    if(argc == 3) {
+        outFileName = argv[2];
+    }
+    else {
+        string::size_type pos = inFileName.rfind(".mat");
+        outFileName = inFileName.substr(0, pos) + ".csv";
+    }
+
+    FILE* inFile = fopen(inFileName.c_str(), "rb");
+    if(inFile == NULL) {
+        std::cerr << "Failed to open " << inFileName << "\n";
+        exit(1);
+    }
+
+    MatMatrix names, descriptions, data;
+    MatMatrix mat;
+    while(ReadMatrix(inFile, mat)) {
+        if(mat.Name == "name") names = mat;
+        else if(mat.Name == "description") descriptions = mat;
+        else if(mat.Name == "data_2") data = mat;
+    }
+    fclose(inFile);
+
+    if(names.Cols == 0 || data.Name.empty() || data.Type != 0 || data.Rows != names.Cols) {
+        std::cerr << inFileName << " is not a valid result file\n";
+        exit(1);
+    }
+
+    std::ofstream outFile(outFileName.c_str());
+    if(!outFile.good()) {
+        std::cerr << "Failed to open " << outFileName << "\n";
+        exit(1);
+    }
+
+    // Header, the units are stored in the description.
+    for(int i = 0; i < names.Cols; i++) {
+        if(i > 0) outFile << ",";
+        outFile << "\"" << GetString(names, i);
+        if(descriptions.Cols > i && !GetString(descriptions, i).empty()) {
+            outFile << " " << GetString(descriptions, i);
+        }
+        outFile << "\"";
+    }
+    outFile << std::endl;
+
+    // data_2 is stored with one column per row of results.
+    const double* values = reinterpret_cast<const double*>(data.Data.empty() ? NULL : &data.Data[0]);
+    outFile.precision(17);
+    for(int row = 0; row < data.Cols; row++) {
+        for(int i = 0; i < data.Rows; i++) {
+            if(i > 0) outFile << ",";
+            outFile << values[size_t(row)*data.Rows + i];
+        }
+        outFile << "\n";
+    }
+
+    std::cout << "Converted " << data.Cols << " rows of " << data.Rows << " variables to " << outFileName << "\n";
+
+    return 0;
+}
@@ -0,0 +1,135 @@
+//
+// File: TelemetryMain.cc
+//
+// Prints the live telemetry that a running co-simulation publishes in shared memory.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include "Logging/TLMTelemetry.h"
+
+#ifdef _MSC_VER
+#include <windows.h>
+#include "mygetopt.h"
+#else
+#include <unistd.h>
+#include <getopt.h>
+#endif
+
+using std::string;
+
+static void usage() {
+    std::cout << "Usage: tlmtelemetry [-f] [-i <interval>] <segment>\n"
+                 "Prints the status and the latest values published by a simulation.\n"
+                 "-f            : follow, print all rows as CSV until the simulation is done\n"
+                 "-i <interval> : poll interval in milliseconds, default 100\n";
+    exit(1);
+}
+
+static void Wait(int ms) {
+#ifndef _MSC_VER
+    usleep(ms*1000); // micro seconds
+#else
+    Sleep(ms); // milli seconds
+#endif
+}
+
+static void PrintStatus(const TLMTelemetryStatusData& status) {
+    const char* statusStr[] = { "Starting", "Running", "Done" };
+    double progress = (status.NumSteps > 0) ? (100.0*status.Step)/status.NumSteps : 0.0;
+    double speed = (status.WallTime > 0) ? (status.SimTime-status.StartTime)/status.WallTime : 0.0;
+
+    std::cout << "Status    : " << statusStr[status.Status < 0 || status.Status > 2 ? 0 : status.Status] << "\n";
+    std::cout << "Sim. time : " << status.SimTime << " of " << status.EndTime << "\n";
+    std::cout << "Wall time : " << status.WallTime << " s (" << speed << " x real time)\n";
+    std::cout << "Step      : " << status.Step << " of " << status.NumSteps << "\n";
+    std::cout << "Progress  : " << progress << "%\n";
+}
+
+int main(int argc, char* argv[]) {
+    bool followFlg = false;
+    int interval = 100;
+    int c;
+    while((c = getopt(argc, argv, "fi:")) != -1) {
+        switch(c) {
+        case 'f':
+            followFlg = true;
+            break;
+        case 'i':
+            interval = atoi(optarg);
+            break;
+        default:
+            usage();
+            break;
+        }
+    }
+
+    if(optind >= argc) {
+        usage();
+    }
+    string segmentName(argv[optind]);
+
+    TLMTelemetryReader reader;
+    if(!followFlg) {
+        if(!reader.Open(segmentName)) {
+            std::cerr << "No telemetry published as " << segmentName << "\n";
+            exit(1);
+        }
+    }
+    else {
+        // Wait for the simulation to start.
+        while(!reader.Open(segmentName)) {
+            Wait(interval);
+        }
+    }
+
+    const std::vector<string>& names = reader.GetVariableNames();
+    std::vector<double> values;
+    TLMTelemetryStatusData status;
+
+    if(!followFlg) {
+        reader.ReadStatus(status);
+        PrintStatus(status);
+
+        uint64_t row;
+        if(reader.ReadLatest(values, row)) {
+            std::cout << "\nRow " << row << ":\n";
+            for(size_t i = 0; i < names.size(); i++) {
+                std::cout << "  " << names[i] << " = " << values[i] << "\n";
+            }
+        }
+        return 0;
+    }
+
+    // Follow mode, print the rows as CSV.
+    for(size_t i = 0; i < names.size(); i++) {
+        if(i > 0) std::cout << ",";
+        std::cout << "\"" << names[i] << "\"";
+    }
+    std::cout << std::endl;
+
+    uint64_t nextRow = 0;
+    for(;;) {
+        reader.ReadStatus(status);
+        uint64_t numRows = reader.GetNumRows();
+
+        for(; nextRow < numRows; nextRow++) {
+            if(!reader.ReadRow(nextRow, values)) {
+                std::cerr << "Row " << nextRow << " was overwritten, increase the poll rate.\n";
+                continue;
+            }
+            for(size_t i = 0; i < values.size(); i++) {
+                if(i > 0) std::cout << ",";
+                std::cout << values[i];
+            }
+            std::cout << "\n";
+        }
+        std::cout.flush();
+
+        if(status.Status == TelemetryDone && nextRow >= status.NumRows) break;
+        Wait(interval);
+    }
+
+    return 0;
+}
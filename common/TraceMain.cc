@@ -0,0 +1,230 @@
+//
+// File: TraceMain.cc
+//
+// Merges the trace files written by the TLM manager (-t option) and the
+// components into one Chrome trace JSON file, viewable in Perfetto
+// (ui.perfetto.dev) or chrome://tracing.
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "Logging/TLMTrace.h"
+
+#ifdef _MSC_VER
+#include <windows.h>
+#include "mygetopt.h"
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <getopt.h>
+#endif
+
+using std::string;
+
+//! The trace of one process.
+struct ProcessTrace {
+    TLMTraceFileHeader Header;
+    std::vector<string> ThreadNames;
+    std::vector<TLMTraceEvent> Events;
+};
+
+static void usage() {
+    std::cout << "Usage: tlmtrace [-o <json-file>] <trace-file or directory>...\n"
+                 "Merges the trace files written by tlmmanager -t or the trace option of\n"
+                 "omtlmsimulator into a Chrome trace JSON file, open it in ui.perfetto.dev.\n"
+                 "-o <json-file> : output file, default trace.json\n";
+    exit(1);
+}
+
+//! Check if the path ends with the trace file extension.
+static bool IsTraceFile(const string& path) {
+    const string ext = ".tlmtrace";
+    return path.size() > ext.size() && path.compare(path.size()-ext.size(), ext.size(), ext) == 0;
+}
+
+//! Add "path" or, if it is a directory, the trace files in it.
+static void AddTraceFiles(const string& path, std::vector<string>& files) {
+#ifdef _MSC_VER
+    DWORD attr = GetFileAttributesA(path.c_str());
+    if(attr != INVALID_FILE_ATTRIBUTES && (attr & FILE_ATTRIBUTE_DIRECTORY)) {
+        WIN32_FIND_DATAA data;
+        HANDLE hdl = FindFirstFileA((path + "\\*.tlmtrace").c_str(), &data);
+        if(hdl == INVALID_HANDLE_VALUE) return;
+        do {
+            files.push_back(path + "\\" + data.cFileName);
+        } while(FindNextFileA(hdl, &data));
+        FindClose(hdl);
+        return;
+    }
+#else
+    struct stat st;
+    if(stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        DIR* dir = opendir(path.c_str());
+        if(dir == NULL) return;
+        struct dirent* entry;
+        while((entry = readdir(dir)) != NULL) {
+            string name = entry->d_name;
+            if(IsTraceFile(name)) files.push_back(path + "/" + name);
+        }
+        closedir(dir);
+        std::sort(files.begin(), files.end());
+        return;
+    }
+#endif
+    files.push_back(path);
+}
+
+//! Read a trace file.
+static bool ReadTrace(const string& fileName, ProcessTrace& trace) {
+    std::ifstream file(fileName.c_str(), std::ios::binary);
+    if(!file.read((char*)&trace.Header, sizeof(trace.Header))) return false;
+    if(strncmp(trace.Header.Magic, "TLMTRACE", 8) != 0 || trace.Header.Version != 1) return false;
+    trace.Header.ProcessName[sizeof(trace.Header.ProcessName)-1] = '\0';
+
+    for(uint32_t i = 0; i < trace.Header.NumThreads; i++) {
+        char name[TLMTraceNameSize+1] = {0};
+        if(!file.read(name, TLMTraceNameSize)) return false;
+        trace.ThreadNames.push_back(name);
+    }
+
+    trace.Events.resize(size_t(trace.Header.NumEvents));
+    if(!trace.Events.empty()) {
+        file.read((char*)&trace.Events[0], trace.Events.size()*sizeof(TLMTraceEvent));
+        if(!file) return false;
+    }
+    return true;
+}
+
+//! Escape a string for JSON.
+static string Quote(const string& str) {
+    string ret = "\"";
+    for(size_t i = 0; i < str.size(); i++) {
+        if(str[i] == '"' || str[i] == '\\') ret += '\\';
+        if((unsigned char)str[i] >= 0x20) ret += str[i];
+    }
+    return ret + "\"";
+}
+
+static const char* MessageTypeName(int type) {
+    const char* names[] = { "unknown", "time data", "register component", "register interface",
+                            "check model", "abort", "register parameter", "close request", "close permission",
+                            "link statistics" };
+    return (type > 0 && type <= 9) ? names[type] : names[0];
+}
+
+int main(int argc, char* argv[]) {
+    string outFileName = "trace.json";
+    int c;
+    while((c = getopt(argc, argv, "o:")) != -1) {
+        switch(c) {
+        case 'o':
+            outFileName = optarg;
+            break;
+        default:
+            usage();
+            break;
+        }
+    }
+
+    if(optind >= argc) {
+        usage();
+    }
+
+    std::vector<string> files;
+    for(int i = optind; i < argc; i++) {
+        AddTraceFiles(argv[i], files);
+    }
+
+    std::vector<ProcessTrace> traces;
+    for(size_t i = 0; i < files.size(); i++) {
+        ProcessTrace trace;
+        if(!ReadTrace(files[i], trace)) {
+            std::cerr << "Skipping " << files[i] << ", not a valid trace file\n";
+            continue;
+        }
+        if(trace.Header.NumDropped > 0) {
+            std::cerr << files[i] << ": " << trace.Header.NumDropped << " events were dropped\n";
+        }
+        traces.push_back(trace);
+    }
+
+    if(traces.empty()) {
+        std::cerr << "No trace files found\n";
+        exit(1);
+    }
+
+    // The clocks are synchronized through the wall clock time of each trace
+    // origin, the merged timeline starts at the earliest one.
+    double origin = traces[0].Header.Origin;
+    for(size_t i = 1; i < traces.size(); i++) {
+        origin = std::min(origin, traces[i].Header.Origin);
+    }
+
+    std::ofstream out(outFileName.c_str());
+    if(!out.good()) {
+        std::cerr << "Failed to open " << outFileName << "\n";
+        exit(1);
+    }
+
+    const char* eventNames[NumTraceEventTypes] = {
+        "registration", "register interface", "check model", "send",
+        "receive", "wait for data", "solver step", "await close" };
+    const char* categories[NumTraceEventTypes] = {
+        "startup", "startup", "startup", "comm", "comm", "wait", "solver", "shutdown" };
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    size_t numEvents = 0;
+    bool first = true;
+    for(size_t p = 0; p < traces.size(); p++) {
+        const ProcessTrace& trace = traces[p];
+
+        // Process IDs of different hosts may collide, the trace index is used instead.
+        int pid = int(p) + 1;
+        string processName = string(trace.Header.ProcessName) + " (pid " + std::to_string(trace.Header.ProcessID) + ")";
+
+        if(!first) out << ",\n";
+        first = false;
+        out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+            << ",\"tid\":0,\"args\":{\"name\":" << Quote(processName) << "}}";
+        for(size_t t = 0; t < trace.ThreadNames.size(); t++) {
+            out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << t
+                << ",\"args\":{\"name\":" << Quote(trace.ThreadNames[t]) << "}}";
+        }
+
+        double offset = trace.Header.Origin - origin;
+        for(size_t i = 0; i < trace.Events.size(); i++) {
+            const TLMTraceEvent& event = trace.Events[i];
+            if(event.Type >= NumTraceEventTypes) continue;
+
+            out << ",\n{\"name\":\"" << eventNames[event.Type] << "\",\"cat\":\"" << categories[event.Type]
+                << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << int(event.Thread)
+                << ",\"ts\":" << 1.0e6*(offset + event.Start) << ",\"dur\":" << 1.0e6*event.Duration
+                << ",\"args\":{";
+
+            bool firstArg = true;
+            if(event.Interface >= 0) {
+                out << "\"interface\":" << event.Interface;
+                firstArg = false;
+            }
+            if(event.Type == TraceSend || event.Type == TraceReceive) {
+                out << (firstArg ? "" : ",") << "\"message\":\"" << MessageTypeName(event.Detail) << "\"";
+            }
+            else if(event.Type == TraceWaitData || event.Type == TraceSolverStep) {
+                out << (firstArg ? "" : ",") << "\"time\":" << std::setprecision(9) << event.Time << std::setprecision(3);
+            }
+            out << "}}";
+            numEvents++;
+        }
+    }
+    out << "\n]}\n";
+
+    std::cout << "Wrote " << numEvents << " events of " << traces.size() << " processes to " << outFileName << "\n";
+    return 0;
+}